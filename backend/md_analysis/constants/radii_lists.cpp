@@ -37,6 +37,20 @@ const std::unordered_map<std::string, int> RadiiLists::ATOMIC_NUMBERS = {
     {"Fe", 26}, {"Mg", 12}
 };
 
+const std::unordered_map<std::string, double> RadiiLists::ATOMIC_MASSES = {
+    {"H", 1.008}, {"C", 12.011}, {"N", 14.007}, {"O", 15.999},
+    {"F", 18.998}, {"P", 30.974}, {"S", 32.06}, {"Cl", 35.45},
+    {"Br", 79.904}, {"I", 126.904}, {"Si", 28.085}, {"Se", 78.971},
+    {"As", 74.922}, {"B", 10.81}, {"Li", 6.94}, {"Na", 22.990},
+    {"K", 39.098}, {"Ca", 40.078}, {"Zn", 65.38}, {"Cu", 63.546},
+    {"Fe", 55.845}, {"Mg", 24.305}
+};
+
+const std::unordered_map<std::string, double> RadiiLists::GB_SCREENING_SCALES = {
+    {"H", 0.85}, {"C", 0.72}, {"N", 0.79}, {"O", 0.85},
+    {"F", 0.88}, {"P", 0.86}, {"S", 0.96}
+};
+
 double RadiiLists::getVdwRadius(const std::string& element) {
     auto it = VDW_RADII.find(element);
     if (it == VDW_RADII.end()) {
@@ -69,6 +83,19 @@ int RadiiLists::getAtomicNumber(const std::string& element) {
     return it->second;
 }
 
+double RadiiLists::getAtomicMass(const std::string& element) {
+    auto it = ATOMIC_MASSES.find(element);
+    if (it == ATOMIC_MASSES.end()) {
+        throw std::runtime_error("Element '" + element + "' not found in atomic masses table");
+    }
+    return it->second;
+}
+
+double RadiiLists::getGbScreeningScale(const std::string& element) {
+    auto it = GB_SCREENING_SCALES.find(element);
+    return it == GB_SCREENING_SCALES.end() ? 0.8 : it->second;
+}
+
 bool RadiiLists::hasElement(const std::string& element) {
     return VDW_RADII.find(element) != VDW_RADII.end();
 }
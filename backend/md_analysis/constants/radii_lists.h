@@ -15,6 +15,11 @@ public:
     
     static const std::unordered_map<std::string, int> ATOMIC_NUMBERS;
     
+    static const std::unordered_map<std::string, double> ATOMIC_MASSES;
+
+    // Hawkins-Cramer-Truhlar screening scales for Generalized Born radii.
+    static const std::unordered_map<std::string, double> GB_SCREENING_SCALES;
+    
     static double getVdwRadius(const std::string& element);
     
     static double getCovalentRadius(const std::string& element);
@@ -23,5 +28,10 @@ public:
     
     static int getAtomicNumber(const std::string& element);
     
+    static double getAtomicMass(const std::string& element);
+
+    // 0.8 for elements without a fitted scale.
+    static double getGbScreeningScale(const std::string& element);
+    
     static bool hasElement(const std::string& element);
 };
@@ -0,0 +1,421 @@
+#include "trajectory_analysis.h"
+#include "cell_list.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace {
+
+// Calls function(thread, begin, end) for contiguous chunks of
+// [0, numItems), the first chunk on the calling thread. Exceptions thrown
+// by any chunk are rethrown here after all threads have finished.
+template <typename Function>
+void runChunks(int numItems, int numThreads, Function function) {
+    int threads = numThreads > 0 ? numThreads : static_cast<int>(std::thread::hardware_concurrency());
+    threads = std::max(1, std::min(threads, numItems));
+
+    std::vector<std::exception_ptr> errors(threads);
+    auto runChunk = [&](int thread) {
+        int begin = static_cast<int>(static_cast<long long>(numItems) * thread / threads);
+        int end = static_cast<int>(static_cast<long long>(numItems) * (thread + 1) / threads);
+        try {
+            function(thread, begin, end);
+        } catch (...) {
+            errors[thread] = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (int thread = 1; thread < threads; ++thread) {
+        workers.emplace_back(runChunk, thread);
+    }
+    runChunk(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+void checkFrames(const FrameBlock& frames) {
+    if (frames.numFrames < 0 || frames.numAtoms < 0 ||
+        (frames.data == nullptr && frames.numFrames > 0 && frames.numAtoms > 0)) {
+        throw std::runtime_error("Invalid frame block");
+    }
+}
+
+// Weighted centroid of one structure.
+std::array<double, 3> centroid(const double* coordinates, const double* weights,
+                               int numAtoms, double totalWeight) {
+    std::array<double, 3> center = {0.0, 0.0, 0.0};
+    for (int i = 0; i < numAtoms; ++i) {
+        double w = weights ? weights[i] : 1.0;
+        center[0] += w * coordinates[3 * i];
+        center[1] += w * coordinates[3 * i + 1];
+        center[2] += w * coordinates[3 * i + 2];
+    }
+    for (double& c : center) {
+        c /= totalWeight;
+    }
+    return center;
+}
+
+// Largest eigenvalue of the 4x4 quaternion key matrix built from the
+// cross-covariance S, found by Newton iteration on its characteristic
+// polynomial starting from the upper bound (G_a + G_b) / 2
+// (Theobald, Acta Cryst. A61, 478 (2005)).
+double qcpMaxEigenvalue(const double S[9], double upperBound) {
+    const double Sxx = S[0], Sxy = S[1], Sxz = S[2];
+    const double Syx = S[3], Syy = S[4], Syz = S[5];
+    const double Szx = S[6], Szy = S[7], Szz = S[8];
+
+    const double Sxx2 = Sxx * Sxx, Syy2 = Syy * Syy, Szz2 = Szz * Szz;
+    const double Sxy2 = Sxy * Sxy, Syz2 = Syz * Syz, Sxz2 = Sxz * Sxz;
+    const double Syx2 = Syx * Syx, Szy2 = Szy * Szy, Szx2 = Szx * Szx;
+
+    const double SyzSzymSyySzz2 = 2.0 * (Syz * Szy - Syy * Szz);
+    const double Sxx2Syy2Szz2Syz2Szy2 = Syy2 + Szz2 - Sxx2 + Syz2 + Szy2;
+    const double Sxy2Sxz2Syx2Szx2 = Sxy2 + Sxz2 - Syx2 - Szx2;
+
+    const double SxzpSzx = Sxz + Szx, SyzpSzy = Syz + Szy, SxypSyx = Sxy + Syx;
+    const double SyzmSzy = Syz - Szy, SxzmSzx = Sxz - Szx, SxymSyx = Sxy - Syx;
+    const double SxxpSyy = Sxx + Syy, SxxmSyy = Sxx - Syy;
+
+    const double c2 = -2.0 * (Sxx2 + Syy2 + Szz2 + Sxy2 + Syx2 + Sxz2 + Szx2 + Syz2 + Szy2);
+    const double c1 = 8.0 * (Sxx * Syz * Szy + Syy * Szx * Sxz + Szz * Sxy * Syx) -
+                      8.0 * (Sxx * Syy * Szz + Syz * Szx * Sxy + Szy * Syx * Sxz);
+    const double c0 =
+        Sxy2Sxz2Syx2Szx2 * Sxy2Sxz2Syx2Szx2 +
+        (Sxx2Syy2Szz2Syz2Szy2 + SyzSzymSyySzz2) * (Sxx2Syy2Szz2Syz2Szy2 - SyzSzymSyySzz2) +
+        (-SxzpSzx * SyzmSzy + SxymSyx * (SxxmSyy - Szz)) *
+            (-SxzmSzx * SyzpSzy + SxymSyx * (SxxmSyy + Szz)) +
+        (-SxzpSzx * SyzpSzy - SxypSyx * (SxxpSyy - Szz)) *
+            (-SxzmSzx * SyzmSzy - SxypSyx * (SxxpSyy + Szz)) +
+        (SxypSyx * SyzpSzy + SxzpSzx * (SxxmSyy + Szz)) *
+            (-SxymSyx * SyzmSzy + SxzpSzx * (SxxpSyy + Szz)) +
+        (SxypSyx * SyzmSzy + SxzmSzx * (SxxmSyy - Szz)) *
+            (-SxymSyx * SyzpSzy + SxzmSzx * (SxxpSyy - Szz));
+
+    double lambda = upperBound;
+    for (int iteration = 0; iteration < 50; ++iteration) {
+        const double previous = lambda;
+        const double x2 = lambda * lambda;
+        const double b = (x2 + c2) * lambda;
+        const double a = b + c1;
+        const double denominator = 2.0 * x2 * lambda + b + a;
+        if (denominator == 0.0) {
+            break;
+        }
+        lambda -= (a * lambda + c0) / denominator;
+        if (std::abs(lambda - previous) <= 1e-11 * std::abs(lambda)) {
+            break;
+        }
+    }
+    return lambda;
+}
+
+std::vector<double> frameKineticEnergy(
+    const FrameBlock& velocities,
+    const std::vector<double>& masses,
+    int numThreads) {
+
+    checkFrames(velocities);
+    if (masses.size() != static_cast<size_t>(velocities.numAtoms)) {
+        throw std::runtime_error("Expected one mass per atom");
+    }
+
+    std::vector<double> result(velocities.numFrames, 0.0);
+    runChunks(velocities.numFrames, numThreads, [&](int, int begin, int end) {
+        for (int f = begin; f < end; ++f) {
+            const double* v = velocities.frame(f);
+            double kinetic = 0.0;
+            for (int i = 0; i < velocities.numAtoms; ++i) {
+                double v2 = v[3 * i] * v[3 * i] + v[3 * i + 1] * v[3 * i + 1] + v[3 * i + 2] * v[3 * i + 2];
+                kinetic += 0.5 * masses[i] * v2;
+            }
+            result[f] = kinetic / ACCELERATION_CONVERSION;
+        }
+    });
+    return result;
+}
+
+}  // namespace
+
+std::vector<double> TrajectoryAnalysis::rmsd(
+    const FrameBlock& frames,
+    const double* reference,
+    const std::vector<double>& weights,
+    int numThreads) {
+
+    checkFrames(frames);
+    const int numAtoms = frames.numAtoms;
+    if (!weights.empty() && weights.size() != static_cast<size_t>(numAtoms)) {
+        throw std::runtime_error("Expected one weight per atom");
+    }
+
+    const double* w = weights.empty() ? nullptr : weights.data();
+    double totalWeight = numAtoms;
+    if (w) {
+        totalWeight = 0.0;
+        for (double value : weights) {
+            if (value < 0.0) {
+                throw std::runtime_error("RMSD weights must not be negative");
+            }
+            totalWeight += value;
+        }
+    }
+    if (totalWeight <= 0.0) {
+        throw std::runtime_error("RMSD needs at least one atom with positive weight");
+    }
+
+    const std::array<double, 3> referenceCenter = centroid(reference, w, numAtoms, totalWeight);
+    double referenceG = 0.0;
+    for (int i = 0; i < numAtoms; ++i) {
+        double weight = w ? w[i] : 1.0;
+        for (int d = 0; d < 3; ++d) {
+            double r = reference[3 * i + d] - referenceCenter[d];
+            referenceG += weight * r * r;
+        }
+    }
+
+    std::vector<double> result(frames.numFrames, 0.0);
+    runChunks(frames.numFrames, numThreads, [&](int, int begin, int end) {
+        for (int f = begin; f < end; ++f) {
+            const double* coordinates = frames.frame(f);
+            const std::array<double, 3> center = centroid(coordinates, w, numAtoms, totalWeight);
+
+            double S[9] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+            double frameG = 0.0;
+            for (int i = 0; i < numAtoms; ++i) {
+                double weight = w ? w[i] : 1.0;
+                double a[3], b[3];
+                for (int d = 0; d < 3; ++d) {
+                    a[d] = coordinates[3 * i + d] - center[d];
+                    b[d] = reference[3 * i + d] - referenceCenter[d];
+                }
+                frameG += weight * (a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+                for (int p = 0; p < 3; ++p) {
+                    for (int q = 0; q < 3; ++q) {
+                        S[3 * p + q] += weight * a[p] * b[q];
+                    }
+                }
+            }
+
+            const double upperBound = 0.5 * (frameG + referenceG);
+            const double lambda = qcpMaxEigenvalue(S, upperBound);
+            result[f] = std::sqrt(std::max(0.0, 2.0 * (upperBound - lambda) / totalWeight));
+        }
+    });
+    return result;
+}
+
+RadialDistribution TrajectoryAnalysis::radialDistribution(
+    const FrameBlock& frames,
+    const std::array<double, 3>& boxLength,
+    double maxDistance,
+    int numBins,
+    const std::vector<int>& selectionA,
+    const std::vector<int>& selectionB,
+    int numThreads) {
+
+    checkFrames(frames);
+    const int numAtoms = frames.numAtoms;
+    if (boxLength[0] <= 0.0 || boxLength[1] <= 0.0 || boxLength[2] <= 0.0) {
+        throw std::runtime_error("Radial distribution needs a periodic box");
+    }
+    const double shortestEdge = std::min({boxLength[0], boxLength[1], boxLength[2]});
+    if (maxDistance <= 0.0 || maxDistance > 0.5 * shortestEdge) {
+        throw std::runtime_error("Radial distribution range must lie between 0 and half the shortest box edge");
+    }
+    if (numBins < 1) {
+        throw std::runtime_error("Radial distribution needs at least one bin");
+    }
+
+    auto makeMask = [numAtoms](const std::vector<int>& selection) {
+        std::vector<uint8_t> mask(numAtoms, selection.empty() ? 1 : 0);
+        for (int atomId : selection) {
+            if (atomId < 0 || atomId >= numAtoms) {
+                throw std::runtime_error("Atom index " + std::to_string(atomId) + " out of range");
+            }
+            mask[atomId] = 1;
+        }
+        return mask;
+    };
+    const std::vector<uint8_t> inA = makeMask(selectionA);
+    const std::vector<uint8_t> inB = makeMask(selectionB);
+
+    double countA = 0.0, countB = 0.0, countBoth = 0.0;
+    for (int i = 0; i < numAtoms; ++i) {
+        countA += inA[i];
+        countB += inB[i];
+        countBoth += inA[i] & inB[i];
+    }
+    const double orderedPairs = countA * countB - countBoth;
+    if (orderedPairs <= 0.0) {
+        throw std::runtime_error("Radial distribution selections contain no distinct pairs");
+    }
+
+    const double maxDistance2 = maxDistance * maxDistance;
+    const double binsPerDistance = numBins / maxDistance;
+
+    int threads = numThreads > 0 ? numThreads : static_cast<int>(std::thread::hardware_concurrency());
+    threads = std::max(1, std::min(threads, frames.numFrames));
+    std::vector<std::vector<uint64_t>> histograms(threads, std::vector<uint64_t>(numBins, 0));
+
+    runChunks(frames.numFrames, threads, [&](int thread, int begin, int end) {
+        std::vector<uint64_t>& histogram = histograms[thread];
+        std::vector<double> x(numAtoms), y(numAtoms), z(numAtoms);
+        const PositionArrays<double> positions = {x.data(), y.data(), z.data(), static_cast<size_t>(numAtoms)};
+        CellList cellList;
+
+        // Locals rather than references, so the histogram stores do not
+        // force the coordinates and box to be reloaded.
+        const double* px = x.data();
+        const double* py = y.data();
+        const double* pz = z.data();
+        const uint8_t* maskA = inA.data();
+        const uint8_t* maskB = inB.data();
+        uint64_t* bins = histogram.data();
+        const double lx = boxLength[0], ly = boxLength[1], lz = boxLength[2];
+        const double hx = 0.5 * lx, hy = 0.5 * ly, hz = 0.5 * lz;
+
+        auto addPair = [=](int i, int j) {
+            // Coordinates are wrapped into the box, so one shift suffices.
+            double dx = px[i] - px[j];
+            double dy = py[i] - py[j];
+            double dz = pz[i] - pz[j];
+            dx += dx > hx ? -lx : (dx < -hx ? lx : 0.0);
+            dy += dy > hy ? -ly : (dy < -hy ? ly : 0.0);
+            dz += dz > hz ? -lz : (dz < -hz ? lz : 0.0);
+
+            double r2 = dx * dx + dy * dy + dz * dz;
+            if (r2 < maxDistance2) {
+                int bin = std::min(static_cast<int>(std::sqrt(r2) * binsPerDistance), numBins - 1);
+                bins[bin] += maskA[i] * maskB[j] + maskA[j] * maskB[i];
+            }
+        };
+
+        for (int f = begin; f < end; ++f) {
+            const double* coordinates = frames.frame(f);
+            for (int i = 0; i < numAtoms; ++i) {
+                x[i] = coordinates[3 * i] - boxLength[0] * std::floor(coordinates[3 * i] / boxLength[0]);
+                y[i] = coordinates[3 * i + 1] - boxLength[1] * std::floor(coordinates[3 * i + 1] / boxLength[1]);
+                z[i] = coordinates[3 * i + 2] - boxLength[2] * std::floor(coordinates[3 * i + 2] / boxLength[2]);
+            }
+
+            cellList.build(positions, boxLength, maxDistance);
+            if (cellList.supportsNeighborSearch()) {
+                const std::vector<int>& cellOffsets = cellList.getCellOffsets();
+                const std::vector<int>& cellAtoms = cellList.getCellAtoms();
+                std::array<int, 27> neighborCells;
+
+                for (int i = 0; i < numAtoms; ++i) {
+                    int numNeighborCells = cellList.getNeighborCells(cellList.getCellOfAtom(i), neighborCells);
+                    for (int c = 0; c < numNeighborCells; ++c) {
+                        int cell = neighborCells[c];
+                        for (int n = cellOffsets[cell]; n < cellOffsets[cell + 1]; ++n) {
+                            int j = cellAtoms[n];
+                            if (j > i) addPair(i, j);
+                        }
+                    }
+                }
+            } else {
+                for (int i = 0; i < numAtoms; ++i) {
+                    for (int j = i + 1; j < numAtoms; ++j) {
+                        addPair(i, j);
+                    }
+                }
+            }
+        }
+    });
+
+    RadialDistribution result;
+    result.radius.resize(numBins);
+    result.g.assign(numBins, 0.0);
+
+    const double pi = std::acos(-1.0);
+    const double volume = boxLength[0] * boxLength[1] * boxLength[2];
+    const double binWidth = maxDistance / numBins;
+    for (int k = 0; k < numBins; ++k) {
+        uint64_t count = 0;
+        for (const auto& histogram : histograms) {
+            count += histogram[k];
+        }
+
+        double inner = k * binWidth;
+        double outer = (k + 1) * binWidth;
+        double shellVolume = 4.0 / 3.0 * pi * (outer * outer * outer - inner * inner * inner);
+        double idealCount = frames.numFrames * orderedPairs * shellVolume / volume;
+
+        result.radius[k] = inner + 0.5 * binWidth;
+        result.g[k] = idealCount > 0.0 ? count / idealCount : 0.0;
+    }
+    return result;
+}
+
+std::vector<double> TrajectoryAnalysis::kineticEnergy(
+    const FrameBlock& velocities,
+    const std::vector<double>& masses,
+    int numThreads) {
+
+    return frameKineticEnergy(velocities, masses, numThreads);
+}
+
+std::vector<double> TrajectoryAnalysis::temperature(
+    const FrameBlock& velocities,
+    const std::vector<double>& masses,
+    int degreesOfFreedom,
+    int numThreads) {
+
+    const int dof = degreesOfFreedom > 0 ? degreesOfFreedom : 3 * velocities.numAtoms;
+    std::vector<double> result = frameKineticEnergy(velocities, masses, numThreads);
+    if (dof > 0) {
+        for (double& value : result) {
+            value = 2.0 * value / (dof * BOLTZMANN_CONSTANT);
+        }
+    }
+    return result;
+}
+
+std::vector<SystemEnergy> TrajectoryAnalysis::frameEnergies(
+    const System& system,
+    const FrameBlock& frames,
+    int numThreads) {
+
+    checkFrames(frames);
+    if (static_cast<size_t>(frames.numAtoms) != system.getNumAtoms()) {
+        throw std::runtime_error("Frames have " + std::to_string(frames.numAtoms) +
+                                 " atoms, the system has " + std::to_string(system.getNumAtoms()));
+    }
+
+    std::vector<SystemEnergy> result(frames.numFrames, SystemEnergy{});
+    runChunks(frames.numFrames, numThreads, [&](int, int begin, int end) {
+        System local = system;
+        ParticleArrays& particles = local.getParticles();
+        std::fill(particles.vx.begin(), particles.vx.end(), 0.0);
+        std::fill(particles.vy.begin(), particles.vy.end(), 0.0);
+        std::fill(particles.vz.begin(), particles.vz.end(), 0.0);
+
+        for (int f = begin; f < end; ++f) {
+            const double* coordinates = frames.frame(f);
+            for (size_t i = 0; i < particles.size(); ++i) {
+                const double* position = coordinates + 3 * static_cast<size_t>(particles.originalId[i]);
+                particles.x[i] = position[0];
+                particles.y[i] = position[1];
+                particles.z[i] = position[2];
+            }
+            local.markPositionsChanged();
+            result[f] = local.computeForces();
+        }
+    });
+    return result;
+}
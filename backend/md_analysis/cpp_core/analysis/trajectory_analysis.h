@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+#include "system.h"
+
+// numFrames frames of numAtoms (x, y, z) triples, row-major and frame after
+// frame, with atoms in insertion order like the arrays exchanged with
+// Python and SimulationSnapshot::positions.
+struct FrameBlock {
+    const double* data;
+    int numFrames;
+    int numAtoms;
+
+    const double* frame(int index) const {
+        return data + 3 * static_cast<size_t>(index) * numAtoms;
+    }
+};
+
+struct RadialDistribution {
+    std::vector<double> radius;
+    std::vector<double> g;
+};
+
+// Per-frame analysis over a block of frames. Frames are split into
+// contiguous chunks, one per thread; numThreads <= 0 uses every hardware
+// thread. Each result holds one value per frame, in frame order, and does
+// not depend on the number of threads.
+class TrajectoryAnalysis {
+public:
+
+    // RMSD to the reference after optimal superposition, found with the
+    // quaternion characteristic polynomial (QCP) method. Weights, if given,
+    // hold one non-negative value per atom; zero weights exclude atoms.
+    static std::vector<double> rmsd(
+        const FrameBlock& frames,
+        const double* reference,
+        const std::vector<double>& weights = {},
+        int numThreads = 0);
+
+    // g(r) of ordered pairs (a, b), a in selectionA and b in selectionB,
+    // a != b, averaged over all frames of a periodic box. Empty selections
+    // mean every atom. Pairs are found with a CellList per frame;
+    // maxDistance may not exceed half the shortest box edge.
+    static RadialDistribution radialDistribution(
+        const FrameBlock& frames,
+        const std::array<double, 3>& boxLength,
+        double maxDistance,
+        int numBins = 200,
+        const std::vector<int>& selectionA = {},
+        const std::vector<int>& selectionB = {},
+        int numThreads = 0);
+
+    // Kinetic energy in kcal/mol of velocity frames in Angstrom/fs.
+    static std::vector<double> kineticEnergy(
+        const FrameBlock& velocities,
+        const std::vector<double>& masses,
+        int numThreads = 0);
+
+    // Instantaneous temperature 2 KE / (degreesOfFreedom k_B);
+    // degreesOfFreedom <= 0 means 3N.
+    static std::vector<double> temperature(
+        const FrameBlock& velocities,
+        const std::vector<double>& masses,
+        int degreesOfFreedom = 0,
+        int numThreads = 0);
+
+    // Bonded and nonbonded energy of each position frame with the
+    // topology, parameters and box of system, which is not modified. Each
+    // thread evaluates a private copy; kinetic energy is left at zero.
+    static std::vector<SystemEnergy> frameEnergies(
+        const System& system,
+        const FrameBlock& frames,
+        int numThreads = 0);
+};
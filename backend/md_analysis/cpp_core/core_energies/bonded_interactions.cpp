@@ -2,97 +2,129 @@
 #include <cmath>
 #include <stdexcept>
 
-const double PI = 3.14159265358979323846;
-
-double BondedInteractions::calculateBondEnergy(
-    double currentLength,
-    double equilibriumLength,
-    double forceConstant) {
-    
-    double delta = currentLength - equilibriumLength;
-    return 0.5 * forceConstant * delta * delta;
+template <typename Real>
+Real BasicBondedInteractions<Real>::calculateBondEnergy(
+    Real currentLength,
+    Real equilibriumLength,
+    Real forceConstant) {
+    
+    Real delta = currentLength - equilibriumLength;
+    return Real(0.5) * forceConstant * delta * delta;
 }
 
-double BondedInteractions::calculateBondForce(
-    double currentLength,
-    double equilibriumLength,
-    double forceConstant) {
+template <typename Real>
+Real BasicBondedInteractions<Real>::calculateBondForce(
+    Real currentLength,
+    Real equilibriumLength,
+    Real forceConstant) {
     
-    double delta = currentLength - equilibriumLength;
+    Real delta = currentLength - equilibriumLength;
     return forceConstant * delta;
 }
 
-double BondedInteractions::calculateAngleEnergy(
-    double currentAngle,
-    double equilibriumAngle,
-    double forceConstant) {
-    
-    double delta = currentAngle - equilibriumAngle;
-    return 0.5 * forceConstant * delta * delta;
+template <typename Real>
+Real BasicBondedInteractions<Real>::calculateAngleEnergy(
+    Real currentAngle,
+    Real equilibriumAngle,
+    Real forceConstant) {
+    
+    Real delta = currentAngle - equilibriumAngle;
+    return Real(0.5) * forceConstant * delta * delta;
 }
 
-double BondedInteractions::calculateAngleTorque(
-    double currentAngle,
-    double equilibriumAngle,
-    double forceConstant) {
+template <typename Real>
+Real BasicBondedInteractions<Real>::calculateAngleTorque(
+    Real currentAngle,
+    Real equilibriumAngle,
+    Real forceConstant) {
     
-    double delta = currentAngle - equilibriumAngle;
+    Real delta = currentAngle - equilibriumAngle;
     return forceConstant * delta;
 }
 
-double BondedInteractions::calculateDihedralEnergy(
-    double currentDihedral,
-    double periodicity,
-    double barrierHeight,
-    double phaseOffset) {
-    
-    return barrierHeight * (1.0 + std::cos(periodicity * currentDihedral - phaseOffset));
+template <typename Real>
+Real BasicBondedInteractions<Real>::calculateDihedralEnergy(
+    Real currentDihedral,
+    Real periodicity,
+    Real barrierHeight,
+    Real phaseOffset) {
+    
+    return barrierHeight * (Real(1.0) + std::cos(periodicity * currentDihedral - phaseOffset));
 }
 
-double BondedInteractions::calculateDihedralTorque(
-    double currentDihedral,
-    double periodicity,
-    double barrierHeight,
-    double phaseOffset) {
+template <typename Real>
+Real BasicBondedInteractions<Real>::calculateDihedralTorque(
+    Real currentDihedral,
+    Real periodicity,
+    Real barrierHeight,
+    Real phaseOffset) {
     
     return -periodicity * barrierHeight * std::sin(periodicity * currentDihedral - phaseOffset);
 }
 
-double BondedInteractions::calculateImproperEnergy(
-    double currentDihedral,
-    double forceConstant) {
+// The deviation is wrapped into [-pi, pi] so the harmonic well stays
+// continuous when the improper crosses the +/-pi branch cut.
+template <typename Real>
+static Real wrappedImproperDelta(Real currentImproper, Real equilibriumAngle) {
+    const Real pi = Real(3.14159265358979323846);
+    Real delta = currentImproper - equilibriumAngle;
+    if (delta > pi) {
+        delta -= Real(2.0) * pi;
+    } else if (delta < -pi) {
+        delta += Real(2.0) * pi;
+    }
+    return delta;
+}
+
+template <typename Real>
+Real BasicBondedInteractions<Real>::calculateImproperEnergy(
+    Real currentImproper,
+    Real equilibriumAngle,
+    Real forceConstant) {
+    
+    Real delta = wrappedImproperDelta(currentImproper, equilibriumAngle);
+    return Real(0.5) * forceConstant * delta * delta;
+}
+
+template <typename Real>
+Real BasicBondedInteractions<Real>::calculateImproperTorque(
+    Real currentImproper,
+    Real equilibriumAngle,
+    Real forceConstant) {
     
-    return 0.5 * forceConstant * currentDihedral * currentDihedral;
+    return forceConstant * wrappedImproperDelta(currentImproper, equilibriumAngle);
 }
 
-double BondedInteractions::calculateBondLength(
-    const std::array<double, 3>& pos1,
-    const std::array<double, 3>& pos2) {
+template <typename Real>
+Real BasicBondedInteractions<Real>::calculateBondLength(
+    const std::array<Real, 3>& pos1,
+    const std::array<Real, 3>& pos2) {
     
-    double dx = pos1[0] - pos2[0];
-    double dy = pos1[1] - pos2[1];
-    double dz = pos1[2] - pos2[2];
+    Real dx = pos1[0] - pos2[0];
+    Real dy = pos1[1] - pos2[1];
+    Real dz = pos1[2] - pos2[2];
     
     return std::sqrt(dx * dx + dy * dy + dz * dz);
 }
 
-double BondedInteractions::calculateAngle(
-    const std::array<double, 3>& pos1,
-    const std::array<double, 3>& pos2,
-    const std::array<double, 3>& pos3) {
+template <typename Real>
+Real BasicBondedInteractions<Real>::calculateAngle(
+    const std::array<Real, 3>& pos1,
+    const std::array<Real, 3>& pos2,
+    const std::array<Real, 3>& pos3) {
     
-    double v1x = pos1[0] - pos2[0];
-    double v1y = pos1[1] - pos2[1];
-    double v1z = pos1[2] - pos2[2];
+    Real v1x = pos1[0] - pos2[0];
+    Real v1y = pos1[1] - pos2[1];
+    Real v1z = pos1[2] - pos2[2];
     
-    double v2x = pos3[0] - pos2[0];
-    double v2y = pos3[1] - pos2[1];
-    double v2z = pos3[2] - pos2[2];
+    Real v2x = pos3[0] - pos2[0];
+    Real v2y = pos3[1] - pos2[1];
+    Real v2z = pos3[2] - pos2[2];
     
-    double v1_len = std::sqrt(v1x * v1x + v1y * v1y + v1z * v1z);
-    double v2_len = std::sqrt(v2x * v2x + v2y * v2y + v2z * v2z);
+    Real v1_len = std::sqrt(v1x * v1x + v1y * v1y + v1z * v1z);
+    Real v2_len = std::sqrt(v2x * v2x + v2y * v2y + v2z * v2z);
     
-    if (v1_len < 1e-10 || v2_len < 1e-10) {
+    if (v1_len < Real(1e-10) || v2_len < Real(1e-10)) {
         throw std::runtime_error("Collinear atoms in angle calculation");
     }
     
@@ -104,43 +136,44 @@ double BondedInteractions::calculateAngle(
     v2y /= v2_len;
     v2z /= v2_len;
 
-    double dotProduct = v1x * v2x + v1y * v2y + v1z * v2z;   
-    dotProduct = (dotProduct < -1.0) ? -1.0 : (dotProduct > 1.0) ? 1.0 : dotProduct;
+    Real dotProduct = v1x * v2x + v1y * v2y + v1z * v2z;   
+    dotProduct = (dotProduct < Real(-1.0)) ? Real(-1.0) : (dotProduct > Real(1.0)) ? Real(1.0) : dotProduct;
     
     return std::acos(dotProduct);
 }
 
-double BondedInteractions::calculateDihedral(
-    const std::array<double, 3>& pos1,
-    const std::array<double, 3>& pos2,
-    const std::array<double, 3>& pos3,
-    const std::array<double, 3>& pos4) {
-    
-    double v1x = pos1[0] - pos2[0];
-    double v1y = pos1[1] - pos2[1];
-    double v1z = pos1[2] - pos2[2];
-    
-    double v2x = pos3[0] - pos2[0];
-    double v2y = pos3[1] - pos2[1];
-    double v2z = pos3[2] - pos2[2];
-    
-    double v3x = pos4[0] - pos3[0];
-    double v3y = pos4[1] - pos3[1];
-    double v3z = pos4[2] - pos3[2];
-    
-    double n1x = v1y * v2z - v1z * v2y;
-    double n1y = v1z * v2x - v1x * v2z;
-    double n1z = v1x * v2y - v1y * v2x;
-    
-    double n2x = v2y * v3z - v2z * v3y;
-    double n2y = v2z * v3x - v2x * v3z;
-    double n2z = v2x * v3y - v2y * v3x;
-    
-    double n1_len = std::sqrt(n1x * n1x + n1y * n1y + n1z * n1z);
-    double n2_len = std::sqrt(n2x * n2x + n2y * n2y + n2z * n2z);
-    
-    if (n1_len < 1e-10 || n2_len < 1e-10) {
-        return 0.0;
+template <typename Real>
+Real BasicBondedInteractions<Real>::calculateDihedral(
+    const std::array<Real, 3>& pos1,
+    const std::array<Real, 3>& pos2,
+    const std::array<Real, 3>& pos3,
+    const std::array<Real, 3>& pos4) {
+    
+    Real v1x = pos1[0] - pos2[0];
+    Real v1y = pos1[1] - pos2[1];
+    Real v1z = pos1[2] - pos2[2];
+    
+    Real v2x = pos3[0] - pos2[0];
+    Real v2y = pos3[1] - pos2[1];
+    Real v2z = pos3[2] - pos2[2];
+    
+    Real v3x = pos4[0] - pos3[0];
+    Real v3y = pos4[1] - pos3[1];
+    Real v3z = pos4[2] - pos3[2];
+    
+    Real n1x = v1y * v2z - v1z * v2y;
+    Real n1y = v1z * v2x - v1x * v2z;
+    Real n1z = v1x * v2y - v1y * v2x;
+    
+    Real n2x = v2y * v3z - v2z * v3y;
+    Real n2y = v2z * v3x - v2x * v3z;
+    Real n2z = v2x * v3y - v2y * v3x;
+    
+    Real n1_len = std::sqrt(n1x * n1x + n1y * n1y + n1z * n1z);
+    Real n2_len = std::sqrt(n2x * n2x + n2y * n2y + n2z * n2z);
+    
+    if (n1_len < Real(1e-10) || n2_len < Real(1e-10)) {
+        return Real(0.0);
     }
     
     n1x /= n1_len;
@@ -151,16 +184,16 @@ double BondedInteractions::calculateDihedral(
     n2y /= n2_len;
     n2z /= n2_len;
     
-    double dotProduct = n1x * n2x + n1y * n2y + n1z * n2z;
-    dotProduct = (dotProduct < -1.0) ? -1.0 : (dotProduct > 1.0) ? 1.0 : dotProduct;
+    Real dotProduct = n1x * n2x + n1y * n2y + n1z * n2z;
+    dotProduct = (dotProduct < Real(-1.0)) ? Real(-1.0) : (dotProduct > Real(1.0)) ? Real(1.0) : dotProduct;
     
-    double angle = std::acos(dotProduct);
+    Real angle = std::acos(dotProduct);
     
-    double signx = n1y * n2z - n1z * n2y;
-    double signy = n1z * n2x - n1x * n2z;
-    double signz = n1x * n2y - n1y * n2x;
+    Real signx = n1y * n2z - n1z * n2y;
+    Real signy = n1z * n2x - n1x * n2z;
+    Real signz = n1x * n2y - n1y * n2x;
     
-    double sign = v2x * signx + v2y * signy + v2z * signz;
+    Real sign = v2x * signx + v2y * signy + v2z * signz;
     if (sign < 0) {
         angle = -angle;
     }
@@ -168,16 +201,31 @@ double BondedInteractions::calculateDihedral(
     return angle;
 }
 
-BondedInteractions::BondedEnergy BondedInteractions::calculateTotalBondedEnergy(
+template <typename Real>
+Real BasicBondedInteractions<Real>::calculateImproper(
+    const std::array<Real, 3>& pos1,
+    const std::array<Real, 3>& pos2,
+    const std::array<Real, 3>& pos3,
+    const std::array<Real, 3>& pos4) {
+    
+    // calculateDihedral measures from trans; impropers use the IUPAC angle.
+    const Real pi = Real(3.14159265358979323846);
+    Real angle = calculateDihedral(pos1, pos2, pos3, pos4);
+    return (angle > 0) ? angle - pi : angle + pi;
+}
+
+template <typename Real>
+typename BasicBondedInteractions<Real>::BondedEnergy BasicBondedInteractions<Real>::calculateTotalBondedEnergy(
     const std::vector<BondData>& bonds,
     const std::vector<AngleData>& angles,
     const std::vector<DihedralData>& dihedrals,
-    const std::vector<std::array<double, 3>>& positions) {
+    const std::vector<std::array<Real, 3>>& positions,
+    const std::vector<ImproperData>& impropers) {
     
-    BondedEnergy totalEnergy = {0.0, 0.0, 0.0, 0.0, 0.0};
+    BondedEnergy totalEnergy = {0, 0, 0, 0, 0};
     
     for (const auto& bond : bonds) {
-        double length = calculateBondLength(
+        Real length = calculateBondLength(
             positions[bond.atom1Id],
             positions[bond.atom2Id]);
         totalEnergy.bondEnergy += calculateBondEnergy(
@@ -187,7 +235,7 @@ BondedInteractions::BondedEnergy BondedInteractions::calculateTotalBondedEnergy(
     }
     
     for (const auto& angle : angles) {
-        double angleRad = calculateAngle(
+        Real angleRad = calculateAngle(
             positions[angle.atom1Id],
             positions[angle.atom2Id],
             positions[angle.atom3Id]);
@@ -198,7 +246,7 @@ BondedInteractions::BondedEnergy BondedInteractions::calculateTotalBondedEnergy(
     }
     
     for (const auto& dihedral : dihedrals) {
-        double dihedralAngle = calculateDihedral(
+        Real dihedralAngle = calculateDihedral(
             positions[dihedral.atom1Id],
             positions[dihedral.atom2Id],
             positions[dihedral.atom3Id],
@@ -210,6 +258,18 @@ BondedInteractions::BondedEnergy BondedInteractions::calculateTotalBondedEnergy(
             dihedral.phaseOffset);
     }
     
+    for (const auto& improper : impropers) {
+        Real improperAngle = calculateImproper(
+            positions[improper.atom1Id],
+            positions[improper.atom2Id],
+            positions[improper.atom3Id],
+            positions[improper.atom4Id]);
+        totalEnergy.improperEnergy += calculateImproperEnergy(
+            improperAngle,
+            improper.equilibriumAngle,
+            improper.forceConstant);
+    }
+    
     totalEnergy.total = totalEnergy.bondEnergy + 
                        totalEnergy.angleEnergy + 
                        totalEnergy.dihedralEnergy + 
@@ -217,3 +277,6 @@ BondedInteractions::BondedEnergy BondedInteractions::calculateTotalBondedEnergy(
     
     return totalEnergy;
 }
+
+template class BasicBondedInteractions<float>;
+template class BasicBondedInteractions<double>;
@@ -32,71 +32,98 @@ struct DihedralData {
     double phaseOffset;
 };
 
-class BondedInteractions {
+// Harmonic improper torsion; atom1 is the central atom. The angle is the
+// IUPAC dihedral of atoms 1-2-3-4, so a planar center sits at 0.
+struct ImproperData {
+    int atom1Id;
+    int atom2Id;
+    int atom3Id;
+    int atom4Id;
+    double equilibriumAngle;
+    double forceConstant;
+};
+
+template <typename Real>
+class BasicBondedInteractions {
 public:
 
-    static double calculateBondForces(
-        double currentLength,
-        double equilibriumLength,
-        double forceConstant);
+    static Real calculateBondEnergy(
+        Real currentLength,
+        Real equilibriumLength,
+        Real forceConstant);
+    
+    static Real calculateBondForce(
+        Real currentLength,
+        Real equilibriumLength,
+        Real forceConstant);
     
-    static double calculateBondForce(
-        double currentLength,
-        double equilibriumLength,
-        double forceConstant);
+    static Real calculateAngleEnergy(
+        Real currentAngle,
+        Real equilibriumAngle,
+        Real forceConstant);
     
-    static double calculateAngleEnergy(
-        double currentAngle,
-        double equilibriumAngle,
-        double forceConstant);
+    static Real calculateAngleTorque(
+        Real currentAngle,
+        Real equilibriumAngle,
+        Real forceConstant);
     
-    static double calculateAngleTorque(
-        double currentAngle,
-        double equilibriumAngle,
-        double forceConstant);
+    static Real calculateDihedralEnergy(
+        Real currentDihedral,
+        Real periodicity,
+        Real barrierHeight,
+        Real phaseOffset);
     
-    static double calculateDihedralEnergy(
-        double currentDihedral,
-        double periodicity,
-        double barrierHeight,
-        double phaseOffset);
+    static Real calculateDihedralTorque(
+        Real currentDihedral,
+        Real periodicity,
+        Real barrierHeight,
+        Real phaseOffset);
     
-    static double calculateDihedralTorque(
-        double currentDihedral,
-        double periodicity,
-        double barrierHeight,
-        double phaseOffset);
+    static Real calculateImproperEnergy(
+        Real currentImproper,
+        Real equilibriumAngle,
+        Real forceConstant);
     
-    static double calculateImproperEnergy(
-        double currentDihedral,
-        double forceConstant);
+    static Real calculateImproperTorque(
+        Real currentImproper,
+        Real equilibriumAngle,
+        Real forceConstant);
     
-    static double calculateBondLength(
-        const std::array<double, 3>& pos1,
-        const std::array<double, 3>& pos2);
+    static Real calculateBondLength(
+        const std::array<Real, 3>& pos1,
+        const std::array<Real, 3>& pos2);
     
-    static double calculateAngle(
-        const sd::array<double, 3>& pos1,
-        const std::array<double, 3>& pos2,
-        const std::array<double, 3>& pos3);
+    static Real calculateAngle(
+        const std::array<Real, 3>& pos1,
+        const std::array<Real, 3>& pos2,
+        const std::array<Real, 3>& pos3);
     
-    static double calculateDihedral(
-        const std::array<double, 3>& pos1,
-        const std::array<double, 3>& pos2,
-        const std::array<double, 3>& pos3,
-        const std::array<double, 3>& pos4);
+    static Real calculateDihedral(
+        const std::array<Real, 3>& pos1,
+        const std::array<Real, 3>& pos2,
+        const std::array<Real, 3>& pos3,
+        const std::array<Real, 3>& pos4);
+    
+    static Real calculateImproper(
+        const std::array<Real, 3>& pos1,
+        const std::array<Real, 3>& pos2,
+        const std::array<Real, 3>& pos3,
+        const std::array<Real, 3>& pos4);
     
     struct BondedEnergy {
-        double bondEnergy;
-        double angleEnergy;
-        double dihedralEnergy;
-        double improperEnergy;
-        double total;
+        Real bondEnergy;
+        Real angleEnergy;
+        Real dihedralEnergy;
+        Real improperEnergy;
+        Real total;
     };
     
     static BondedEnergy calculateTotalBondedEnergy(
         const std::vector<BondData>& bonds,
         const std::vector<AngleData>& angles,
         const std::vector<DihedralData>& dihedrals,
-        const std::vector<std::array<double, 3>>& positions);
+        const std::vector<std::array<Real, 3>>& positions,
+        const std::vector<ImproperData>& impropers = std::vector<ImproperData>());
 };
+
+using BondedInteractions = BasicBondedInteractions<double>;
@@ -0,0 +1,138 @@
+#include "cell_list.h"
+#include "allocation_counter.h"
+#include <algorithm>
+#include <cmath>
+
+void CellList::build(
+    const PositionArrays<double>& positions,
+    const std::array<double, 3>& boxLength,
+    double minCellSize) {
+
+    const int numAtoms = static_cast<int>(positions.count);
+    const double* coordinates[3] = {positions.x, positions.y, positions.z};
+    periodic = boxLength[0] > 0.0 && boxLength[1] > 0.0 && boxLength[2] > 0.0;
+    double extents[3];
+
+    for (int d = 0; d < 3; ++d) {
+        double extent;
+        if (periodic) {
+            origin[d] = 0.0;
+            extent = boxLength[d];
+        } else {
+            double low = 0.0;
+            double high = 0.0;
+            if (numAtoms > 0) {
+                auto range = std::minmax_element(coordinates[d], coordinates[d] + numAtoms);
+                low = *range.first;
+                high = *range.second;
+            }
+            origin[d] = low;
+            extent = high - low;
+        }
+
+        extents[d] = extent;
+        dimensions[d] = std::max(1, static_cast<int>(std::floor(extent / minCellSize)));
+    }
+
+    // Sparse open systems would otherwise get far more cells than atoms.
+    const double maxCells = std::max(27.0, 2.0 * numAtoms);
+    const double totalCells = static_cast<double>(dimensions[0]) * dimensions[1] * dimensions[2];
+    if (totalCells > maxCells) {
+        double scale = std::cbrt(maxCells / totalCells);
+        for (int d = 0; d < 3; ++d) {
+            dimensions[d] = std::max(1, static_cast<int>(dimensions[d] * scale));
+        }
+    }
+
+    for (int d = 0; d < 3; ++d) {
+        inverseCellSize[d] = extents[d] > 0.0 ? dimensions[d] / extents[d] : 0.0;
+    }
+
+    const int numCells = getNumCells();
+    const size_t atomCellCapacity = atomCell.capacity();
+    const size_t offsetsCapacity = cellOffsets.capacity();
+    const size_t cellAtomsCapacity = cellAtoms.capacity();
+
+    atomCell.resize(numAtoms);
+    cellOffsets.assign(numCells + 1, 0);
+    cellAtoms.resize(numAtoms);
+
+    for (int i = 0; i < numAtoms; ++i) {
+        int index[3];
+        for (int d = 0; d < 3; ++d) {
+            int c = static_cast<int>(std::floor((coordinates[d][i] - origin[d]) * inverseCellSize[d]));
+            if (periodic) {
+                c %= dimensions[d];
+                if (c < 0) c += dimensions[d];
+            } else {
+                c = std::max(0, std::min(c, dimensions[d] - 1));
+            }
+            index[d] = c;
+        }
+        int cell = (index[0] * dimensions[1] + index[1]) * dimensions[2] + index[2];
+        atomCell[i] = cell;
+        cellOffsets[cell + 1]++;
+    }
+
+    for (int c = 0; c < numCells; ++c) {
+        cellOffsets[c + 1] += cellOffsets[c];
+    }
+
+    // Filling back to front from the end of each cell leaves every cell
+    // listing its atoms in increasing index order, and leaves
+    // cellOffsets[c + 1] pointing at the start of cell c.
+    for (int i = numAtoms - 1; i >= 0; --i) {
+        cellAtoms[--cellOffsets[atomCell[i] + 1]] = i;
+    }
+    for (int c = 0; c < numCells; ++c) {
+        cellOffsets[c] = cellOffsets[c + 1];
+    }
+    cellOffsets[numCells] = numAtoms;
+
+    AllocationCounter::recordGrowth(atomCell, atomCellCapacity);
+    AllocationCounter::recordGrowth(cellOffsets, offsetsCapacity);
+    AllocationCounter::recordGrowth(cellAtoms, cellAtomsCapacity);
+}
+
+bool CellList::supportsNeighborSearch() const {
+    if (!periodic) return true;
+    return dimensions[0] >= 3 && dimensions[1] >= 3 && dimensions[2] >= 3;
+}
+
+int CellList::getNeighborCells(int cell, std::array<int, 27>& neighbors) const {
+    const int cx = cell / (dimensions[1] * dimensions[2]);
+    const int cy = (cell / dimensions[2]) % dimensions[1];
+    const int cz = cell % dimensions[2];
+    int count = 0;
+
+    for (int dx = -1; dx <= 1; ++dx) {
+        int nx = cx + dx;
+        if (periodic) {
+            nx = (nx + dimensions[0]) % dimensions[0];
+        } else if (nx < 0 || nx >= dimensions[0]) {
+            continue;
+        }
+
+        for (int dy = -1; dy <= 1; ++dy) {
+            int ny = cy + dy;
+            if (periodic) {
+                ny = (ny + dimensions[1]) % dimensions[1];
+            } else if (ny < 0 || ny >= dimensions[1]) {
+                continue;
+            }
+
+            for (int dz = -1; dz <= 1; ++dz) {
+                int nz = cz + dz;
+                if (periodic) {
+                    nz = (nz + dimensions[2]) % dimensions[2];
+                } else if (nz < 0 || nz >= dimensions[2]) {
+                    continue;
+                }
+
+                neighbors[count++] = (nx * dimensions[1] + ny) * dimensions[2] + nz;
+            }
+        }
+    }
+
+    return count;
+}
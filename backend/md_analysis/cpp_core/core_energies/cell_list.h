@@ -0,0 +1,43 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include "precision.h"
+
+// Uniform grid binning atoms into cells at least minCellSize wide.
+// Atoms of cell c are cellAtoms[cellOffsets[c]] .. cellAtoms[cellOffsets[c + 1] - 1].
+class CellList {
+public:
+
+    void build(
+        const PositionArrays<double>& positions,
+        const std::array<double, 3>& boxLength,
+        double minCellSize);
+
+    const std::array<int, 3>& getDimensions() const { return dimensions; }
+
+    int getNumCells() const { return dimensions[0] * dimensions[1] * dimensions[2]; }
+
+    bool isPeriodic() const { return periodic; }
+
+    // Periodic grids with fewer than three cells along an axis would visit
+    // the same neighbor cell twice, so callers fall back to all pairs.
+    bool supportsNeighborSearch() const;
+
+    int getCellOfAtom(int atomId) const { return atomCell[atomId]; }
+
+    const std::vector<int>& getCellOffsets() const { return cellOffsets; }
+
+    const std::vector<int>& getCellAtoms() const { return cellAtoms; }
+
+    int getNeighborCells(int cell, std::array<int, 27>& neighbors) const;
+
+private:
+    std::array<int, 3> dimensions = {1, 1, 1};
+    std::array<double, 3> origin = {0.0, 0.0, 0.0};
+    std::array<double, 3> inverseCellSize = {0.0, 0.0, 0.0};
+    bool periodic = false;
+    std::vector<int> atomCell;
+    std::vector<int> cellOffsets;
+    std::vector<int> cellAtoms;
+};
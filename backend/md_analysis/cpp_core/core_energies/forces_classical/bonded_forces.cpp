@@ -0,0 +1,264 @@
+#include "bonded_forces.h"
+#include <array>
+#include <cmath>
+
+template <typename Real, typename Accum>
+Accum BasicBondedForces<Real, Accum>::computeBondForces(
+    const std::vector<BondData>& bonds,
+    const PositionArrays<Real>& positions,
+    ForceArrays<Accum>& forces) {
+
+    Accum energy = 0;
+
+    for (const auto& bond : bonds) {
+        const int i = bond.atom1Id;
+        const int j = bond.atom2Id;
+
+        Real dx = positions.x[i] - positions.x[j];
+        Real dy = positions.y[i] - positions.y[j];
+        Real dz = positions.z[i] - positions.z[j];
+        Real r = std::sqrt(dx * dx + dy * dy + dz * dz);
+
+        Real equilibriumLength = static_cast<Real>(bond.equilibriumLength);
+        Real forceConstant = static_cast<Real>(bond.forceConstant);
+        energy += BasicBondedInteractions<Real>::calculateBondEnergy(r, equilibriumLength, forceConstant);
+
+        if (r < Real(1e-10)) continue;
+
+        Real dUdr = BasicBondedInteractions<Real>::calculateBondForce(r, equilibriumLength, forceConstant);
+        Real scale = -dUdr / r;
+
+        forces.x[i] += scale * dx;
+        forces.y[i] += scale * dy;
+        forces.z[i] += scale * dz;
+        forces.x[j] -= scale * dx;
+        forces.y[j] -= scale * dy;
+        forces.z[j] -= scale * dz;
+    }
+
+    return energy;
+}
+
+template <typename Real, typename Accum>
+Accum BasicBondedForces<Real, Accum>::computeAngleForces(
+    const std::vector<AngleData>& angles,
+    const PositionArrays<Real>& positions,
+    ForceArrays<Accum>& forces) {
+
+    Accum energy = 0;
+
+    for (const auto& angle : angles) {
+        const int i = angle.atom1Id;
+        const int j = angle.atom2Id;
+        const int k = angle.atom3Id;
+
+        Real ux = positions.x[i] - positions.x[j];
+        Real uy = positions.y[i] - positions.y[j];
+        Real uz = positions.z[i] - positions.z[j];
+
+        Real vx = positions.x[k] - positions.x[j];
+        Real vy = positions.y[k] - positions.y[j];
+        Real vz = positions.z[k] - positions.z[j];
+
+        Real u2 = ux * ux + uy * uy + uz * uz;
+        Real v2 = vx * vx + vy * vy + vz * vz;
+        if (u2 < Real(1e-20) || v2 < Real(1e-20)) continue;
+
+        Real invUV = Real(1.0) / std::sqrt(u2 * v2);
+        Real cosTheta = (ux * vx + uy * vy + uz * vz) * invUV;
+        cosTheta = (cosTheta < Real(-1.0)) ? Real(-1.0) : (cosTheta > Real(1.0)) ? Real(1.0) : cosTheta;
+        Real theta = std::acos(cosTheta);
+
+        Real equilibriumAngle = static_cast<Real>(angle.equilibriumAngle);
+        Real forceConstant = static_cast<Real>(angle.forceConstant);
+        energy += BasicBondedInteractions<Real>::calculateAngleEnergy(theta, equilibriumAngle, forceConstant);
+
+        Real sinTheta = std::sqrt(Real(1.0) - cosTheta * cosTheta);
+        if (sinTheta < Real(1e-6)) continue;
+
+        Real dUdTheta = BasicBondedInteractions<Real>::calculateAngleTorque(theta, equilibriumAngle, forceConstant);
+        Real prefactor = dUdTheta / sinTheta;
+        Real cosOverU2 = cosTheta / u2;
+        Real cosOverV2 = cosTheta / v2;
+
+        Real f1x = prefactor * (vx * invUV - cosOverU2 * ux);
+        Real f1y = prefactor * (vy * invUV - cosOverU2 * uy);
+        Real f1z = prefactor * (vz * invUV - cosOverU2 * uz);
+
+        Real f3x = prefactor * (ux * invUV - cosOverV2 * vx);
+        Real f3y = prefactor * (uy * invUV - cosOverV2 * vy);
+        Real f3z = prefactor * (uz * invUV - cosOverV2 * vz);
+
+        forces.x[i] += f1x;
+        forces.y[i] += f1y;
+        forces.z[i] += f1z;
+        forces.x[k] += f3x;
+        forces.y[k] += f3y;
+        forces.z[k] += f3z;
+        forces.x[j] -= f1x + f3x;
+        forces.y[j] -= f1y + f3y;
+        forces.z[j] -= f1z + f3z;
+    }
+
+    return energy;
+}
+
+// Shared torsion geometry for proper and improper terms. termEnergy receives
+// the IUPAC dihedral of i-j-k-l and returns {energy, dU/dphi}.
+template <typename Real, typename Accum, typename TermEnergy>
+static Accum accumulateTorsion(
+    int i, int j, int k, int l,
+    const PositionArrays<Real>& positions,
+    ForceArrays<Accum>& forces,
+    TermEnergy termEnergy) {
+
+    Real ijx = positions.x[i] - positions.x[j];
+    Real ijy = positions.y[i] - positions.y[j];
+    Real ijz = positions.z[i] - positions.z[j];
+
+    Real kjx = positions.x[k] - positions.x[j];
+    Real kjy = positions.y[k] - positions.y[j];
+    Real kjz = positions.z[k] - positions.z[j];
+
+    Real klx = positions.x[k] - positions.x[l];
+    Real kly = positions.y[k] - positions.y[l];
+    Real klz = positions.z[k] - positions.z[l];
+
+    Real mx = ijy * kjz - ijz * kjy;
+    Real my = ijz * kjx - ijx * kjz;
+    Real mz = ijx * kjy - ijy * kjx;
+
+    Real nx = kjy * klz - kjz * kly;
+    Real ny = kjz * klx - kjx * klz;
+    Real nz = kjx * kly - kjy * klx;
+
+    Real m2 = mx * mx + my * my + mz * mz;
+    Real n2 = nx * nx + ny * ny + nz * nz;
+    Real kj2 = kjx * kjx + kjy * kjy + kjz * kjz;
+    if (m2 < Real(1e-20) || n2 < Real(1e-20) || kj2 < Real(1e-20)) return Accum(0);
+
+    Real kjLength = std::sqrt(kj2);
+    Real phi = std::atan2(kjLength * (ijx * nx + ijy * ny + ijz * nz),
+                          mx * nx + my * ny + mz * nz);
+
+    const std::array<Real, 2> term = termEnergy(phi);
+    const Real dUdPhi = term[1];
+
+    Real scaleI = -dUdPhi * kjLength / m2;
+    Real scaleL = dUdPhi * kjLength / n2;
+
+    Real fix = scaleI * mx;
+    Real fiy = scaleI * my;
+    Real fiz = scaleI * mz;
+
+    Real flx = scaleL * nx;
+    Real fly = scaleL * ny;
+    Real flz = scaleL * nz;
+
+    Real p = (ijx * kjx + ijy * kjy + ijz * kjz) / kj2;
+    Real q = (klx * kjx + kly * kjy + klz * kjz) / kj2;
+
+    Real sx = p * fix - q * flx;
+    Real sy = p * fiy - q * fly;
+    Real sz = p * fiz - q * flz;
+
+    forces.x[i] += fix;
+    forces.y[i] += fiy;
+    forces.z[i] += fiz;
+    forces.x[j] += sx - fix;
+    forces.y[j] += sy - fiy;
+    forces.z[j] += sz - fiz;
+    forces.x[k] -= sx + flx;
+    forces.y[k] -= sy + fly;
+    forces.z[k] -= sz + flz;
+    forces.x[l] += flx;
+    forces.y[l] += fly;
+    forces.z[l] += flz;
+
+    return term[0];
+}
+
+template <typename Real, typename Accum>
+Accum BasicBondedForces<Real, Accum>::computeDihedralForces(
+    const std::vector<DihedralData>& dihedrals,
+    const PositionArrays<Real>& positions,
+    ForceArrays<Accum>& forces) {
+
+    const Real pi = Real(3.14159265358979323846);
+    Accum energy = 0;
+
+    for (const auto& dihedral : dihedrals) {
+        const Real periodicity = static_cast<Real>(dihedral.periodicity);
+        const Real barrierHeight = static_cast<Real>(dihedral.barrierHeight);
+        const Real phaseOffset = static_cast<Real>(dihedral.phaseOffset);
+
+        energy += accumulateTorsion(
+            dihedral.atom1Id, dihedral.atom2Id, dihedral.atom3Id, dihedral.atom4Id,
+            positions, forces, [&](Real phi) {
+                // calculateDihedral measures from the trans conformation, which is
+                // the IUPAC angle shifted by pi; the gradient is the same for both.
+                phi = (phi > 0) ? phi - pi : phi + pi;
+                return std::array<Real, 2>{
+                    BasicBondedInteractions<Real>::calculateDihedralEnergy(
+                        phi, periodicity, barrierHeight, phaseOffset),
+                    BasicBondedInteractions<Real>::calculateDihedralTorque(
+                        phi, periodicity, barrierHeight, phaseOffset)};
+            });
+    }
+
+    return energy;
+}
+
+template <typename Real, typename Accum>
+Accum BasicBondedForces<Real, Accum>::computeImproperForces(
+    const std::vector<ImproperData>& impropers,
+    const PositionArrays<Real>& positions,
+    ForceArrays<Accum>& forces) {
+
+    Accum energy = 0;
+
+    for (const auto& improper : impropers) {
+        const Real equilibriumAngle = static_cast<Real>(improper.equilibriumAngle);
+        const Real forceConstant = static_cast<Real>(improper.forceConstant);
+
+        energy += accumulateTorsion(
+            improper.atom1Id, improper.atom2Id, improper.atom3Id, improper.atom4Id,
+            positions, forces, [&](Real phi) {
+                return std::array<Real, 2>{
+                    BasicBondedInteractions<Real>::calculateImproperEnergy(
+                        phi, equilibriumAngle, forceConstant),
+                    BasicBondedInteractions<Real>::calculateImproperTorque(
+                        phi, equilibriumAngle, forceConstant)};
+            });
+    }
+
+    return energy;
+}
+
+template <typename Real, typename Accum>
+BondedInteractions::BondedEnergy BasicBondedForces<Real, Accum>::computeBondedForces(
+    const std::vector<BondData>& bonds,
+    const std::vector<AngleData>& angles,
+    const std::vector<DihedralData>& dihedrals,
+    const std::vector<ImproperData>& impropers,
+    const PositionArrays<Real>& positions,
+    ForceArrays<Accum>& forces) {
+
+    BondedInteractions::BondedEnergy energy = {0.0, 0.0, 0.0, 0.0, 0.0};
+
+    energy.bondEnergy = computeBondForces(bonds, positions, forces);
+    energy.angleEnergy = computeAngleForces(angles, positions, forces);
+    energy.dihedralEnergy = computeDihedralForces(dihedrals, positions, forces);
+    energy.improperEnergy = computeImproperForces(impropers, positions, forces);
+
+    energy.total = energy.bondEnergy +
+                   energy.angleEnergy +
+                   energy.dihedralEnergy +
+                   energy.improperEnergy;
+
+    return energy;
+}
+
+template class BasicBondedForces<double, double>;
+template class BasicBondedForces<float, float>;
+template class BasicBondedForces<float, double>;
@@ -0,0 +1,330 @@
+#include "generalized_born.h"
+#include "nonbond_interactions.h"
+#include "scratch_arena.h"
+#include "work_stealing_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <thread>
+
+namespace {
+
+// Each sweep splits the atoms into contiguous chunks of at least this many
+// atoms, at most MAX_CHUNKS of them, with one set of accumulators per chunk.
+constexpr int MIN_ATOMS_PER_CHUNK = 1024;
+constexpr int MAX_CHUNKS = 16;
+
+// Pool of the calling thread, kept across force evaluations; nullptr when
+// the sweeps run serially.
+WorkStealingPool* poolForThread(int numThreads) {
+    thread_local std::unique_ptr<WorkStealingPool> pool;
+    if (numThreads <= 1) {
+        return nullptr;
+    }
+    if (!pool || pool->getNumThreads() != numThreads) {
+        pool = std::make_unique<WorkStealingPool>(numThreads);
+    }
+    return pool.get();
+}
+
+// Runs function(chunk, begin, end) over numChunks contiguous ranges of
+// [0, numAtoms) on pool, or serially without one.
+template <typename Function>
+void runChunks(WorkStealingPool* pool, int numAtoms, int numChunks, Function function) {
+    auto runChunk = [&](int chunk) {
+        int begin = static_cast<int>(static_cast<long long>(numAtoms) * chunk / numChunks);
+        int end = static_cast<int>(static_cast<long long>(numAtoms) * (chunk + 1) / numChunks);
+        function(chunk, begin, end);
+    };
+
+    if (!pool) {
+        for (int chunk = 0; chunk < numChunks; ++chunk) {
+            runChunk(chunk);
+        }
+        return;
+    }
+    // A reference_wrapper fits in std::function without a heap allocation.
+    pool->run(numChunks, std::ref(runChunk));
+}
+
+// HCT integral of 1/r^4 over the part of a sphere of radius scaledRadius at
+// distance r that lies outside a sphere of radius offsetRadius, without
+// the factor 1/2. With Derivative, derivative receives its derivative
+// with respect to r.
+template <bool Derivative>
+inline double descreening(double r, double invR, double offsetRadius, double scaledRadius, double& derivative) {
+    derivative = 0.0;
+    const double upper = r + scaledRadius;
+    if (offsetRadius >= upper) return 0.0;
+
+    const double gap = r - scaledRadius;
+    const bool lowerMoves = std::abs(gap) > offsetRadius;
+    const double lower = lowerMoves ? std::abs(gap) : offsetRadius;
+
+    const double l = 1.0 / lower;
+    const double u = 1.0 / upper;
+    const double l2 = l * l;
+    const double u2 = u * u;
+    const double s2 = scaledRadius * scaledRadius;
+    const double logRatio = std::log(lower * u);
+
+    double term = l - u + 0.25 * r * (u2 - l2) + 0.5 * invR * logRatio + 0.25 * s2 * invR * (l2 - u2);
+    const bool engulfed = offsetRadius < scaledRadius - r;
+    if (engulfed) {
+        term += 2.0 * (1.0 / offsetRadius - l);
+    }
+    if (!Derivative) return term;
+
+    // Partial derivative in r, then through u = 1 / (r + s) and l = 1 / |r - s|.
+    derivative = 0.25 * (u2 - l2) - 0.5 * invR * invR * logRatio - 0.25 * s2 * invR * invR * (l2 - u2);
+    derivative -= u2 * (-1.0 + 0.5 * r * u + 0.5 * invR / u - 0.5 * s2 * invR * u);
+    double dl = 0.0;
+    if (lowerMoves) {
+        dl = gap > 0.0 ? -l2 : l2;
+        derivative += dl * (1.0 - 0.5 * r * l - 0.5 * invR / l + 0.5 * s2 * invR * l);
+    }
+
+    // The atom lies entirely inside the screening sphere.
+    if (engulfed) {
+        derivative -= 2.0 * dl;
+    }
+    return term;
+}
+
+}  // namespace
+
+template <typename Real, typename Accum>
+double BasicGeneralizedBornForces<Real, Accum>::computeForces(
+    const NeighborListData& neighborList,
+    const ExclusionLists& exclusions,
+    const PositionArrays<Real>& positions,
+    const GeneralizedBornParameters& parameters,
+    ForceArrays<Accum>& forces,
+    const std::array<double, 3>& boxLength,
+    double cutoffDistance,
+    double soluteDielectric,
+    const GeneralizedBornOptions& options,
+    std::vector<double>& bornRadii) {
+
+    const int numAtoms = static_cast<int>(positions.count);
+    bornRadii.resize(numAtoms);
+    if (numAtoms == 0) return 0.0;
+
+    // The chunks depend only on the atom count, so the summation order and
+    // the result do not depend on the number of threads.
+    const int numChunks = std::max(1, std::min(numAtoms / MIN_ATOMS_PER_CHUNK, MAX_CHUNKS));
+    int numThreads = options.numThreads > 0 ? options.numThreads
+                                            : static_cast<int>(std::thread::hardware_concurrency());
+    numThreads = std::max(1, std::min(numThreads, MAX_CHUNKS));
+    WorkStealingPool* pool = numChunks > 1 ? poolForThread(numThreads) : nullptr;
+
+    const double cutoff2 = cutoffDistance * cutoffDistance;
+    const double prefactor = -COULOMB_CONSTANT * (1.0 / soluteDielectric - 1.0 / options.solventDielectric);
+    const bool periodic = boxLength[0] > 0.0 && boxLength[1] > 0.0 && boxLength[2] > 0.0;
+    const double boxX = boxLength[0];
+    const double boxY = boxLength[1];
+    const double boxZ = boxLength[2];
+    const double invBoxX = periodic ? 1.0 / boxX : 0.0;
+    const double invBoxY = periodic ? 1.0 / boxY : 0.0;
+    const double invBoxZ = periodic ? 1.0 / boxZ : 0.0;
+
+    const Real* x = positions.x;
+    const Real* y = positions.y;
+    const Real* z = positions.z;
+    const double* charge = parameters.charge;
+    const double* radius = parameters.radius;
+    const double* scaledRadius = parameters.scaledRadius;
+    const double offset = options.radiusOffset;
+
+    // Calls visit(j, dx, dy, dz, r2) for every partner j > i within the
+    // cutoff: the neighbor list first, then the excluded pairs.
+    auto forEachPair = [&](int i, auto visit) {
+        const double xi = x[i];
+        const double yi = y[i];
+        const double zi = z[i];
+        auto test = [&](int j) {
+            double dx = xi - x[j];
+            double dy = yi - y[j];
+            double dz = zi - z[j];
+            if (periodic) {
+                dx -= boxX * std::round(dx * invBoxX);
+                dy -= boxY * std::round(dy * invBoxY);
+                dz -= boxZ * std::round(dz * invBoxZ);
+            }
+            double r2 = dx * dx + dy * dy + dz * dz;
+            if (r2 > cutoff2 || r2 < 1e-20) return;
+            visit(j, dx, dy, dz, r2);
+        };
+        for (int n = neighborList.offsets[i]; n < neighborList.offsets[i + 1]; ++n) {
+            test(neighborList.indices[n]);
+        }
+        for (int n = exclusions.offsets[i]; n < exclusions.offsets[i + 1]; ++n) {
+            if (exclusions.indices[n] > i) test(exclusions.indices[n]);
+        }
+    };
+
+    // Per-chunk accumulators, drawn from the caller's arena: a per-atom
+    // scalar (descreening sums, then dE/dR) and forces.
+    ScratchArena& arena = ScratchArena::forThread();
+    ScratchArena::Scope scratch(arena);
+    const size_t stride = static_cast<size_t>(numAtoms);
+    double* scalars = arena.allocate<double>(numChunks * stride);
+    double* chunkFx = arena.allocate<double>(numChunks * stride);
+    double* chunkFy = arena.allocate<double>(numChunks * stride);
+    double* chunkFz = arena.allocate<double>(numChunks * stride);
+    double* chain = arena.allocate<double>(stride);
+    double* chunkEnergy = arena.allocateZeroed<double>(numChunks);
+    double* radii = bornRadii.data();
+
+    // Pass 1: descreening sums.
+    runChunks(pool, numAtoms, numChunks, [&](int chunk, int begin, int end) {
+        double* sums = scalars + chunk * stride;
+        std::fill(sums, sums + stride, 0.0);
+        double derivative;
+        for (int i = begin; i < end; ++i) {
+            const double offsetI = radius[i] - offset;
+            const double scaledI = scaledRadius[i];
+            double sumI = 0.0;
+            forEachPair(i, [&](int j, double, double, double, double r2) {
+                const double r = std::sqrt(r2);
+                const double invR = 1.0 / r;
+                sumI += descreening<false>(r, invR, offsetI, scaledRadius[j], derivative);
+                sums[j] += descreening<false>(r, invR, radius[j] - offset, scaledI, derivative);
+            });
+            sums[i] += sumI;
+        }
+    });
+
+    // Born radii, and dR_i / d(sum_i) for the last sweep.
+    runChunks(pool, numAtoms, numChunks, [&](int, int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            double sum = 0.0;
+            for (int t = 0; t < numChunks; ++t) {
+                sum += scalars[t * stride + i];
+            }
+            const double offsetI = radius[i] - offset;
+            const double psi = 0.5 * offsetI * sum;
+            const double t = std::tanh(psi * (options.alpha - psi * (options.beta - psi * options.gamma)));
+            radii[i] = 1.0 / (1.0 / offsetI - t / radius[i]);
+            const double slope = options.alpha - psi * (2.0 * options.beta - 3.0 * options.gamma * psi);
+            chain[i] = radii[i] * radii[i] * (1.0 - t * t) * slope / radius[i] * 0.5 * offsetI;
+        }
+    });
+
+    // Pass 2: pair and self energies, direct forces and dE/dR.
+    runChunks(pool, numAtoms, numChunks, [&](int chunk, int begin, int end) {
+        double* dEdR = scalars + chunk * stride;
+        double* fx = chunkFx + chunk * stride;
+        double* fy = chunkFy + chunk * stride;
+        double* fz = chunkFz + chunk * stride;
+        std::fill(dEdR, dEdR + stride, 0.0);
+        std::fill(fx, fx + stride, 0.0);
+        std::fill(fy, fy + stride, 0.0);
+        std::fill(fz, fz + stride, 0.0);
+
+        double energy = 0.0;
+        for (int i = begin; i < end; ++i) {
+            const double qi = prefactor * charge[i];
+            const double radiusI = radii[i];
+
+            energy += 0.5 * qi * charge[i] / radiusI;
+            double dEdRi = -0.5 * qi * charge[i] / (radiusI * radiusI);
+            double fxi = 0.0, fyi = 0.0, fzi = 0.0;
+
+            forEachPair(i, [&](int j, double dx, double dy, double dz, double r2) {
+                const double product = radiusI * radii[j];
+                const double d = 0.25 * r2 / product;
+                const double expTerm = std::exp(-d);
+                const double f2 = r2 + product * expTerm;
+                const double invF2 = 1.0 / f2;
+                const double pair = qi * charge[j] * std::sqrt(invF2);
+                energy += pair;
+
+                // Force on i is fScale (dx, dy, dz); dE/d(R_i R_j) splits over both radii.
+                const double fScale = pair * (1.0 - 0.25 * expTerm) * invF2;
+                const double dEdProduct = -0.5 * pair * expTerm * (1.0 + d) * invF2;
+                fxi += fScale * dx;
+                fyi += fScale * dy;
+                fzi += fScale * dz;
+                fx[j] -= fScale * dx;
+                fy[j] -= fScale * dy;
+                fz[j] -= fScale * dz;
+                dEdRi += dEdProduct * radii[j];
+                dEdR[j] += dEdProduct * radiusI;
+            });
+
+            dEdR[i] += dEdRi;
+            fx[i] += fxi;
+            fy[i] += fyi;
+            fz[i] += fzi;
+        }
+        chunkEnergy[chunk] = energy;
+    });
+
+    // dE/d(sum_i) from the reduced dE/dR_i, kept in chain.
+    runChunks(pool, numAtoms, numChunks, [&](int, int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            double dEdRi = 0.0;
+            for (int t = 0; t < numChunks; ++t) {
+                dEdRi += scalars[t * stride + i];
+            }
+            chain[i] *= dEdRi;
+        }
+    });
+
+    // Pass 3: forces through the dependence of the radii on positions.
+    runChunks(pool, numAtoms, numChunks, [&](int chunk, int begin, int end) {
+        double* fx = chunkFx + chunk * stride;
+        double* fy = chunkFy + chunk * stride;
+        double* fz = chunkFz + chunk * stride;
+        double derivativeI, derivativeJ;
+        for (int i = begin; i < end; ++i) {
+            const double offsetI = radius[i] - offset;
+            const double scaledI = scaledRadius[i];
+            double fxi = 0.0, fyi = 0.0, fzi = 0.0;
+
+            forEachPair(i, [&](int j, double dx, double dy, double dz, double r2) {
+                const double r = std::sqrt(r2);
+                const double invR = 1.0 / r;
+                descreening<true>(r, invR, offsetI, scaledRadius[j], derivativeI);
+                descreening<true>(r, invR, radius[j] - offset, scaledI, derivativeJ);
+                const double fScale = -(chain[i] * derivativeI + chain[j] * derivativeJ) * invR;
+                fxi += fScale * dx;
+                fyi += fScale * dy;
+                fzi += fScale * dz;
+                fx[j] -= fScale * dx;
+                fy[j] -= fScale * dy;
+                fz[j] -= fScale * dz;
+            });
+
+            fx[i] += fxi;
+            fy[i] += fyi;
+            fz[i] += fzi;
+        }
+    });
+
+    runChunks(pool, numAtoms, numChunks, [&](int, int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            double sumX = 0.0, sumY = 0.0, sumZ = 0.0;
+            for (int t = 0; t < numChunks; ++t) {
+                sumX += chunkFx[t * stride + i];
+                sumY += chunkFy[t * stride + i];
+                sumZ += chunkFz[t * stride + i];
+            }
+            forces.x[i] += static_cast<Accum>(sumX);
+            forces.y[i] += static_cast<Accum>(sumY);
+            forces.z[i] += static_cast<Accum>(sumZ);
+        }
+    });
+
+    double energy = 0.0;
+    for (int t = 0; t < numChunks; ++t) {
+        energy += chunkEnergy[t];
+    }
+    return energy;
+}
+
+template class BasicGeneralizedBornForces<double, double>;
+template class BasicGeneralizedBornForces<float, float>;
+template class BasicGeneralizedBornForces<float, double>;
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include "generate_exclusions.h"
+#include "neighbor_list.h"
+#include "precision.h"
+
+struct GeneralizedBornOptions {
+    double solventDielectric = 78.5;
+    // Subtracted from the VDW radii before integrating the descreening, in A.
+    double radiusOffset = 0.09;
+    // Rescaling of the descreening integral; the defaults are OBC II.
+    double alpha = 1.0;
+    double beta = 0.8;
+    double gamma = 4.85;
+    // 0 uses every hardware thread; small systems always run serially.
+    // Results are the same for any value.
+    int numThreads = 0;
+};
+
+struct GeneralizedBornParameters {
+    const double* charge;
+    // VDW radius of each atom and its offset radius times the HCT screening scale.
+    const double* radius;
+    const double* scaledRadius;
+};
+
+// Generalized Born polarization energy with OBC effective radii
+// (Onufriev, Bashford and Case, Proteins 55, 383 (2004)):
+//
+//   E = -k/2 (1/eps_in - 1/eps_out) sum_ij q_i q_j / f_ij,
+//   f_ij = sqrt(r_ij^2 + R_i R_j exp(-r_ij^2 / (4 R_i R_j)))
+//
+// over all atom pairs within the cutoff, the self terms i = j included.
+// Bonded and 1-4 pairs are read from the exclusion lists, since the
+// neighbor list leaves them out. The first pass accumulates the HCT
+// descreening integrals into Born radii; the second adds the pair
+// energies and direct forces and the derivatives dE/dR_i, which a last
+// sweep over the same pairs turns into forces through the radii. Each
+// sweep splits the atoms into contiguous chunks with per-chunk
+// accumulators summed afterwards in chunk order. The chunks are set by the
+// atom count alone and run on a WorkStealingPool that the calling thread
+// keeps across evaluations, so the thread count changes neither the result
+// nor, after the first call, the heap.
+//
+// Everything is evaluated in double; Accum only sets the type the forces
+// are added to.
+template <typename Real, typename Accum>
+class BasicGeneralizedBornForces {
+public:
+
+    static double computeForces(
+        const NeighborListData& neighborList,
+        const ExclusionLists& exclusions,
+        const PositionArrays<Real>& positions,
+        const GeneralizedBornParameters& parameters,
+        ForceArrays<Accum>& forces,
+        const std::array<double, 3>& boxLength,
+        double cutoffDistance,
+        double soluteDielectric,
+        const GeneralizedBornOptions& options,
+        std::vector<double>& bornRadii
+    );
+};
+
+using GeneralizedBornForces = BasicGeneralizedBornForces<double, double>;
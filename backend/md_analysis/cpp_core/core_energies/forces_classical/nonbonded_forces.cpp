@@ -0,0 +1,261 @@
+#include "nonbonded_forces.h"
+#include "scratch_arena.h"
+#include <cmath>
+
+template <typename Real, typename Accum>
+NonbondedInteractions::NonbondedEnergy BasicNonbondedForces<Real, Accum>::computePairForces(
+    const NeighborListData& neighborList,
+    const PositionArrays<Real>& positions,
+    const PairParameterArrays<Real>& parameters,
+    ForceArrays<Accum>& forces,
+    const std::array<double, 3>& boxLength,
+    double cutoffDistance,
+    double dielectricConstant) {
+
+    const int numAtoms = static_cast<int>(positions.count);
+    const Real cutoff2 = static_cast<Real>(cutoffDistance * cutoffDistance);
+    const Real coulombScale = static_cast<Real>(COULOMB_CONSTANT / dielectricConstant);
+    const bool periodic = boxLength[0] > 0.0 && boxLength[1] > 0.0 && boxLength[2] > 0.0;
+    const Real boxX = static_cast<Real>(boxLength[0]);
+    const Real boxY = static_cast<Real>(boxLength[1]);
+    const Real boxZ = static_cast<Real>(boxLength[2]);
+    const Real invBoxX = periodic ? Real(1.0) / boxX : Real(0.0);
+    const Real invBoxY = periodic ? Real(1.0) / boxY : Real(0.0);
+    const Real invBoxZ = periodic ? Real(1.0) / boxZ : Real(0.0);
+
+    const Real* x = positions.x;
+    const Real* y = positions.y;
+    const Real* z = positions.z;
+    const int* offsets = neighborList.offsets.data();
+    const int* indices = neighborList.indices.data();
+
+    Accum ljEnergy = 0;
+    Accum coulombEnergy = 0;
+
+    for (int i = 0; i < numAtoms; ++i) {
+        const Real xi = x[i];
+        const Real yi = y[i];
+        const Real zi = z[i];
+        const Real qi = parameters.charge[i] * coulombScale;
+        const Real halfSigmaI = parameters.halfSigma[i];
+        const Real sqrtEpsilonI = parameters.sqrtEpsilon[i];
+
+        Accum fxi = 0;
+        Accum fyi = 0;
+        Accum fzi = 0;
+
+        for (int n = offsets[i]; n < offsets[i + 1]; ++n) {
+            const int j = indices[n];
+
+            Real dx = xi - x[j];
+            Real dy = yi - y[j];
+            Real dz = zi - z[j];
+
+            if (periodic) {
+                dx -= boxX * std::round(dx * invBoxX);
+                dy -= boxY * std::round(dy * invBoxY);
+                dz -= boxZ * std::round(dz * invBoxZ);
+            }
+
+            Real r2 = dx * dx + dy * dy + dz * dz;
+            if (r2 > cutoff2 || r2 < Real(1e-20)) continue;
+
+            Real invR2 = Real(1.0) / r2;
+            Real invR = std::sqrt(invR2);
+
+            Real sigma = halfSigmaI + parameters.halfSigma[j];
+            Real epsilon = sqrtEpsilonI * parameters.sqrtEpsilon[j];
+            Real sr2 = sigma * sigma * invR2;
+            Real sr6 = sr2 * sr2 * sr2;
+            Real sr12 = sr6 * sr6;
+
+            Real lj = Real(4.0) * epsilon * (sr12 - sr6);
+            Real coulomb = qi * parameters.charge[j] * invR;
+
+            // -dU/dr divided by r, so that the force is fScale times (dx, dy, dz).
+            Real fScale = (Real(24.0) * epsilon * (Real(2.0) * sr12 - sr6) + coulomb) * invR2;
+
+            Real fx = fScale * dx;
+            Real fy = fScale * dy;
+            Real fz = fScale * dz;
+
+            fxi += fx;
+            fyi += fy;
+            fzi += fz;
+            forces.x[j] -= fx;
+            forces.y[j] -= fy;
+            forces.z[j] -= fz;
+
+            ljEnergy += lj;
+            coulombEnergy += coulomb;
+        }
+
+        forces.x[i] += fxi;
+        forces.y[i] += fyi;
+        forces.z[i] += fzi;
+    }
+
+    NonbondedInteractions::NonbondedEnergy energy;
+    energy.lennardJones = static_cast<double>(ljEnergy);
+    energy.coulomb = static_cast<double>(coulombEnergy);
+    energy.total = energy.lennardJones + energy.coulomb;
+
+    return energy;
+}
+
+// Evaluates the spline of one table at r2 < cutoffR2; returns U and adds
+// -dU/dr / r to fScale.
+template <typename Real>
+static inline Real evaluateTable(
+    const double* coefficients,
+    Real innerR2,
+    Real inverseSpacing,
+    int lastInterval,
+    Real r2,
+    Real& fScale) {
+
+    Real position = (r2 - innerR2) * inverseSpacing;
+    int k = static_cast<int>(position);
+    k = (k > lastInterval) ? lastInterval : (k < 0) ? 0 : k;
+    Real t = position - static_cast<Real>(k);
+
+    const double* c = coefficients + 4 * k;
+    const Real c0 = static_cast<Real>(c[0]);
+    const Real c1 = static_cast<Real>(c[1]);
+    const Real c2 = static_cast<Real>(c[2]);
+    const Real c3 = static_cast<Real>(c[3]);
+
+    fScale -= Real(2.0) * (c1 + t * (Real(2.0) * c2 + Real(3.0) * t * c3)) * inverseSpacing;
+    return c0 + t * (c1 + t * (c2 + t * c3));
+}
+
+template <typename Real, typename Accum>
+NonbondedInteractions::NonbondedEnergy BasicNonbondedForces<Real, Accum>::computeTabulatedPairForces(
+    const NeighborListData& neighborList,
+    const PositionArrays<Real>& positions,
+    const Real* charge,
+    const int* types,
+    const PairTableSet& tables,
+    ForceArrays<Accum>& forces,
+    const std::array<double, 3>& boxLength,
+    double dielectricConstant) {
+
+    struct TableView {
+        const double* coefficients;
+        Real innerR2;
+        Real cutoffR2;
+        Real inverseSpacing;
+        int lastInterval;
+    };
+
+    const std::vector<PairTable>& tableList = tables.getTables();
+    const size_t numTables = tableList.size();
+    ScratchArena& arena = ScratchArena::forThread();
+    ScratchArena::Scope scratch(arena);
+    TableView* views = arena.allocate<TableView>(numTables);
+    for (size_t t = 0; t < numTables; ++t) {
+        const PairTable& table = tableList[t];
+        views[t] = {table.getCoefficients().data(),
+                    static_cast<Real>(table.getInnerR2()),
+                    table.getNumIntervals() > 0 ? static_cast<Real>(table.getCutoffR2()) : Real(0.0),
+                    static_cast<Real>(table.getInverseSpacing()),
+                    table.getNumIntervals() - 1};
+    }
+
+    const int numAtoms = static_cast<int>(positions.count);
+    const int numTypes = tables.getNumTypes();
+    const int* tableIndex = tables.getTableIndex().data();
+    const int coulombIndex = tables.getCoulombIndex();
+    const Real coulombScale = static_cast<Real>(COULOMB_CONSTANT / dielectricConstant);
+    const bool periodic = boxLength[0] > 0.0 && boxLength[1] > 0.0 && boxLength[2] > 0.0;
+    const Real boxX = static_cast<Real>(boxLength[0]);
+    const Real boxY = static_cast<Real>(boxLength[1]);
+    const Real boxZ = static_cast<Real>(boxLength[2]);
+    const Real invBoxX = periodic ? Real(1.0) / boxX : Real(0.0);
+    const Real invBoxY = periodic ? Real(1.0) / boxY : Real(0.0);
+    const Real invBoxZ = periodic ? Real(1.0) / boxZ : Real(0.0);
+
+    const Real* x = positions.x;
+    const Real* y = positions.y;
+    const Real* z = positions.z;
+    const int* offsets = neighborList.offsets.data();
+    const int* indices = neighborList.indices.data();
+
+    Accum shortRangeEnergy = 0;
+    Accum coulombEnergy = 0;
+
+    for (int i = 0; i < numAtoms; ++i) {
+        const Real xi = x[i];
+        const Real yi = y[i];
+        const Real zi = z[i];
+        const Real qi = charge[i] * coulombScale;
+        const int* rowIndex = tableIndex + types[i] * numTypes;
+
+        Accum fxi = 0;
+        Accum fyi = 0;
+        Accum fzi = 0;
+
+        for (int n = offsets[i]; n < offsets[i + 1]; ++n) {
+            const int j = indices[n];
+
+            Real dx = xi - x[j];
+            Real dy = yi - y[j];
+            Real dz = zi - z[j];
+
+            if (periodic) {
+                dx -= boxX * std::round(dx * invBoxX);
+                dy -= boxY * std::round(dy * invBoxY);
+                dz -= boxZ * std::round(dz * invBoxZ);
+            }
+
+            Real r2 = dx * dx + dy * dy + dz * dz;
+            if (r2 < Real(1e-20)) continue;
+
+            Real fScale = 0;
+
+            const int pairTable = rowIndex[types[j]];
+            if (pairTable >= 0 && r2 < views[pairTable].cutoffR2) {
+                const TableView& view = views[pairTable];
+                shortRangeEnergy += evaluateTable(
+                    view.coefficients, view.innerR2, view.inverseSpacing, view.lastInterval, r2, fScale);
+            }
+
+            const Real qq = qi * charge[j];
+            if (coulombIndex >= 0 && qq != Real(0.0) && r2 < views[coulombIndex].cutoffR2) {
+                const TableView& view = views[coulombIndex];
+                Real coulombForce = 0;
+                coulombEnergy += qq * evaluateTable(
+                    view.coefficients, view.innerR2, view.inverseSpacing, view.lastInterval, r2, coulombForce);
+                fScale += qq * coulombForce;
+            }
+
+            if (fScale == Real(0.0)) continue;
+
+            Real fx = fScale * dx;
+            Real fy = fScale * dy;
+            Real fz = fScale * dz;
+
+            fxi += fx;
+            fyi += fy;
+            fzi += fz;
+            forces.x[j] -= fx;
+            forces.y[j] -= fy;
+            forces.z[j] -= fz;
+        }
+
+        forces.x[i] += fxi;
+        forces.y[i] += fyi;
+        forces.z[i] += fzi;
+    }
+
+    NonbondedInteractions::NonbondedEnergy energy;
+    energy.lennardJones = static_cast<double>(shortRangeEnergy);
+    energy.coulomb = static_cast<double>(coulombEnergy);
+    energy.total = energy.lennardJones + energy.coulomb;
+
+    return energy;
+}
+
+template class BasicNonbondedForces<double, double>;
+template class BasicNonbondedForces<float, float>;
+template class BasicNonbondedForces<float, double>;
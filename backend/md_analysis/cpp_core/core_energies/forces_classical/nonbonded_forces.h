@@ -1,43 +1,45 @@
 #pragma once
 
-#include <vector>
 #include <array>
-#include <memory>
-#include <cmath>
-#include <string>
+#include "nonbond_interactions.h"
+#include "neighbor_list.h"
+#include "pair_table.h"
+#include "precision.h"
 
-struct AtomData {
-    int id;
-    std::string element;
-    std::array<double, 3> velocity;
-    double mass;
-    int atomicNumber;
-    double charge;
-    
-    double distanceTo(const AtomData& other) const;
+template <typename Real>
+struct PairParameterArrays {
+    const Real* charge;
+    const Real* halfSigma;
+    const Real* sqrtEpsilon;
 };
 
-struct MoleculeData {
-    std::vector<AtomData> atoms;
-};
-
-class NonbondedForces {
+template <typename Real, typename Accum>
+class BasicNonbondedForces {
 public: 
 
-    static void computeElectrostaticForces(
-        const std::vector<std::vector<AtomData>> neighborLists, 
-        const std::vector<std::array<double,3>>& positions,
-        const std::vector<double>& charges,
-        std::vector<std::array<double,3>>& forces, 
-        double radiusCoulombic
+    static NonbondedInteractions::NonbondedEnergy computePairForces(
+        const NeighborListData& neighborList,
+        const PositionArrays<Real>& positions,
+        const PairParameterArrays<Real>& parameters,
+        ForceArrays<Accum>& forces,
+        const std::array<double, 3>& boxLength,
+        double cutoffDistance,
+        double dielectricConstant = 1.0
     );
 
-    static void computeLJForces(
-        const std::vector<std::vector<AtomData>> neighborLists, 
-        const std::vector<std::array<double,3>>& positions,
-        const std::vector<double>& sigma, 
-        const std::vector<double>& epsilon,
-        std::vector<std::array<double,3>>& forces, 
-        double radiusVDW
+    // Same pair loop with every interaction read from spline tables; each
+    // table applies within its own cutoff. Short-range tables are reported
+    // as lennardJones energy, the charge-scaled table as coulomb.
+    static NonbondedInteractions::NonbondedEnergy computeTabulatedPairForces(
+        const NeighborListData& neighborList,
+        const PositionArrays<Real>& positions,
+        const Real* charge,
+        const int* types,
+        const PairTableSet& tables,
+        ForceArrays<Accum>& forces,
+        const std::array<double, 3>& boxLength,
+        double dielectricConstant = 1.0
     );
-};
\ No newline at end of file
+};
+
+using NonbondedForces = BasicNonbondedForces<double, double>;
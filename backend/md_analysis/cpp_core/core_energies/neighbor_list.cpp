@@ -0,0 +1,118 @@
+#include "neighbor_list.h"
+#include "allocation_counter.h"
+#include <cmath>
+
+void NeighborList::setCutoff(double cutoffDistance, double skinDistance) {
+    this->cutoffDistance = cutoffDistance;
+    this->skinDistance = skinDistance;
+    valid = false;
+}
+
+bool NeighborList::needsRebuild(const PositionArrays<double>& positions) const {
+    if (!valid || referenceX.size() != positions.count) return true;
+
+    double limit = 0.25 * skinDistance * skinDistance;
+    for (size_t i = 0; i < positions.count; ++i) {
+        double dx = positions.x[i] - referenceX[i];
+        double dy = positions.y[i] - referenceY[i];
+        double dz = positions.z[i] - referenceZ[i];
+        if (dx * dx + dy * dy + dz * dz > limit) return true;
+    }
+
+    return false;
+}
+
+static bool isExcluded(const ExclusionLists& exclusions, int i, int j) {
+    for (int e = exclusions.offsets[i]; e < exclusions.offsets[i + 1]; ++e) {
+        int excluded = exclusions.indices[e];
+        if (excluded >= j) return excluded == j;
+    }
+    return false;
+}
+
+void NeighborList::build(
+    const PositionArrays<double>& positions,
+    const std::array<double, 3>& boxLength,
+    const ExclusionLists& exclusions) {
+
+    const int numAtoms = static_cast<int>(positions.count);
+    const double listRange = cutoffDistance + skinDistance;
+    const double listRange2 = listRange * listRange;
+    const bool periodic = boxLength[0] > 0.0 && boxLength[1] > 0.0 && boxLength[2] > 0.0;
+
+    const size_t offsetsCapacity = data.offsets.capacity();
+    const size_t indicesCapacity = data.indices.capacity();
+
+    data.offsets.resize(numAtoms + 1);
+    data.indices.clear();
+    data.offsets[0] = 0;
+
+    auto addIfInRange = [&](int i, int j) {
+        if (isExcluded(exclusions, i, j)) return;
+
+        double dx = positions.x[i] - positions.x[j];
+        double dy = positions.y[i] - positions.y[j];
+        double dz = positions.z[i] - positions.z[j];
+
+        if (periodic) {
+            dx -= boxLength[0] * std::round(dx / boxLength[0]);
+            dy -= boxLength[1] * std::round(dy / boxLength[1]);
+            dz -= boxLength[2] * std::round(dz / boxLength[2]);
+        }
+
+        if (dx * dx + dy * dy + dz * dz <= listRange2) {
+            data.indices.push_back(j);
+        }
+    };
+
+    cellList.build(positions, boxLength, listRange);
+
+    if (cellList.supportsNeighborSearch()) {
+        const std::vector<int>& cellOffsets = cellList.getCellOffsets();
+        const std::vector<int>& cellAtoms = cellList.getCellAtoms();
+        std::array<int, 27> neighborCells;
+
+        for (int i = 0; i < numAtoms; ++i) {
+            int numNeighborCells = cellList.getNeighborCells(cellList.getCellOfAtom(i), neighborCells);
+
+            for (int c = 0; c < numNeighborCells; ++c) {
+                int cell = neighborCells[c];
+                for (int n = cellOffsets[cell]; n < cellOffsets[cell + 1]; ++n) {
+                    int j = cellAtoms[n];
+                    if (j > i) addIfInRange(i, j);
+                }
+            }
+
+            data.offsets[i + 1] = static_cast<int>(data.indices.size());
+        }
+    } else {
+        for (int i = 0; i < numAtoms; ++i) {
+            for (int j = i + 1; j < numAtoms; ++j) {
+                addIfInRange(i, j);
+            }
+            data.offsets[i + 1] = static_cast<int>(data.indices.size());
+        }
+    }
+
+    AllocationCounter::recordGrowth(data.offsets, offsetsCapacity);
+    AllocationCounter::recordGrowth(data.indices, indicesCapacity);
+
+    referenceX.assign(positions.x, positions.x + numAtoms);
+    referenceY.assign(positions.y, positions.y + numAtoms);
+    referenceZ.assign(positions.z, positions.z + numAtoms);
+    valid = true;
+    ++buildCount;
+}
+
+void NeighborList::restore(
+    const NeighborListData& data,
+    const std::vector<double>& referenceX,
+    const std::vector<double>& referenceY,
+    const std::vector<double>& referenceZ) {
+
+    this->data = data;
+    this->referenceX = referenceX;
+    this->referenceY = referenceY;
+    this->referenceZ = referenceZ;
+    valid = true;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include "cell_list.h"
+#include "generate_exclusions.h"
+#include "precision.h"
+
+// Half neighbor list in CSR form: the partners j > i of atom i are
+// indices[offsets[i]] .. indices[offsets[i + 1] - 1].
+struct NeighborListData {
+    std::vector<int> offsets;
+    std::vector<int> indices;
+};
+
+class NeighborList {
+public:
+
+    void setCutoff(double cutoffDistance, double skinDistance);
+
+    double getCutoffDistance() const { return cutoffDistance; }
+
+    double getSkinDistance() const { return skinDistance; }
+
+    bool needsRebuild(const PositionArrays<double>& positions) const;
+
+    void build(
+        const PositionArrays<double>& positions,
+        const std::array<double, 3>& boxLength,
+        const ExclusionLists& exclusions);
+
+    void invalidate() { valid = false; }
+
+    bool isValid() const { return valid; }
+
+    // Reinstates a list and its reference positions saved from an earlier
+    // build, so a restarted run sees exactly the same pair order.
+    void restore(
+        const NeighborListData& data,
+        const std::vector<double>& referenceX,
+        const std::vector<double>& referenceY,
+        const std::vector<double>& referenceZ);
+
+    const std::vector<double>& getReferenceX() const { return referenceX; }
+
+    const std::vector<double>& getReferenceY() const { return referenceY; }
+
+    const std::vector<double>& getReferenceZ() const { return referenceZ; }
+
+    const NeighborListData& getData() const { return data; }
+
+    int getBuildCount() const { return buildCount; }
+
+    const CellList& getCellList() const { return cellList; }
+
+private:
+    double cutoffDistance = 10.0;
+    double skinDistance = 2.0;
+    bool valid = false;
+    int buildCount = 0;
+    NeighborListData data;
+    CellList cellList;
+    std::vector<double> referenceX;
+    std::vector<double> referenceY;
+    std::vector<double> referenceZ;
+};
@@ -1,10 +1,9 @@
 #include "nonbond_interactions.h"
 #include "radii_lists.h"
+#include "allocation_counter.h"
 #include <cmath>
 #include <algorithm>
 
-const double COULOMB_CONSTANT = 332.06;
-
 double AtomData::distanceTo(const AtomData& other) const {
     double dx = position[0] - other.position[0];
     double dy = position[1] - other.position[1];
@@ -67,6 +66,64 @@ std::vector<std::shared_ptr<AtomData>> NonbondedInteractions::getVdwList(
     return vdwNeighbors;
 }
 
+void NonbondedInteractions::getNeighborList(
+    const std::vector<MoleculeData>& simulationSpace,
+    const AtomData& atom,
+    double cutoffDistance,
+    std::vector<const AtomData*>& neighbors) {
+    
+    const size_t capacity = neighbors.capacity();
+    neighbors.clear();
+    
+    for (const auto& molecule : simulationSpace) {
+        for (const auto& neighbor : molecule.atoms) {
+            if (atom.id == neighbor.id) continue;
+            
+            if (atom.distanceTo(neighbor) <= cutoffDistance) {
+                neighbors.push_back(&neighbor);
+            }
+        }
+    }
+    
+    AllocationCounter::recordGrowth(neighbors, capacity);
+}
+
+void NonbondedInteractions::getElectrostaticList(
+    const std::vector<const AtomData*>& neighborList,
+    const AtomData& atom,
+    double coulombRadius,
+    std::vector<const AtomData*>& electrostaticNeighbors) {
+    
+    const size_t capacity = electrostaticNeighbors.capacity();
+    electrostaticNeighbors.clear();
+    
+    for (const AtomData* neighbor : neighborList) {
+        if (atom.distanceTo(*neighbor) <= coulombRadius) {
+            electrostaticNeighbors.push_back(neighbor);
+        }
+    }
+    
+    AllocationCounter::recordGrowth(electrostaticNeighbors, capacity);
+}
+
+void NonbondedInteractions::getVdwList(
+    const std::vector<const AtomData*>& neighborList,
+    const AtomData& atom,
+    double vdwRadius,
+    std::vector<const AtomData*>& vdwNeighbors) {
+    
+    const size_t capacity = vdwNeighbors.capacity();
+    vdwNeighbors.clear();
+    
+    for (const AtomData* neighbor : neighborList) {
+        if (atom.distanceTo(*neighbor) <= vdwRadius) {
+            vdwNeighbors.push_back(neighbor);
+        }
+    }
+    
+    AllocationCounter::recordGrowth(vdwNeighbors, capacity);
+}
+
 double NonbondedInteractions::calculateLennardJones(
     const AtomData& atom1,
     const AtomData& atom2,
@@ -4,6 +4,9 @@
 #include <array>
 #include <memory>
 #include <cmath>
+#include <string>
+
+constexpr double COULOMB_CONSTANT = 332.06;
 
 struct AtomData {
     int id;
@@ -39,6 +42,24 @@ public:
         const AtomData& atom,
         double vdwRadius);
     
+    static void getNeighborList(
+        const std::vector<MoleculeData>& simulationSpace,
+        const AtomData& atom,
+        double cutoffDistance,
+        std::vector<const AtomData*>& neighbors);
+    
+    static void getElectrostaticList(
+        const std::vector<const AtomData*>& neighborList,
+        const AtomData& atom,
+        double coulombRadius,
+        std::vector<const AtomData*>& electrostaticNeighbors);
+    
+    static void getVdwList(
+        const std::vector<const AtomData*>& neighborList,
+        const AtomData& atom,
+        double vdwRadius,
+        std::vector<const AtomData*>& vdwNeighbors);
+    
     static double calculateLennardJones(
         const AtomData& atom1,
         const AtomData& atom2,
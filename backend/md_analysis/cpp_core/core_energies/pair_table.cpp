@@ -0,0 +1,207 @@
+#include "pair_table.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+// Smallest separation tabulated by the built-in potentials; closer pairs
+// fall on the extrapolated first interval.
+const double DEFAULT_INNER_DISTANCE = 0.5;
+
+static std::array<double, 2> applyModifier(
+    const PairPotentialFunction& potential,
+    double r,
+    double cutoffDistance,
+    CutoffModifier modifier,
+    double switchDistance,
+    const std::array<double, 2>& atCutoff) {
+
+    std::array<double, 2> value = potential(r);
+
+    if (modifier == CutoffModifier::Switch && r > switchDistance) {
+        double width = cutoffDistance - switchDistance;
+        double x = std::min((r - switchDistance) / width, 1.0);
+        double s = 1.0 - x * x * x * (10.0 - 15.0 * x + 6.0 * x * x);
+        double dsdr = -30.0 * x * x * (1.0 - x) * (1.0 - x) / width;
+        value = {value[0] * s, value[1] * s + value[0] * dsdr};
+    } else if (modifier == CutoffModifier::ForceShift) {
+        value[0] -= atCutoff[0] + (r - cutoffDistance) * atCutoff[1];
+        value[1] -= atCutoff[1];
+    }
+
+    return value;
+}
+
+PairTable::PairTable(
+    const PairPotentialFunction& potential,
+    double innerDistance,
+    double cutoffDistance,
+    int numIntervals,
+    CutoffModifier modifier,
+    double switchDistance)
+    : innerDistance(innerDistance), cutoffDistance(cutoffDistance) {
+
+    if (innerDistance <= 0.0 || cutoffDistance <= innerDistance) {
+        throw std::runtime_error("Pair table needs 0 < inner distance < cutoff distance");
+    }
+    if (numIntervals < 1) {
+        throw std::runtime_error("Pair table needs at least one interval");
+    }
+    if (modifier == CutoffModifier::Switch &&
+        (switchDistance <= 0.0 || switchDistance >= cutoffDistance)) {
+        throw std::runtime_error("Switch distance must lie between 0 and the cutoff distance");
+    }
+
+    innerR2 = innerDistance * innerDistance;
+    cutoffR2 = cutoffDistance * cutoffDistance;
+    const double spacing = (cutoffR2 - innerR2) / numIntervals;
+    inverseSpacing = 1.0 / spacing;
+
+    std::array<double, 2> atCutoff = {0.0, 0.0};
+    if (modifier == CutoffModifier::ForceShift) {
+        atCutoff = potential(cutoffDistance);
+    }
+
+    // Knot values of U and dU/d(r^2) = (dU/dr) / (2r).
+    std::vector<double> energy(numIntervals + 1);
+    std::vector<double> slope(numIntervals + 1);
+    for (int k = 0; k <= numIntervals; ++k) {
+        double r = std::sqrt(innerR2 + k * spacing);
+        std::array<double, 2> value = applyModifier(
+            potential, r, cutoffDistance, modifier, switchDistance, atCutoff);
+        energy[k] = value[0];
+        slope[k] = value[1] / (2.0 * r);
+    }
+
+    coefficients.resize(4 * static_cast<size_t>(numIntervals));
+    for (int k = 0; k < numIntervals; ++k) {
+        double u0 = energy[k];
+        double u1 = energy[k + 1];
+        double m0 = spacing * slope[k];
+        double m1 = spacing * slope[k + 1];
+        double* c = &coefficients[4 * static_cast<size_t>(k)];
+        c[0] = u0;
+        c[1] = m0;
+        c[2] = 3.0 * (u1 - u0) - 2.0 * m0 - m1;
+        c[3] = 2.0 * (u0 - u1) + m0 + m1;
+    }
+}
+
+PairTable PairTable::lennardJones(
+    double sigma,
+    double epsilon,
+    double cutoffDistance,
+    CutoffModifier modifier,
+    double switchDistance,
+    int numIntervals) {
+
+    return PairTable([sigma, epsilon](double r) {
+        double sr2 = sigma * sigma / (r * r);
+        double sr6 = sr2 * sr2 * sr2;
+        double sr12 = sr6 * sr6;
+        return std::array<double, 2>{
+            4.0 * epsilon * (sr12 - sr6),
+            -24.0 * epsilon * (2.0 * sr12 - sr6) / r};
+    }, DEFAULT_INNER_DISTANCE, cutoffDistance, numIntervals, modifier, switchDistance);
+}
+
+PairTable PairTable::coulomb(
+    double cutoffDistance,
+    CutoffModifier modifier,
+    double switchDistance,
+    int numIntervals) {
+
+    return PairTable([](double r) {
+        return std::array<double, 2>{1.0 / r, -1.0 / (r * r)};
+    }, DEFAULT_INNER_DISTANCE, cutoffDistance, numIntervals, modifier, switchDistance);
+}
+
+PairTable PairTable::fromCoefficients(
+    double innerDistance,
+    double cutoffDistance,
+    double inverseSpacing,
+    const std::vector<double>& coefficients) {
+
+    if (innerDistance <= 0.0 || cutoffDistance <= innerDistance || inverseSpacing <= 0.0 ||
+        coefficients.empty() || coefficients.size() % 4 != 0) {
+        throw std::runtime_error("Invalid pair table coefficients");
+    }
+
+    PairTable table;
+    table.innerDistance = innerDistance;
+    table.cutoffDistance = cutoffDistance;
+    table.innerR2 = innerDistance * innerDistance;
+    table.cutoffR2 = cutoffDistance * cutoffDistance;
+    table.inverseSpacing = inverseSpacing;
+    table.coefficients = coefficients;
+    return table;
+}
+
+std::array<double, 2> PairTable::evaluate(double r2) const {
+    if (coefficients.empty() || r2 >= cutoffR2) {
+        return {0.0, 0.0};
+    }
+
+    const int numIntervals = getNumIntervals();
+    double position = (r2 - innerR2) * inverseSpacing;
+    int k = std::min(static_cast<int>(position), numIntervals - 1);
+    k = std::max(k, 0);
+    double t = position - k;
+
+    const double* c = &coefficients[4 * static_cast<size_t>(k)];
+    double energy = c[0] + t * (c[1] + t * (c[2] + t * c[3]));
+    double dUdr2 = (c[1] + t * (2.0 * c[2] + 3.0 * t * c[3])) * inverseSpacing;
+
+    return {energy, -2.0 * dUdr2};
+}
+
+PairTableSet::PairTableSet(int numTypes)
+    : numTypes(numTypes), tableIndex(static_cast<size_t>(numTypes) * numTypes, -1) {
+
+    if (numTypes < 0) {
+        throw std::runtime_error("Number of atom types must not be negative");
+    }
+}
+
+static void checkType(int type, int numTypes) {
+    if (type < 0 || type >= numTypes) {
+        throw std::runtime_error("Atom type " + std::to_string(type) + " out of range");
+    }
+}
+
+void PairTableSet::setTable(int typeI, int typeJ, const PairTable& table) {
+    checkType(typeI, numTypes);
+    checkType(typeJ, numTypes);
+
+    int& index = tableIndex[typeI * numTypes + typeJ];
+    if (index < 0) {
+        index = static_cast<int>(tables.size());
+        tables.push_back(table);
+    } else {
+        tables[index] = table;
+    }
+    tableIndex[typeJ * numTypes + typeI] = index;
+}
+
+void PairTableSet::setCoulombTable(const PairTable& table) {
+    if (coulombIndex < 0) {
+        coulombIndex = static_cast<int>(tables.size());
+        tables.push_back(table);
+    } else {
+        tables[coulombIndex] = table;
+    }
+}
+
+bool PairTableSet::hasTable(int typeI, int typeJ) const {
+    checkType(typeI, numTypes);
+    checkType(typeJ, numTypes);
+    return tableIndex[typeI * numTypes + typeJ] >= 0;
+}
+
+double PairTableSet::getCutoffDistance() const {
+    double cutoff = 0.0;
+    for (const auto& table : tables) {
+        cutoff = std::max(cutoff, table.getCutoffDistance());
+    }
+    return cutoff;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <array>
+#include <functional>
+#include <vector>
+
+enum class CutoffModifier {
+    None,
+    Switch,
+    ForceShift
+};
+
+// Returns {U(r), dU/dr} at separation r.
+using PairPotentialFunction = std::function<std::array<double, 2>(double)>;
+
+// Cubic Hermite spline of a pair potential on a uniform grid in r^2, from
+// innerDistance^2 to cutoffDistance^2. Interval k stores the coefficients
+// {a, b, c, d} of U = a + t (b + t (c + t d)) at coefficients[4k .. 4k + 3];
+// the force is taken from the derivative of the same polynomial so energy
+// and force stay consistent. Below innerDistance the first interval is
+// extrapolated; at and beyond the cutoff the table is zero.
+class PairTable {
+public:
+
+    PairTable() = default;
+
+    PairTable(
+        const PairPotentialFunction& potential,
+        double innerDistance,
+        double cutoffDistance,
+        int numIntervals = 4096,
+        CutoffModifier modifier = CutoffModifier::None,
+        double switchDistance = 0.0);
+
+    static PairTable lennardJones(
+        double sigma,
+        double epsilon,
+        double cutoffDistance,
+        CutoffModifier modifier = CutoffModifier::None,
+        double switchDistance = 0.0,
+        int numIntervals = 4096);
+
+    // Rebuilds a table exactly from the values returned by its getters.
+    static PairTable fromCoefficients(
+        double innerDistance,
+        double cutoffDistance,
+        double inverseSpacing,
+        const std::vector<double>& coefficients);
+
+    // Tabulates 1/r; the kernel scales it by q_i q_j COULOMB_CONSTANT / dielectric.
+    static PairTable coulomb(
+        double cutoffDistance,
+        CutoffModifier modifier = CutoffModifier::None,
+        double switchDistance = 0.0,
+        int numIntervals = 4096);
+
+    // Returns {U, -dU/dr / r} at squared separation r2.
+    std::array<double, 2> evaluate(double r2) const;
+
+    double getInnerDistance() const { return innerDistance; }
+
+    double getCutoffDistance() const { return cutoffDistance; }
+
+    double getInnerR2() const { return innerR2; }
+
+    double getCutoffR2() const { return cutoffR2; }
+
+    double getInverseSpacing() const { return inverseSpacing; }
+
+    int getNumIntervals() const { return static_cast<int>(coefficients.size() / 4); }
+
+    const std::vector<double>& getCoefficients() const { return coefficients; }
+
+private:
+    double innerDistance = 0.0;
+    double cutoffDistance = 0.0;
+    double innerR2 = 0.0;
+    double cutoffR2 = 0.0;
+    double inverseSpacing = 0.0;
+    std::vector<double> coefficients;
+};
+
+// Tables indexed by atom type pair, plus an optional charge-scaled table
+// for electrostatics. Type pairs without a table do not interact through
+// the tabulated short-range term.
+class PairTableSet {
+public:
+
+    explicit PairTableSet(int numTypes = 0);
+
+    void setTable(int typeI, int typeJ, const PairTable& table);
+
+    void setCoulombTable(const PairTable& table);
+
+    int getNumTypes() const { return numTypes; }
+
+    bool hasTable(int typeI, int typeJ) const;
+
+    bool hasCoulombTable() const { return coulombIndex >= 0; }
+
+    // Largest cutoff of any table, which the neighbor list must cover.
+    double getCutoffDistance() const;
+
+    // numTypes x numTypes indices into getTables(), -1 where unset.
+    const std::vector<int>& getTableIndex() const { return tableIndex; }
+
+    int getCoulombIndex() const { return coulombIndex; }
+
+    const std::vector<PairTable>& getTables() const { return tables; }
+
+private:
+    int numTypes = 0;
+    int coulombIndex = -1;
+    std::vector<int> tableIndex;
+    std::vector<PairTable> tables;
+};
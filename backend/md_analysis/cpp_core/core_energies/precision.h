@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+
+enum class PrecisionMode {
+    Double,
+    Single,
+    Mixed
+};
+
+// Real is the type positions are stored in and pair terms are computed in,
+// Accum is the type forces and energies are summed in.
+template <PrecisionMode Mode>
+struct PrecisionTraits;
+
+template <>
+struct PrecisionTraits<PrecisionMode::Double> {
+    using Real = double;
+    using Accum = double;
+};
+
+template <>
+struct PrecisionTraits<PrecisionMode::Single> {
+    using Real = float;
+    using Accum = float;
+};
+
+template <>
+struct PrecisionTraits<PrecisionMode::Mixed> {
+    using Real = float;
+    using Accum = double;
+};
+
+template <typename Real>
+struct PositionArrays {
+    const Real* x;
+    const Real* y;
+    const Real* z;
+    std::size_t count;
+};
+
+template <typename Accum>
+struct ForceArrays {
+    Accum* x;
+    Accum* y;
+    Accum* z;
+};
@@ -0,0 +1,99 @@
+#include "generate_exclusions.h"
+#include <algorithm>
+
+uint64_t Exclusions::pairKey(int atom1Id, int atom2Id) {
+    uint64_t low = static_cast<uint32_t>(std::min(atom1Id, atom2Id));
+    uint64_t high = static_cast<uint32_t>(std::max(atom1Id, atom2Id));
+    return (low << 32) | high;
+}
+
+ExclusionTable Exclusions::buildExclusionTable(
+    int numAtoms,
+    const std::vector<BondData>& bonds,
+    int maxDepth) {
+
+    std::vector<int> offsets(numAtoms + 1, 0);
+    for (const auto& bond : bonds) {
+        offsets[bond.atom1Id + 1]++;
+        offsets[bond.atom2Id + 1]++;
+    }
+    for (int i = 0; i < numAtoms; ++i) {
+        offsets[i + 1] += offsets[i];
+    }
+
+    std::vector<int> adjacency(offsets[numAtoms]);
+    std::vector<int> cursor(offsets.begin(), offsets.end() - 1);
+    for (const auto& bond : bonds) {
+        adjacency[cursor[bond.atom1Id]++] = bond.atom2Id;
+        adjacency[cursor[bond.atom2Id]++] = bond.atom1Id;
+    }
+
+    ExclusionTable table;
+    std::vector<int> depth(numAtoms, -1);
+    std::vector<int> frontier;
+    std::vector<int> visited;
+
+    for (int source = 0; source < numAtoms; ++source) {
+        depth[source] = 0;
+        visited.assign(1, source);
+        frontier.assign(1, source);
+
+        for (size_t head = 0; head < frontier.size(); ++head) {
+            int atom = frontier[head];
+            if (depth[atom] >= maxDepth) continue;
+
+            for (int e = offsets[atom]; e < offsets[atom + 1]; ++e) {
+                int neighbor = adjacency[e];
+                if (depth[neighbor] >= 0) continue;
+
+                depth[neighbor] = depth[atom] + 1;
+                visited.push_back(neighbor);
+                frontier.push_back(neighbor);
+
+                if (neighbor > source) {
+                    table[pairKey(source, neighbor)] = {static_cast<uint8_t>(depth[neighbor])};
+                }
+            }
+        }
+
+        for (int atom : visited) {
+            depth[atom] = -1;
+        }
+    }
+
+    return table;
+}
+
+ExclusionLists Exclusions::buildExclusionLists(
+    int numAtoms,
+    const ExclusionTable& table) {
+
+    ExclusionLists lists;
+    lists.offsets.assign(numAtoms + 1, 0);
+
+    for (const auto& entry : table) {
+        int atom1Id = static_cast<int>(entry.first >> 32);
+        int atom2Id = static_cast<int>(entry.first & 0xffffffffu);
+        lists.offsets[atom1Id + 1]++;
+        lists.offsets[atom2Id + 1]++;
+    }
+    for (int i = 0; i < numAtoms; ++i) {
+        lists.offsets[i + 1] += lists.offsets[i];
+    }
+
+    lists.indices.resize(lists.offsets[numAtoms]);
+    std::vector<int> cursor(lists.offsets.begin(), lists.offsets.end() - 1);
+    for (const auto& entry : table) {
+        int atom1Id = static_cast<int>(entry.first >> 32);
+        int atom2Id = static_cast<int>(entry.first & 0xffffffffu);
+        lists.indices[cursor[atom1Id]++] = atom2Id;
+        lists.indices[cursor[atom2Id]++] = atom1Id;
+    }
+
+    for (int i = 0; i < numAtoms; ++i) {
+        std::sort(lists.indices.begin() + lists.offsets[i],
+                  lists.indices.begin() + lists.offsets[i + 1]);
+    }
+
+    return lists;
+}
@@ -1,26 +1,34 @@
 #pragma once
 
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "bonded_interactions.h"
+
 struct PairDistance {
     uint8_t graphDistance;
 };
 
-struct BondData {
-    int atom1Id;
-    int atom2Id;
-    int order;  
-    double equilibriumLength;
-    double forceConstant; 
-    bool isRotatable;
-};
-
 using ExclusionTable = std::unordered_map<uint64_t, PairDistance>;
 
+struct ExclusionLists {
+    std::vector<int> offsets;
+    std::vector<int> indices;
+};
+
 class Exclusions {
 public:
 
+    static uint64_t pairKey(int atom1Id, int atom2Id);
+
     static ExclusionTable buildExclusionTable(
         int numAtoms,
         const std::vector<BondData>& bonds,
         int maxDepth = 3  
     );
-};
\ No newline at end of file
+
+    static ExclusionLists buildExclusionLists(
+        int numAtoms,
+        const ExclusionTable& table
+    );
+};
@@ -0,0 +1,195 @@
+#include "topology_builder.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+TopologyBuilder::TopologyBuilder(int numAtoms, const std::vector<BondData>& bonds)
+    : numAtoms(numAtoms), bonds(bonds) {
+
+    if (numAtoms < 0) {
+        throw std::runtime_error("Number of atoms must not be negative");
+    }
+    for (const auto& bond : bonds) {
+        checkAtomId(bond.atom1Id);
+        checkAtomId(bond.atom2Id);
+        if (bond.atom1Id == bond.atom2Id) {
+            throw std::runtime_error("Bond connects atom " + std::to_string(bond.atom1Id) + " to itself");
+        }
+    }
+
+    buildAdjacency(SPARE_SLOTS);
+
+    size_t numAngles = 0;
+    for (int j = 0; j < numAtoms; ++j) {
+        numAngles += static_cast<size_t>(degree[j]) * (degree[j] - 1) / 2;
+    }
+    size_t maxDihedrals = 0;
+    for (const auto& bond : this->bonds) {
+        maxDihedrals += static_cast<size_t>(degree[bond.atom1Id] - 1) * (degree[bond.atom2Id] - 1);
+    }
+    angles.reserve(numAngles);
+    dihedrals.reserve(maxDihedrals);
+
+    for (int j = 0; j < numAtoms; ++j) {
+        const int* neighbors = getNeighbors(j);
+        for (int a = 0; a < degree[j]; ++a) {
+            for (int b = a + 1; b < degree[j]; ++b) {
+                addAngle(neighbors[a], j, neighbors[b]);
+            }
+        }
+    }
+
+    for (const auto& bond : this->bonds) {
+        addDihedralsAroundBond(bond.atom1Id, bond.atom2Id);
+    }
+
+    improperOfAtom.assign(numAtoms, -1);
+    for (int j = 0; j < numAtoms; ++j) {
+        updateImproperCandidate(j);
+    }
+}
+
+void TopologyBuilder::checkAtomId(int atomId) const {
+    if (atomId < 0 || atomId >= numAtoms) {
+        throw std::runtime_error("Atom index " + std::to_string(atomId) + " out of range");
+    }
+}
+
+void TopologyBuilder::buildAdjacency(int spareSlots) {
+    std::vector<int> count(numAtoms, 0);
+    for (const auto& bond : bonds) {
+        count[bond.atom1Id]++;
+        count[bond.atom2Id]++;
+    }
+
+    offsets.resize(numAtoms);
+    capacity.resize(numAtoms);
+    int next = 0;
+    for (int i = 0; i < numAtoms; ++i) {
+        offsets[i] = next;
+        capacity[i] = count[i] + spareSlots;
+        next += capacity[i];
+    }
+
+    adjacency.assign(next, -1);
+    degree.assign(numAtoms, 0);
+    for (const auto& bond : bonds) {
+        adjacency[offsets[bond.atom1Id] + degree[bond.atom1Id]++] = bond.atom2Id;
+        adjacency[offsets[bond.atom2Id] + degree[bond.atom2Id]++] = bond.atom1Id;
+    }
+}
+
+// Moves the atom's neighbors to the end of the adjacency with twice the
+// capacity. Old ranges are left unused; those of one atom add up to less
+// than its current capacity, so the adjacency stays linear in the bonds.
+void TopologyBuilder::growSlots(int atomId) {
+    const int newOffset = static_cast<int>(adjacency.size());
+    const int newCapacity = std::max(2 * capacity[atomId], SPARE_SLOTS);
+    adjacency.resize(adjacency.size() + newCapacity, -1);
+    std::copy(adjacency.begin() + offsets[atomId], adjacency.begin() + offsets[atomId] + degree[atomId],
+              adjacency.begin() + newOffset);
+    offsets[atomId] = newOffset;
+    capacity[atomId] = newCapacity;
+}
+
+bool TopologyBuilder::areBonded(int atom1Id, int atom2Id) const {
+    const int* neighbors = getNeighbors(atom1Id);
+    for (int n = 0; n < degree[atom1Id]; ++n) {
+        if (neighbors[n] == atom2Id) return true;
+    }
+    return false;
+}
+
+void TopologyBuilder::addAngle(int atom1Id, int atom2Id, int atom3Id) {
+    angles.push_back({atom1Id, atom2Id, atom3Id, 0.0, 0.0});
+}
+
+void TopologyBuilder::addDihedral(int atom1Id, int atom2Id, int atom3Id, int atom4Id) {
+    dihedrals.push_back({atom1Id, atom2Id, atom3Id, atom4Id, 0.0, 0.0, 0.0});
+}
+
+void TopologyBuilder::addDihedralsAroundBond(int atom2Id, int atom3Id) {
+    const int* neighbors2 = getNeighbors(atom2Id);
+    const int* neighbors3 = getNeighbors(atom3Id);
+
+    for (int a = 0; a < degree[atom2Id]; ++a) {
+        int atom1Id = neighbors2[a];
+        if (atom1Id == atom3Id) continue;
+
+        for (int b = 0; b < degree[atom3Id]; ++b) {
+            int atom4Id = neighbors3[b];
+            if (atom4Id == atom2Id || atom4Id == atom1Id) continue;
+            addDihedral(atom1Id, atom2Id, atom3Id, atom4Id);
+        }
+    }
+}
+
+void TopologyBuilder::updateImproperCandidate(int atomId) {
+    int existing = improperOfAtom[atomId];
+
+    if (degree[atomId] == 3) {
+        const int* neighbors = getNeighbors(atomId);
+        ImproperCandidate candidate = {atomId, neighbors[0], neighbors[1], neighbors[2]};
+        if (existing >= 0) {
+            impropers[existing] = candidate;
+        } else {
+            improperOfAtom[atomId] = static_cast<int>(impropers.size());
+            impropers.push_back(candidate);
+        }
+        return;
+    }
+
+    if (existing >= 0) {
+        int last = static_cast<int>(impropers.size()) - 1;
+        if (existing != last) {
+            impropers[existing] = impropers[last];
+            improperOfAtom[impropers[existing].centralAtomId] = existing;
+        }
+        impropers.pop_back();
+        improperOfAtom[atomId] = -1;
+    }
+}
+
+void TopologyBuilder::addBond(const BondData& bond) {
+    const int j = bond.atom1Id;
+    const int k = bond.atom2Id;
+    checkAtomId(j);
+    checkAtomId(k);
+    if (j == k) {
+        throw std::runtime_error("Bond connects atom " + std::to_string(j) + " to itself");
+    }
+    if (areBonded(j, k)) {
+        throw std::runtime_error("Atoms " + std::to_string(j) + " and " + std::to_string(k) +
+                                 " are already bonded");
+    }
+
+    // Angles and dihedrals that end in the new bond, enumerated before it
+    // is part of the adjacency so that nothing is produced twice.
+    for (int end = 0; end < 2; ++end) {
+        const int near = end == 0 ? j : k;
+        const int far = end == 0 ? k : j;
+        const int* neighbors = getNeighbors(near);
+
+        for (int a = 0; a < degree[near]; ++a) {
+            const int middle = neighbors[a];
+            addAngle(far, near, middle);
+
+            const int* outer = getNeighbors(middle);
+            for (int b = 0; b < degree[middle]; ++b) {
+                if (outer[b] == near || outer[b] == far) continue;
+                addDihedral(far, near, middle, outer[b]);
+            }
+        }
+    }
+
+    bonds.push_back(bond);
+    if (degree[j] == capacity[j]) growSlots(j);
+    if (degree[k] == capacity[k]) growSlots(k);
+    adjacency[offsets[j] + degree[j]++] = k;
+    adjacency[offsets[k] + degree[k]++] = j;
+
+    addDihedralsAroundBond(j, k);
+
+    updateImproperCandidate(j);
+    updateImproperCandidate(k);
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vector>
+#include "bonded_interactions.h"
+
+struct ImproperCandidate {
+    int centralAtomId;
+    int atom2Id;
+    int atom3Id;
+    int atom4Id;
+};
+
+// Enumerates angles, proper dihedrals and improper candidates (atoms with
+// exactly three bonded neighbors) from a bond list. The adjacency is CSR
+// with a few spare slots per atom so that addBond() only touches the
+// neighborhood of the new bond; an atom that runs out of slots moves its
+// neighbors to the end with twice the capacity, so adding bonds one at a
+// time stays amortized constant per bond plus the enumeration around it.
+// Generated terms carry zero parameters.
+class TopologyBuilder {
+public:
+
+    TopologyBuilder(int numAtoms, const std::vector<BondData>& bonds);
+
+    void addBond(const BondData& bond);
+
+    int getNumAtoms() const { return numAtoms; }
+
+    int getDegree(int atomId) const { return degree[atomId]; }
+
+    const int* getNeighbors(int atomId) const { return &adjacency[offsets[atomId]]; }
+
+    bool areBonded(int atom1Id, int atom2Id) const;
+
+    const std::vector<BondData>& getBonds() const { return bonds; }
+
+    const std::vector<AngleData>& getAngles() const { return angles; }
+
+    const std::vector<DihedralData>& getDihedrals() const { return dihedrals; }
+
+    const std::vector<ImproperCandidate>& getImproperCandidates() const { return impropers; }
+
+private:
+
+    static constexpr int SPARE_SLOTS = 2;
+
+    void buildAdjacency(int spareSlots);
+
+    void growSlots(int atomId);
+
+    void updateImproperCandidate(int atomId);
+
+    void addAngle(int atom1Id, int atom2Id, int atom3Id);
+
+    void addDihedral(int atom1Id, int atom2Id, int atom3Id, int atom4Id);
+
+    void addDihedralsAroundBond(int atom2Id, int atom3Id);
+
+    void checkAtomId(int atomId) const;
+
+    int numAtoms;
+    std::vector<BondData> bonds;
+    std::vector<int> offsets;
+    std::vector<int> capacity;
+    std::vector<int> degree;
+    std::vector<int> adjacency;
+
+    std::vector<AngleData> angles;
+    std::vector<DihedralData> dihedrals;
+    std::vector<ImproperCandidate> impropers;
+    std::vector<int> improperOfAtom;
+};
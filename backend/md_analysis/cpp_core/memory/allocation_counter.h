@@ -0,0 +1,38 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Counts heap allocations made by the scratch arenas and reusable step
+// buffers. In steady-state MD this should stop increasing after the first
+// few steps. Only allocations the callers report are seen; the
+// allocation_checks test counts every operator new instead.
+class AllocationCounter {
+public:
+
+    static void recordHeapAllocation() {
+        counter().fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static uint64_t getCount() {
+        return counter().load(std::memory_order_relaxed);
+    }
+
+    static void reset() {
+        counter().store(0, std::memory_order_relaxed);
+    }
+
+    template <typename Vector>
+    static void recordGrowth(const Vector& vector, size_t previousCapacity) {
+        if (vector.capacity() != previousCapacity) {
+            recordHeapAllocation();
+        }
+    }
+
+private:
+
+    static std::atomic<uint64_t>& counter() {
+        static std::atomic<uint64_t> count{0};
+        return count;
+    }
+};
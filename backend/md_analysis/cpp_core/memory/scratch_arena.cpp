@@ -0,0 +1,70 @@
+#include "scratch_arena.h"
+#include "allocation_counter.h"
+#include <cstdint>
+
+ScratchArena::ScratchArena(size_t blockSize) : blockSize(blockSize) {
+    blocks.reserve(16);
+}
+
+void ScratchArena::addBlock(size_t minimumSize) {
+    size_t size = minimumSize > blockSize ? minimumSize : blockSize;
+    blocks.push_back({std::unique_ptr<unsigned char[]>(new unsigned char[size]), size});
+    AllocationCounter::recordHeapAllocation();
+}
+
+void* ScratchArena::allocateBytes(size_t bytes, size_t alignment) {
+    if (bytes == 0) bytes = 1;
+
+    while (true) {
+        if (currentBlock < blocks.size()) {
+            Block& block = blocks[currentBlock];
+            uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+            uintptr_t aligned = (base + offset + alignment - 1) & ~(uintptr_t(alignment) - 1);
+            size_t end = static_cast<size_t>(aligned - base) + bytes;
+
+            if (end <= block.size) {
+                offset = end;
+                return reinterpret_cast<void*>(aligned);
+            }
+
+            bytesInFullBlocks += offset;
+            ++currentBlock;
+            offset = 0;
+            continue;
+        }
+
+        addBlock(bytes + alignment);
+    }
+}
+
+void ScratchArena::reset() {
+    if (blocks.size() > 1) {
+        size_t total = 0;
+        for (const auto& block : blocks) {
+            total += block.size;
+        }
+        blocks.clear();
+        addBlock(total);
+    }
+
+    currentBlock = 0;
+    offset = 0;
+    bytesInFullBlocks = 0;
+}
+
+size_t ScratchArena::getBytesInUse() const {
+    return bytesInFullBlocks + offset;
+}
+
+size_t ScratchArena::getCapacity() const {
+    size_t total = 0;
+    for (const auto& block : blocks) {
+        total += block.size;
+    }
+    return total;
+}
+
+ScratchArena& ScratchArena::forThread() {
+    thread_local ScratchArena arena;
+    return arena;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Bump allocator for per-step scratch memory. Allocations are only
+// released all at once by reset(); if a step needed more than one block,
+// reset() replaces them with a single block large enough for the whole
+// step, so the following steps do not touch the heap.
+class ScratchArena {
+public:
+
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 1 << 20;
+    static constexpr size_t DEFAULT_ALIGNMENT = 64;
+
+    explicit ScratchArena(size_t blockSize = DEFAULT_BLOCK_SIZE);
+
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    template <typename T>
+    T* allocate(size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value,
+                      "ScratchArena only holds trivially destructible types");
+        size_t alignment = alignof(T) > DEFAULT_ALIGNMENT ? alignof(T) : DEFAULT_ALIGNMENT;
+        return static_cast<T*>(allocateBytes(count * sizeof(T), alignment));
+    }
+
+    template <typename T>
+    T* allocateZeroed(size_t count) {
+        T* data = allocate<T>(count);
+        for (size_t i = 0; i < count; ++i) {
+            data[i] = T(0);
+        }
+        return data;
+    }
+
+    void* allocateBytes(size_t bytes, size_t alignment = DEFAULT_ALIGNMENT);
+
+    void reset();
+
+    size_t getBytesInUse() const;
+
+    size_t getCapacity() const;
+
+    static ScratchArena& forThread();
+
+    // Hands everything allocated during its lifetime back to the arena on
+    // destruction, for functions that draw scratch memory without owning
+    // the arena's reset(). The arena must not be reset inside a scope.
+    class Scope {
+    public:
+
+        explicit Scope(ScratchArena& arena)
+            : arena(arena),
+              currentBlock(arena.currentBlock),
+              offset(arena.offset),
+              bytesInFullBlocks(arena.bytesInFullBlocks) {}
+
+        ~Scope() {
+            arena.currentBlock = currentBlock;
+            arena.offset = offset;
+            arena.bytesInFullBlocks = bytesInFullBlocks;
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        ScratchArena& arena;
+        size_t currentBlock;
+        size_t offset;
+        size_t bytesInFullBlocks;
+    };
+
+private:
+
+    struct Block {
+        std::unique_ptr<unsigned char[]> data;
+        size_t size;
+    };
+
+    void addBlock(size_t minimumSize);
+
+    std::vector<Block> blocks;
+    size_t blockSize;
+    size_t currentBlock = 0;
+    size_t offset = 0;
+    size_t bytesInFullBlocks = 0;
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Single-producer single-consumer triple buffer. The writer fills
+// getWriteBuffer() and publish()es it; the reader calls update() and then
+// reads getReadBuffer() for as long as it likes. Neither side ever waits,
+// and the writer never touches the slot the reader is holding.
+template <typename T>
+class TripleBuffer {
+public:
+
+    T& getWriteBuffer() { return slots[backIndex]; }
+
+    void publish() {
+        uint8_t previous = middle.exchange(
+            static_cast<uint8_t>(backIndex | FRESH_BIT), std::memory_order_acq_rel);
+        backIndex = previous & INDEX_MASK;
+    }
+
+    bool update() {
+        if ((middle.load(std::memory_order_acquire) & FRESH_BIT) == 0) return false;
+        uint8_t previous = middle.exchange(frontIndex, std::memory_order_acq_rel);
+        frontIndex = previous & INDEX_MASK;
+        return true;
+    }
+
+    const T& getReadBuffer() const { return slots[frontIndex]; }
+
+    // Only safe while neither side is active, e.g. to size every slot
+    // before the writer thread starts.
+    template <typename Function>
+    void forEachSlot(Function&& function) {
+        for (auto& slot : slots) function(slot);
+    }
+
+private:
+
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    static constexpr uint8_t FRESH_BIT = 0x4;
+
+    std::array<T, 3> slots;
+    alignas(64) std::atomic<uint8_t> middle{1};
+    alignas(64) uint8_t backIndex = 0;
+    alignas(64) uint8_t frontIndex = 2;
+};
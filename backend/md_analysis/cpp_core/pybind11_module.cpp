@@ -1,12 +1,86 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 #include <pybind11/operators.h>
+#include <pybind11/numpy.h>
+#include <pybind11/functional.h>
+#include <algorithm>
+#include <stdexcept>
 #include "radii_lists.h"
 #include "nonbond_interactions.h"
 #include "bonded_interactions.h"
+#include "precision.h"
+#include "pair_table.h"
+#include "system.h"
+#include "checkpoint.h"
+#include "structure_loader.h"
+#include "trajectory_analysis.h"
+#include "force_verification.h"
+#include "incremental_energy.h"
+#include "simulation_runner.h"
+#include "replica_exchange.h"
+#include "topology_builder.h"
+#include "allocation_counter.h"
+#include "scratch_arena.h"
 
 namespace py = pybind11;
 
+using DoubleArray = py::array_t<double, py::array::c_style | py::array::forcecast>;
+using IntArray = py::array_t<int, py::array::c_style | py::array::forcecast>;
+
+// System may hold its particles in spatially sorted order; rows of the
+// arrays exchanged with Python are always in insertion order.
+static py::array_t<double> packVectors(
+    const std::vector<double>& x,
+    const std::vector<double>& y,
+    const std::vector<double>& z,
+    const std::vector<int>& originalId) {
+
+    py::array_t<double> result({static_cast<py::ssize_t>(x.size()), static_cast<py::ssize_t>(3)});
+    auto view = result.mutable_unchecked<2>();
+    for (size_t i = 0; i < x.size(); ++i) {
+        view(originalId[i], 0) = x[i];
+        view(originalId[i], 1) = y[i];
+        view(originalId[i], 2) = z[i];
+    }
+    return result;
+}
+
+static void unpackVectors(
+    const DoubleArray& values,
+    std::vector<double>& x,
+    std::vector<double>& y,
+    std::vector<double>& z,
+    const std::vector<int>& originalId) {
+
+    if (values.ndim() != 2 || values.shape(1) != 3 ||
+        static_cast<size_t>(values.shape(0)) != x.size()) {
+        throw std::runtime_error("Expected an array of shape (num_atoms, 3)");
+    }
+    auto view = values.unchecked<2>();
+    for (size_t i = 0; i < x.size(); ++i) {
+        x[i] = view(originalId[i], 0);
+        y[i] = view(originalId[i], 1);
+        z[i] = view(originalId[i], 2);
+    }
+}
+
+// Accepts a single (N, 3) frame or an (F, N, 3) block of frames.
+static FrameBlock toFrameBlock(const DoubleArray& frames) {
+    if (frames.ndim() == 2 && frames.shape(1) == 3) {
+        return {frames.data(), 1, static_cast<int>(frames.shape(0))};
+    }
+    if (frames.ndim() == 3 && frames.shape(2) == 3) {
+        return {frames.data(), static_cast<int>(frames.shape(0)), static_cast<int>(frames.shape(1))};
+    }
+    throw std::runtime_error("Expected frames of shape (num_frames, num_atoms, 3) or (num_atoms, 3)");
+}
+
+static py::array_t<double> toArray(const std::vector<double>& values) {
+    py::array_t<double> result(static_cast<py::ssize_t>(values.size()));
+    std::copy(values.begin(), values.end(), result.mutable_data());
+    return result;
+}
+
 PYBIND11_MODULE(molecular_interactions, m) {
     m.doc() = "C++ molecular interaction calculations with pybind11";
     
@@ -19,6 +93,10 @@ PYBIND11_MODULE(molecular_interactions, m) {
                    "Get Coulomb interaction radius for an element")
         .def_static("get_atomic_number", &RadiiLists::getAtomicNumber,
                    "Get atomic number for an element")
+        .def_static("get_atomic_mass", &RadiiLists::getAtomicMass,
+                   "Get standard atomic mass (amu) for an element")
+        .def_static("get_gb_screening_scale", &RadiiLists::getGbScreeningScale,
+                   "Get the Generalized Born screening scale for an element")
         .def_static("has_element", &RadiiLists::hasElement,
                    "Check if element exists in radii tables")
         .def_static("get_vdw_radii_dict", []() {
@@ -60,14 +138,20 @@ PYBIND11_MODULE(molecular_interactions, m) {
     
     py::class_<NonbondedInteractions>(m, "NonbondedInteractions", 
                                       "Nonbonded interaction calculations")
-        .def_static("get_neighbor_list", &NonbondedInteractions::getNeighborList,
+        .def_static("get_neighbor_list",
+                   py::overload_cast<const std::vector<MoleculeData>&, const AtomData&, double>(
+                       &NonbondedInteractions::getNeighborList),
                    py::arg("simulation_space"),
                    py::arg("atom"),
                    py::arg("cutoff_distance") = 0.55,
                    "Get neighbor list for an atom")
-        .def_static("get_electrostatic_list", &NonbondedInteractions::getElectrostaticList,
+        .def_static("get_electrostatic_list",
+                   py::overload_cast<const std::vector<std::shared_ptr<AtomData>>&, const AtomData&, double>(
+                       &NonbondedInteractions::getElectrostaticList),
                    "Get electrostatic neighbors")
-        .def_static("get_vdw_list", &NonbondedInteractions::getVdwList,
+        .def_static("get_vdw_list",
+                   py::overload_cast<const std::vector<std::shared_ptr<AtomData>>&, const AtomData&, double>(
+                       &NonbondedInteractions::getVdwList),
                    "Get van der Waals neighbors")
         .def_static("calculate_lennard_jones", &NonbondedInteractions::calculateLennardJones,
                    py::arg("atom1"),
@@ -130,6 +214,15 @@ PYBIND11_MODULE(molecular_interactions, m) {
         .def_readwrite("barrier_height", &DihedralData::barrierHeight)
         .def_readwrite("phase_offset", &DihedralData::phaseOffset);
     
+    py::class_<ImproperData>(m, "ImproperData", "Harmonic improper torsion, central atom first")
+        .def(py::init<>())
+        .def_readwrite("atom1_id", &ImproperData::atom1Id)
+        .def_readwrite("atom2_id", &ImproperData::atom2Id)
+        .def_readwrite("atom3_id", &ImproperData::atom3Id)
+        .def_readwrite("atom4_id", &ImproperData::atom4Id)
+        .def_readwrite("equilibrium_angle", &ImproperData::equilibriumAngle)
+        .def_readwrite("force_constant", &ImproperData::forceConstant);
+    
     py::class_<BondedInteractions>(m, "BondedInteractions",
                                    "Bonded interaction calculations")
         .def_static("calculate_bond_energy", &BondedInteractions::calculateBondEnergy,
@@ -146,6 +239,8 @@ PYBIND11_MODULE(molecular_interactions, m) {
                    "Calculate dihedral torque")
         .def_static("calculate_improper_energy", &BondedInteractions::calculateImproperEnergy,
                    "Calculate improper dihedral energy")
+        .def_static("calculate_improper_torque", &BondedInteractions::calculateImproperTorque,
+                   "Calculate improper dihedral torque")
         .def_static("calculate_bond_length", 
                    (double (*)(const std::array<double, 3>&, const std::array<double, 3>&))
                    &BondedInteractions::calculateBondLength,
@@ -162,7 +257,9 @@ PYBIND11_MODULE(molecular_interactions, m) {
                                const std::array<double, 3>&,
                                const std::array<double, 3>&))
                    &BondedInteractions::calculateDihedral,
-                   "Calculate dihedral angle between four atoms");
+                   "Calculate dihedral angle between four atoms")
+        .def_static("calculate_improper", &BondedInteractions::calculateImproper,
+                   "Calculate improper angle with the first atom central");
     
     py::class_<BondedInteractions::BondedEnergy>(m, "BondedEnergy",
                                                  "Bonded energy components")
@@ -178,5 +275,579 @@ PYBIND11_MODULE(molecular_interactions, m) {
          py::arg("angles"),
          py::arg("dihedrals"),
          py::arg("positions"),
+         py::arg("impropers") = std::vector<ImproperData>(),
          "Calculate total bonded energy");
+    
+    py::class_<AllocationCounter>(m, "AllocationCounter",
+                                  "Heap allocations made by scratch arenas and step buffers")
+        .def_static("get_count", &AllocationCounter::getCount,
+                   "Number of heap allocations recorded since the last reset")
+        .def_static("reset", &AllocationCounter::reset,
+                   "Reset the allocation count")
+        .def_static("get_thread_arena_capacity", []() {
+            return ScratchArena::forThread().getCapacity();
+        }, "Bytes reserved by the calling thread's scratch arena");
+    
+    py::enum_<PrecisionMode>(m, "PrecisionMode", "Scalar types used by the force kernels")
+        .value("DOUBLE", PrecisionMode::Double)
+        .value("SINGLE", PrecisionMode::Single)
+        .value("MIXED", PrecisionMode::Mixed);
+    
+    py::enum_<CutoffModifier>(m, "CutoffModifier", "Treatment of tabulated potentials at the cutoff")
+        .value("NONE", CutoffModifier::None)
+        .value("SWITCH", CutoffModifier::Switch)
+        .value("FORCE_SHIFT", CutoffModifier::ForceShift);
+    
+    py::class_<PairTable>(m, "PairTable", "Cubic spline of a pair potential in r^2")
+        .def(py::init<const PairPotentialFunction&, double, double, int, CutoffModifier, double>(),
+             py::arg("potential"),
+             py::arg("inner_distance"),
+             py::arg("cutoff_distance"),
+             py::arg("num_intervals") = 4096,
+             py::arg("modifier") = CutoffModifier::None,
+             py::arg("switch_distance") = 0.0,
+             "Tabulate potential(r) -> (energy, dU/dr)")
+        .def_static("lennard_jones", &PairTable::lennardJones,
+                    py::arg("sigma"),
+                    py::arg("epsilon"),
+                    py::arg("cutoff_distance"),
+                    py::arg("modifier") = CutoffModifier::None,
+                    py::arg("switch_distance") = 0.0,
+                    py::arg("num_intervals") = 4096)
+        .def_static("coulomb", &PairTable::coulomb,
+                    py::arg("cutoff_distance"),
+                    py::arg("modifier") = CutoffModifier::None,
+                    py::arg("switch_distance") = 0.0,
+                    py::arg("num_intervals") = 4096,
+                    "Tabulate 1/r, scaled by q_i q_j times the Coulomb constant when used")
+        .def("evaluate", [](const PairTable& table, double r) {
+            std::array<double, 2> value = table.evaluate(r * r);
+            return std::make_pair(value[0], value[1] * r);
+        }, py::arg("r"), "Return (energy, force magnitude) at separation r")
+        .def_property_readonly("inner_distance", &PairTable::getInnerDistance)
+        .def_property_readonly("cutoff_distance", &PairTable::getCutoffDistance)
+        .def_property_readonly("num_intervals", &PairTable::getNumIntervals);
+    
+    py::class_<PairTableSet>(m, "PairTableSet", "Pair tables indexed by atom type pair")
+        .def(py::init<int>(), py::arg("num_types"))
+        .def("set_table", &PairTableSet::setTable,
+             py::arg("type_i"),
+             py::arg("type_j"),
+             py::arg("table"))
+        .def("set_coulomb_table", &PairTableSet::setCoulombTable, py::arg("table"))
+        .def("has_table", &PairTableSet::hasTable)
+        .def_property_readonly("has_coulomb_table", &PairTableSet::hasCoulombTable)
+        .def_property_readonly("num_types", &PairTableSet::getNumTypes)
+        .def_property_readonly("cutoff_distance", &PairTableSet::getCutoffDistance);
+    
+    py::class_<SystemEnergy>(m, "SystemEnergy", "Energy components of a System")
+        .def(py::init<>())
+        .def_readwrite("bonded", &SystemEnergy::bonded)
+        .def_readwrite("nonbonded", &SystemEnergy::nonbonded)
+        .def_readwrite("solvation", &SystemEnergy::solvation)
+        .def_readwrite("kinetic", &SystemEnergy::kinetic)
+        .def_readwrite("potential", &SystemEnergy::potential)
+        .def_readwrite("total", &SystemEnergy::total);
+    
+    py::class_<GeneralizedBornOptions>(m, "GeneralizedBornOptions", "Settings of the GB-OBC implicit solvent")
+        .def(py::init<>())
+        .def_readwrite("solvent_dielectric", &GeneralizedBornOptions::solventDielectric)
+        .def_readwrite("radius_offset", &GeneralizedBornOptions::radiusOffset)
+        .def_readwrite("alpha", &GeneralizedBornOptions::alpha)
+        .def_readwrite("beta", &GeneralizedBornOptions::beta)
+        .def_readwrite("gamma", &GeneralizedBornOptions::gamma)
+        .def_readwrite("num_threads", &GeneralizedBornOptions::numThreads);
+
+    py::class_<System>(m, "System", "Particle system integrated with velocity Verlet")
+        .def(py::init<>())
+        .def("add_atom", &System::addAtom,
+             py::arg("element"),
+             py::arg("position"),
+             py::arg("mass"),
+             py::arg("charge") = 0.0,
+             py::arg("sigma") = 0.0,
+             py::arg("epsilon") = 0.0,
+             "Add an atom and return its index")
+        .def("reserve", &System::reserve, py::arg("num_atoms"), py::arg("num_bonds") = 0,
+             "Reserve storage ahead of adding many atoms")
+        .def("add_bond", &System::addBond, py::arg("bond"), "Add a bond term")
+        .def("add_angle", &System::addAngle, py::arg("angle"), "Add an angle term")
+        .def("add_dihedral", &System::addDihedral, py::arg("dihedral"), "Add a dihedral term")
+        .def("add_improper", &System::addImproper, py::arg("improper"), "Add an improper term")
+        .def_property("box_length", &System::getBoxLength, &System::setBoxLength,
+                      "Periodic box edge lengths, zero for open boundaries")
+        .def("set_cutoff", &System::setCutoff,
+             py::arg("cutoff_distance"),
+             py::arg("skin_distance") = 2.0,
+             "Set the nonbonded cutoff and neighbor list skin")
+        .def_property("dielectric_constant", &System::getDielectricConstant,
+                      &System::setDielectricConstant)
+        .def_property("precision_mode", &System::getPrecisionMode, &System::setPrecisionMode,
+                      "Default precision mode for force evaluation")
+        .def("compute_forces", py::overload_cast<>(&System::computeForces),
+             "Compute forces and energies in the system precision mode")
+        .def("compute_forces", py::overload_cast<PrecisionMode>(&System::computeForces),
+             py::arg("mode"),
+             "Compute forces and energies in the given precision mode")
+        .def("step", &System::step,
+             py::arg("num_steps"),
+             py::arg("timestep"),
+             "Advance the system with velocity Verlet (timestep in fs)")
+        .def("compute_kinetic_energy", &System::computeKineticEnergy)
+        .def("sort_atoms", &System::sortAtoms,
+             "Reorder the particle arrays along a Morton curve")
+        .def_property("sort_interval", &System::getSortInterval, &System::setSortInterval,
+                      "Steps between spatial sorts during step(), 0 to disable")
+        .def_property_readonly("step_count", &System::getStepCount)
+        .def_property_readonly("num_atoms", &System::getNumAtoms)
+        .def("set_atom_type", &System::setAtomType, py::arg("atom_id"), py::arg("type"))
+        .def("get_atom_type", &System::getAtomType, py::arg("atom_id"))
+        .def("set_pair_tables", [](System& system, const PairTableSet& tables) {
+            system.setPairTables(std::make_shared<const PairTableSet>(tables));
+        }, py::arg("tables"),
+           "Evaluate nonbonded forces from a copy of the given tables")
+        .def("use_tabulated_lennard_jones", &System::useTabulatedLennardJones,
+             py::arg("modifier"),
+             py::arg("switch_distance") = 0.0,
+             py::arg("num_intervals") = 4096,
+             "Tabulate LJ per distinct (sigma, epsilon) and Coulomb at the current cutoff")
+        .def("clear_pair_tables", &System::clearPairTables)
+        .def("set_implicit_solvent", &System::setImplicitSolvent,
+             py::arg("options") = GeneralizedBornOptions(),
+             "Add Generalized Born (OBC) solvation with radii from the VDW radii table")
+        .def("clear_implicit_solvent", &System::clearImplicitSolvent)
+        .def_property_readonly("has_implicit_solvent", &System::hasImplicitSolvent)
+        .def_property_readonly("implicit_solvent_options", &System::getImplicitSolventOptions)
+        .def("get_born_radii", [](const System& system) {
+            const auto& radii = system.getBornRadii();
+            const auto& originalId = system.getParticles().originalId;
+            std::vector<double> ordered(radii.size());
+            for (size_t k = 0; k < radii.size(); ++k) {
+                ordered[originalId[k]] = radii[k];
+            }
+            return toArray(ordered);
+        }, "Effective Born radii (A) of the last force evaluation; empty without implicit solvent")
+        .def("shares_topology_with", &System::sharesTopologyWith, py::arg("other"),
+             "True if both systems read the same topology and exclusion storage")
+        .def("save_checkpoint", [](const System& system, const std::string& path) {
+            Checkpoint::save(system, path);
+        }, py::arg("path"),
+           "Atomically write the full simulation state to a binary checkpoint")
+        .def_static("load_checkpoint", &Checkpoint::load, py::arg("path"),
+                    "Restore a System from a checkpoint written by save_checkpoint")
+        .def("get_positions", [](const System& system) {
+            const auto& particles = system.getParticles();
+            return packVectors(particles.x, particles.y, particles.z, particles.originalId);
+        }, "Get positions as an (N, 3) array")
+        .def("set_positions", [](System& system, const DoubleArray& positions) {
+            auto& particles = system.getParticles();
+            unpackVectors(positions, particles.x, particles.y, particles.z, particles.originalId);
+            system.markPositionsChanged();
+        }, py::arg("positions"), "Set positions from an (N, 3) array")
+        .def("get_velocities", [](const System& system) {
+            const auto& particles = system.getParticles();
+            return packVectors(particles.vx, particles.vy, particles.vz, particles.originalId);
+        }, "Get velocities as an (N, 3) array")
+        .def("set_velocities", [](System& system, const DoubleArray& velocities) {
+            auto& particles = system.getParticles();
+            unpackVectors(velocities, particles.vx, particles.vy, particles.vz, particles.originalId);
+        }, py::arg("velocities"), "Set velocities from an (N, 3) array")
+        .def("get_forces", [](const System& system) {
+            const auto& particles = system.getParticles();
+            return packVectors(particles.fx, particles.fy, particles.fz, particles.originalId);
+        }, "Get forces from the last evaluation as an (N, 3) array");
+    
+    py::class_<IncrementalEnergy>(m, "IncrementalEnergy",
+                                  "Energy changes of single-atom moves and bond rotations")
+        .def(py::init<System&>(), py::arg("system"), py::keep_alive<1, 2>())
+        .def("rebuild", &IncrementalEnergy::rebuild,
+             "Recompute all cached energy contributions")
+        .def("get_total_energy", &IncrementalEnergy::getTotalEnergy,
+             "Cached total potential energy")
+        .def("get_atom_energy", &IncrementalEnergy::getAtomEnergy,
+             py::arg("atom_id"),
+             "Potential energy attributed to one atom")
+        .def("propose_atom_move", &IncrementalEnergy::proposeAtomMove,
+             py::arg("atom_id"),
+             py::arg("new_position"),
+             "Tentatively move one atom and return the energy change")
+        .def("propose_bond_rotation", &IncrementalEnergy::proposeBondRotation,
+             py::arg("bond_index"),
+             py::arg("angle"),
+             "Tentatively rotate the atoms behind a rotatable bond and return the energy change")
+        .def("commit", &IncrementalEnergy::commit, "Accept the proposed move")
+        .def("reject", &IncrementalEnergy::reject, "Undo the proposed move")
+        .def_property_readonly("has_pending_move", &IncrementalEnergy::hasPendingMove);
+    
+    py::class_<SimulationRunner>(m, "SimulationRunner",
+                                 "Runs a System on a worker thread and publishes snapshots")
+        .def(py::init<System&, double, int>(),
+             py::arg("system"),
+             py::arg("timestep"),
+             py::arg("steps_per_frame") = 10,
+             py::keep_alive<1, 2>())
+        .def("start", &SimulationRunner::start, "Start the worker thread")
+        .def("pause", &SimulationRunner::pause, "Pause after the current frame")
+        .def("resume", &SimulationRunner::resume, "Resume continuous stepping")
+        .def("step", &SimulationRunner::step, py::arg("num_steps"),
+             "Pause and advance by the given number of steps")
+        .def("stop", &SimulationRunner::stop, py::call_guard<py::gil_scoped_release>(),
+             "Stop and join the worker thread")
+        .def_property_readonly("is_running", &SimulationRunner::isRunning)
+        .def_property_readonly("is_paused", &SimulationRunner::isPaused)
+        .def_property("steps_per_frame", &SimulationRunner::getStepsPerFrame,
+                      &SimulationRunner::setStepsPerFrame)
+        .def("poll", &SimulationRunner::poll,
+             "Take the newest published snapshot; returns False if nothing new")
+        .def("get_positions", [](const SimulationRunner& runner) {
+            // Copied, since the writer reuses the slot once the next poll hands it back.
+            const auto& positions = runner.getSnapshot().positions;
+            py::array_t<double> result({static_cast<py::ssize_t>(positions.size() / 3), static_cast<py::ssize_t>(3)});
+            std::copy(positions.begin(), positions.end(), result.mutable_data());
+            return result;
+        }, "(N, 3) copy of the positions in the polled snapshot")
+        .def("get_energy", [](const SimulationRunner& runner) {
+            return runner.getSnapshot().energy;
+        }, "Energy components of the polled snapshot")
+        .def_property_readonly("snapshot_step", [](const SimulationRunner& runner) {
+            return runner.getSnapshot().step;
+        })
+        .def_property_readonly("snapshot_time", [](const SimulationRunner& runner) {
+            return runner.getSnapshot().time;
+        })
+        .def("get_error", &SimulationRunner::getError,
+             "Message of the exception that stopped the worker, if any");
+    
+    py::class_<ImproperCandidate>(m, "ImproperCandidate", "Atom with exactly three bonded neighbors")
+        .def(py::init<>())
+        .def_readwrite("central_atom_id", &ImproperCandidate::centralAtomId)
+        .def_readwrite("atom2_id", &ImproperCandidate::atom2Id)
+        .def_readwrite("atom3_id", &ImproperCandidate::atom3Id)
+        .def_readwrite("atom4_id", &ImproperCandidate::atom4Id);
+    
+    py::class_<TopologyBuilder>(m, "TopologyBuilder",
+                                "Generates angles, dihedrals and improper candidates from bonds")
+        .def(py::init<int, const std::vector<BondData>&>(),
+             py::arg("num_atoms"),
+             py::arg("bonds"))
+        .def(py::init([](int numAtoms, const IntArray& pairs) {
+            if (pairs.ndim() != 2 || pairs.shape(1) != 2) {
+                throw std::runtime_error("Expected bond pairs of shape (num_bonds, 2)");
+            }
+            auto view = pairs.unchecked<2>();
+            std::vector<BondData> bonds(static_cast<size_t>(pairs.shape(0)));
+            for (size_t b = 0; b < bonds.size(); ++b) {
+                bonds[b] = {view(b, 0), view(b, 1), 1, 0.0, 0.0, true};
+            }
+            return new TopologyBuilder(numAtoms, bonds);
+        }), py::arg("num_atoms"), py::arg("bond_pairs"),
+            "Build from an integer array of atom index pairs")
+        .def("add_bond", &TopologyBuilder::addBond, py::arg("bond"),
+             "Add one bond and generate only the terms it creates")
+        .def("are_bonded", &TopologyBuilder::areBonded)
+        .def_property_readonly("num_atoms", &TopologyBuilder::getNumAtoms)
+        .def_property_readonly("bonds", &TopologyBuilder::getBonds)
+        .def_property_readonly("angles", &TopologyBuilder::getAngles)
+        .def_property_readonly("dihedrals", &TopologyBuilder::getDihedrals)
+        .def_property_readonly("improper_candidates", &TopologyBuilder::getImproperCandidates)
+        .def("get_neighbors", [](const TopologyBuilder& builder, int atomId) {
+            if (atomId < 0 || atomId >= builder.getNumAtoms()) {
+                throw std::runtime_error("Atom index " + std::to_string(atomId) + " out of range");
+            }
+            const int* neighbors = builder.getNeighbors(atomId);
+            return std::vector<int>(neighbors, neighbors + builder.getDegree(atomId));
+        }, py::arg("atom_id"))
+        .def("get_angle_indices", [](const TopologyBuilder& builder) {
+            const auto& angles = builder.getAngles();
+            py::array_t<int> result({static_cast<py::ssize_t>(angles.size()), static_cast<py::ssize_t>(3)});
+            auto view = result.mutable_unchecked<2>();
+            for (size_t t = 0; t < angles.size(); ++t) {
+                view(t, 0) = angles[t].atom1Id;
+                view(t, 1) = angles[t].atom2Id;
+                view(t, 2) = angles[t].atom3Id;
+            }
+            return result;
+        }, "Angle atom indices as an (A, 3) array")
+        .def("get_dihedral_indices", [](const TopologyBuilder& builder) {
+            const auto& dihedrals = builder.getDihedrals();
+            py::array_t<int> result({static_cast<py::ssize_t>(dihedrals.size()), static_cast<py::ssize_t>(4)});
+            auto view = result.mutable_unchecked<2>();
+            for (size_t t = 0; t < dihedrals.size(); ++t) {
+                view(t, 0) = dihedrals[t].atom1Id;
+                view(t, 1) = dihedrals[t].atom2Id;
+                view(t, 2) = dihedrals[t].atom3Id;
+                view(t, 3) = dihedrals[t].atom4Id;
+            }
+            return result;
+        }, "Dihedral atom indices as a (D, 4) array")
+        .def("get_improper_indices", [](const TopologyBuilder& builder) {
+            const auto& impropers = builder.getImproperCandidates();
+            py::array_t<int> result({static_cast<py::ssize_t>(impropers.size()), static_cast<py::ssize_t>(4)});
+            auto view = result.mutable_unchecked<2>();
+            for (size_t t = 0; t < impropers.size(); ++t) {
+                view(t, 0) = impropers[t].centralAtomId;
+                view(t, 1) = impropers[t].atom2Id;
+                view(t, 2) = impropers[t].atom3Id;
+                view(t, 3) = impropers[t].atom4Id;
+            }
+            return result;
+        }, "Improper candidates as an (I, 4) array, central atom first");
+
+    py::class_<ReplicaExchangeOptions>(m, "ReplicaExchangeOptions", "Settings of a ReplicaExchange run")
+        .def(py::init<>())
+        .def_readwrite("timestep", &ReplicaExchangeOptions::timestep)
+        .def_readwrite("exchange_interval", &ReplicaExchangeOptions::exchangeInterval)
+        .def_readwrite("thermostat_interval", &ReplicaExchangeOptions::thermostatInterval)
+        .def_readwrite("thermostat_time_constant", &ReplicaExchangeOptions::thermostatTimeConstant)
+        .def_readwrite("seed", &ReplicaExchangeOptions::seed)
+        .def_readwrite("num_threads", &ReplicaExchangeOptions::numThreads);
+
+    auto acceptanceRatio = [](const std::vector<long long>& accepts, const std::vector<long long>& attempts) {
+        std::vector<double> ratio(attempts.size(), 0.0);
+        for (size_t k = 0; k < attempts.size(); ++k) {
+            if (attempts[k] > 0) {
+                ratio[k] = static_cast<double>(accepts[k]) / attempts[k];
+            }
+        }
+        return toArray(ratio);
+    };
+
+    py::class_<ReplicaExchange>(m, "ReplicaExchange",
+                                "Parallel tempering over copies of a System sharing one topology")
+        .def(py::init<const System&, const std::vector<double>&, const ReplicaExchangeOptions&>(),
+             py::arg("system"),
+             py::arg("temperatures"),
+             py::arg("options") = ReplicaExchangeOptions())
+        .def("run", &ReplicaExchange::run, py::arg("num_exchanges"),
+             py::call_guard<py::gil_scoped_release>(),
+             "Run num_exchanges rounds of MD followed by swap attempts")
+        .def("get_replica", &ReplicaExchange::getReplica, py::arg("replica"),
+             py::return_value_policy::reference_internal,
+             "Replica System; read-only while run() is not executing")
+        .def_property_readonly("num_replicas", &ReplicaExchange::getNumReplicas)
+        .def_property_readonly("num_threads", &ReplicaExchange::getNumThreads)
+        .def_property_readonly("temperatures", &ReplicaExchange::getTemperatures)
+        .def_property_readonly("temperature_indices", &ReplicaExchange::getTemperatureIndices,
+                               "Temperature index each replica currently runs at")
+        .def_property_readonly("potential_energies", [](const ReplicaExchange& exchange) {
+            return toArray(exchange.getPotentialEnergies());
+        })
+        .def_property_readonly("exchange_count", &ReplicaExchange::getExchangeCount)
+        .def_property_readonly("degrees_of_freedom", &ReplicaExchange::getDegreesOfFreedom)
+        .def_property_readonly("pair_attempts", &ReplicaExchange::getPairAttempts)
+        .def_property_readonly("pair_accepts", &ReplicaExchange::getPairAccepts)
+        .def_property_readonly("replica_attempts", &ReplicaExchange::getReplicaAttempts)
+        .def_property_readonly("replica_accepts", &ReplicaExchange::getReplicaAccepts)
+        .def_property_readonly("pair_acceptance", [acceptanceRatio](const ReplicaExchange& exchange) {
+            return acceptanceRatio(exchange.getPairAccepts(), exchange.getPairAttempts());
+        }, "Swap acceptance ratio between temperatures k and k + 1")
+        .def_property_readonly("replica_acceptance", [acceptanceRatio](const ReplicaExchange& exchange) {
+            return acceptanceRatio(exchange.getReplicaAccepts(), exchange.getReplicaAttempts());
+        }, "Swap acceptance ratio of each replica");
+
+    py::class_<StructureLoadOptions>(m, "StructureLoadOptions", "Parameters given to atoms and bonds read from structure files")
+        .def(py::init<>())
+        .def_readwrite("bond_force_constant", &StructureLoadOptions::bondForceConstant)
+        .def_readwrite("epsilon", &StructureLoadOptions::epsilon);
+
+    py::class_<StructureInfo>(m, "StructureInfo", "Atoms and bonds appended by a structure loader")
+        .def_readonly("first_atom", &StructureInfo::firstAtom)
+        .def_readonly("num_atoms", &StructureInfo::numAtoms)
+        .def_readonly("num_bonds", &StructureInfo::numBonds)
+        .def_readonly("box_length", &StructureInfo::boxLength);
+
+    py::class_<LoaderBenchmark>(m, "LoaderBenchmark", "Best-of-N structure loading throughput")
+        .def_readonly("num_atoms", &LoaderBenchmark::numAtoms)
+        .def_readonly("file_bytes", &LoaderBenchmark::fileBytes)
+        .def_readonly("best_seconds", &LoaderBenchmark::bestSeconds)
+        .def_readonly("atoms_per_second", &LoaderBenchmark::atomsPerSecond)
+        .def_readonly("megabytes_per_second", &LoaderBenchmark::megabytesPerSecond);
+
+    py::class_<StructureLoader>(m, "StructureLoader", "Memory-mapped PDB and XYZ readers that fill a System")
+        .def_static("load_xyz", &StructureLoader::loadXyz,
+                    py::arg("path"),
+                    py::arg("system"),
+                    py::arg("options") = StructureLoadOptions(),
+                    "Append the first frame of an XYZ file to the system")
+        .def_static("load_pdb", &StructureLoader::loadPdb,
+                    py::arg("path"),
+                    py::arg("system"),
+                    py::arg("options") = StructureLoadOptions(),
+                    "Append the first model of a PDB file and its CONECT bonds to the system")
+        .def_static("load", &StructureLoader::load,
+                    py::arg("path"),
+                    py::arg("system"),
+                    py::arg("options") = StructureLoadOptions(),
+                    "Append a .pdb/.ent or .xyz file to the system")
+        .def_static("benchmark", &StructureLoader::benchmark,
+                    py::arg("path"),
+                    py::arg("repeats") = 5,
+                    py::call_guard<py::gil_scoped_release>(),
+                    "Time loading the file into a fresh System, best of repeats");
+
+    py::class_<TrajectoryAnalysis>(m, "TrajectoryAnalysis",
+                                   "Per-frame analysis of (F, N, 3) frame blocks, parallel over frames")
+        .def_static("rmsd", [](const DoubleArray& frames, const DoubleArray& reference,
+                               const std::vector<double>& weights, int numThreads) {
+            FrameBlock block = toFrameBlock(frames);
+            if (reference.size() != 3 * static_cast<py::ssize_t>(block.numAtoms)) {
+                throw std::runtime_error("Reference must have shape (num_atoms, 3)");
+            }
+            std::vector<double> result;
+            {
+                py::gil_scoped_release release;
+                result = TrajectoryAnalysis::rmsd(block, reference.data(), weights, numThreads);
+            }
+            return toArray(result);
+        }, py::arg("frames"),
+           py::arg("reference"),
+           py::arg("weights") = std::vector<double>(),
+           py::arg("num_threads") = 0,
+           "RMSD of each frame to the reference after optimal superposition")
+        .def_static("radial_distribution", [](const DoubleArray& frames,
+                                              const std::array<double, 3>& boxLength,
+                                              double maxDistance,
+                                              int numBins,
+                                              const std::vector<int>& selectionA,
+                                              const std::vector<int>& selectionB,
+                                              int numThreads) {
+            FrameBlock block = toFrameBlock(frames);
+            RadialDistribution rdf;
+            {
+                py::gil_scoped_release release;
+                rdf = TrajectoryAnalysis::radialDistribution(
+                    block, boxLength, maxDistance, numBins, selectionA, selectionB, numThreads);
+            }
+            return py::make_tuple(toArray(rdf.radius), toArray(rdf.g));
+        }, py::arg("frames"),
+           py::arg("box_length"),
+           py::arg("max_distance"),
+           py::arg("num_bins") = 200,
+           py::arg("selection_a") = std::vector<int>(),
+           py::arg("selection_b") = std::vector<int>(),
+           py::arg("num_threads") = 0,
+           "Return (bin centers, g(r)) averaged over the frames")
+        .def_static("kinetic_energy", [](const DoubleArray& velocities,
+                                         const std::vector<double>& masses,
+                                         int numThreads) {
+            FrameBlock block = toFrameBlock(velocities);
+            std::vector<double> result;
+            {
+                py::gil_scoped_release release;
+                result = TrajectoryAnalysis::kineticEnergy(block, masses, numThreads);
+            }
+            return toArray(result);
+        }, py::arg("velocities"),
+           py::arg("masses"),
+           py::arg("num_threads") = 0,
+           "Kinetic energy (kcal/mol) of each velocity frame")
+        .def_static("temperature", [](const DoubleArray& velocities,
+                                      const std::vector<double>& masses,
+                                      int degreesOfFreedom,
+                                      int numThreads) {
+            FrameBlock block = toFrameBlock(velocities);
+            std::vector<double> result;
+            {
+                py::gil_scoped_release release;
+                result = TrajectoryAnalysis::temperature(block, masses, degreesOfFreedom, numThreads);
+            }
+            return toArray(result);
+        }, py::arg("velocities"),
+           py::arg("masses"),
+           py::arg("degrees_of_freedom") = 0,
+           py::arg("num_threads") = 0,
+           "Instantaneous temperature (K) of each velocity frame")
+        .def_static("frame_energies", [](const System& system, const DoubleArray& frames, int numThreads) {
+            FrameBlock block = toFrameBlock(frames);
+            std::vector<SystemEnergy> energies;
+            {
+                py::gil_scoped_release release;
+                energies = TrajectoryAnalysis::frameEnergies(system, block, numThreads);
+            }
+
+            const size_t numFrames = energies.size();
+            std::vector<double> bond(numFrames), angle(numFrames), dihedral(numFrames), improper(numFrames);
+            std::vector<double> bonded(numFrames), lennardJones(numFrames), coulomb(numFrames);
+            std::vector<double> nonbonded(numFrames), solvation(numFrames), potential(numFrames);
+            for (size_t f = 0; f < numFrames; ++f) {
+                bond[f] = energies[f].bonded.bondEnergy;
+                angle[f] = energies[f].bonded.angleEnergy;
+                dihedral[f] = energies[f].bonded.dihedralEnergy;
+                improper[f] = energies[f].bonded.improperEnergy;
+                bonded[f] = energies[f].bonded.total;
+                lennardJones[f] = energies[f].nonbonded.lennardJones;
+                coulomb[f] = energies[f].nonbonded.coulomb;
+                nonbonded[f] = energies[f].nonbonded.total;
+                solvation[f] = energies[f].solvation;
+                potential[f] = energies[f].potential;
+            }
+
+            py::dict d;
+            d["bond"] = toArray(bond);
+            d["angle"] = toArray(angle);
+            d["dihedral"] = toArray(dihedral);
+            d["improper"] = toArray(improper);
+            d["bonded"] = toArray(bonded);
+            d["lennard_jones"] = toArray(lennardJones);
+            d["coulomb"] = toArray(coulomb);
+            d["nonbonded"] = toArray(nonbonded);
+            d["solvation"] = toArray(solvation);
+            d["potential"] = toArray(potential);
+            return d;
+        }, py::arg("system"),
+           py::arg("frames"),
+           py::arg("num_threads") = 0,
+           "Bonded and nonbonded energy components of each frame, as a dict of arrays");
+
+    py::class_<VerificationResult>(m, "VerificationResult", "Outcome of one family of derivative or conservation checks")
+        .def_readonly("name", &VerificationResult::name)
+        .def_readonly("num_checks", &VerificationResult::numChecks)
+        .def_readonly("max_error", &VerificationResult::maxError)
+        .def_readonly("tolerance", &VerificationResult::tolerance)
+        .def_readonly("passed", &VerificationResult::passed);
+
+    py::class_<EnergyDriftResult>(m, "EnergyDriftResult", "Total energy drift of an NVE run")
+        .def_readonly("num_steps", &EnergyDriftResult::numSteps)
+        .def_readonly("timestep", &EnergyDriftResult::timestep)
+        .def_readonly("initial_energy", &EnergyDriftResult::initialEnergy)
+        .def_readonly("max_deviation", &EnergyDriftResult::maxDeviation)
+        .def_readonly("drift_per_atom_per_ps", &EnergyDriftResult::driftPerAtomPerPs)
+        .def_readonly("tolerance", &EnergyDriftResult::tolerance)
+        .def_readonly("passed", &EnergyDriftResult::passed);
+
+    py::class_<ForceVerification>(m, "ForceVerification",
+                                  "Finite-difference and conservation checks of the force kernels")
+        .def_static("check_interaction_gradients", &ForceVerification::checkInteractionGradients,
+                    py::arg("num_samples") = 200,
+                    py::arg("seed") = 1,
+                    py::arg("tolerance") = 1e-6,
+                    py::call_guard<py::gil_scoped_release>(),
+                    "Check bonded and nonbonded derivatives against central differences of their energies")
+        .def_static("check_pair_table", &ForceVerification::checkPairTable,
+                    py::arg("table"),
+                    py::arg("num_samples") = 1000,
+                    py::arg("seed") = 1,
+                    py::arg("tolerance") = 1e-6,
+                    "Check a pair table's forces against differences of its energy")
+        .def_static("check_system_forces", &ForceVerification::checkSystemForces,
+                    py::arg("system"),
+                    py::arg("mode") = PrecisionMode::Double,
+                    py::arg("step") = 1e-4,
+                    py::arg("max_atoms") = 0,
+                    py::arg("tolerance") = 1e-4,
+                    py::call_guard<py::gil_scoped_release>(),
+                    "Check System forces against central differences of its potential energy")
+        .def_static("check_conservation", &ForceVerification::checkConservation,
+                    py::arg("system"),
+                    py::arg("tolerance") = 1e-9,
+                    py::call_guard<py::gil_scoped_release>(),
+                    "Check net force and torque of the system and of each bonded term")
+        .def_static("check_energy_drift", &ForceVerification::checkEnergyDrift,
+                    py::arg("system"),
+                    py::arg("num_steps"),
+                    py::arg("timestep"),
+                    py::arg("sample_interval") = 10,
+                    py::arg("tolerance") = 1e-3,
+                    py::call_guard<py::gil_scoped_release>(),
+                    "Run an NVE copy of the system and fit the drift of its total energy");
 }
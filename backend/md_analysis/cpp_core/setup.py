@@ -15,11 +15,41 @@ ext_modules = [
         "molecular_interactions",
         [
             "pybind11_module.cpp",
-            "radii_lists.cpp",
-            "nonbond_interactions.cpp",
-            "bonded_interactions.cpp",
+            "../constants/radii_lists.cpp",
+            "core_energies/nonbond_interactions.cpp",
+            "core_energies/bonded_interactions.cpp",
+            "core_energies/neighbor_list.cpp",
+            "core_energies/forces_classical/bonded_forces.cpp",
+            "core_energies/forces_classical/nonbonded_forces.cpp",
+            "core_energies/resources/generate_exclusions.cpp",
+            "simulation/system.cpp",
+            "memory/scratch_arena.cpp",
+            "core_energies/cell_list.cpp",
+            "simulation/spatial_sort.cpp",
+            "simulation/incremental_energy.cpp",
+            "simulation/simulation_runner.cpp",
+            "core_energies/resources/topology_builder.cpp",
+            "core_energies/pair_table.cpp",
+            "core_energies/forces_classical/generalized_born.cpp",
+            "simulation/checkpoint.cpp",
+            "simulation/work_stealing_pool.cpp",
+            "simulation/replica_exchange.cpp",
+            "memory/mapped_file.cpp",
+            "simulation/structure_loader.cpp",
+            "analysis/trajectory_analysis.cpp",
+            "verification/force_verification.cpp",
+        ],
+        include_dirs=[
+            ext_dir,
+            os.path.join(ext_dir, "..", "constants"),
+            os.path.join(ext_dir, "core_energies"),
+            os.path.join(ext_dir, "core_energies", "forces_classical"),
+            os.path.join(ext_dir, "core_energies", "resources"),
+            os.path.join(ext_dir, "simulation"),
+            os.path.join(ext_dir, "memory"),
+            os.path.join(ext_dir, "analysis"),
+            os.path.join(ext_dir, "verification"),
         ],
-        include_dirs=[ext_dir],
         extra_compile_args=['-O3'] if sys.platform != 'win32' else ['/O2'],
         language='c++'
     ),
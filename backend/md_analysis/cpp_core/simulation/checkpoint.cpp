@@ -0,0 +1,705 @@
+#include "checkpoint.h"
+#include "mapped_file.h"
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+
+const char MAGIC[8] = {'M', 'M', 'C', 'H', 'K', 'P', 'T', '\0'};
+const uint32_t ENDIAN_TAG = 0x01020304;
+const size_t SECTION_ALIGNMENT = 64;
+
+enum SectionTag : uint32_t {
+    SCALAR_INTEGERS = 1,
+    SCALAR_REALS,
+    ELEMENT_OFFSETS,
+    ELEMENT_CHARACTERS,
+    POSITION_X,
+    POSITION_Y,
+    POSITION_Z,
+    VELOCITY_X,
+    VELOCITY_Y,
+    VELOCITY_Z,
+    FORCE_X,
+    FORCE_Y,
+    FORCE_Z,
+    MASS,
+    CHARGE,
+    SIGMA,
+    EPSILON,
+    ATOM_TYPE,
+    ORIGINAL_ID,
+    CURRENT_INDEX,
+    BOND_ATOMS,
+    BOND_PARAMETERS,
+    ANGLE_ATOMS,
+    ANGLE_PARAMETERS,
+    DIHEDRAL_ATOMS,
+    DIHEDRAL_PARAMETERS,
+    IMPROPER_ATOMS,
+    IMPROPER_PARAMETERS,
+    EXCLUSION_OFFSETS,
+    EXCLUSION_INDICES,
+    NEIGHBOR_OFFSETS,
+    NEIGHBOR_INDICES,
+    NEIGHBOR_REFERENCE_X,
+    NEIGHBOR_REFERENCE_Y,
+    NEIGHBOR_REFERENCE_Z,
+    TABLE_LAYOUT,
+    TABLE_GEOMETRY,
+    TABLE_COEFFICIENTS,
+    IMPLICIT_SOLVENT,
+    BORN_RADII,
+    NUM_SECTION_TAGS
+};
+
+// SCALAR_INTEGERS entries.
+enum ScalarInteger {
+    NUM_ATOMS,
+    PRECISION_MODE,
+    SORT_INTERVAL,
+    STEP_COUNT,
+    FORCES_CURRENT,
+    EXCLUSIONS_VALID,
+    NEIGHBOR_LIST_VALID,
+    NUM_PAIR_TYPES,
+    NUM_SCALAR_INTEGERS
+};
+
+// SCALAR_REALS entries; the last eleven are the SystemEnergy of the saved forces.
+enum ScalarReal {
+    BOX_X,
+    BOX_Y,
+    BOX_Z,
+    DIELECTRIC_CONSTANT,
+    CUTOFF_DISTANCE,
+    SKIN_DISTANCE,
+    LAST_ENERGY,
+    NUM_SCALAR_REALS = LAST_ENERGY + 11
+};
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t endianTag;
+    uint64_t fileSize;
+    uint64_t tableChecksum;
+    uint32_t numSections;
+    uint32_t reserved;
+    uint8_t padding[24];
+};
+static_assert(sizeof(FileHeader) == 64, "Checkpoint header must stay 64 bytes");
+
+struct SectionEntry {
+    uint32_t tag;
+    uint32_t elementSize;
+    uint64_t count;
+    uint64_t offset;
+    uint64_t checksum;
+};
+static_assert(sizeof(SectionEntry) == 32, "Checkpoint section entry must stay 32 bytes");
+
+size_t alignUp(size_t value) {
+    return (value + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+}
+
+class SectionWriter {
+public:
+
+    template <typename T>
+    void add(SectionTag tag, const std::vector<T>& values) {
+        pending.push_back({tag, static_cast<uint32_t>(sizeof(T)), values.data(), values.size()});
+    }
+
+    void write(const std::string& path) const;
+
+private:
+    struct Pending {
+        SectionTag tag;
+        uint32_t elementSize;
+        const void* data;
+        size_t count;
+    };
+
+    std::vector<Pending> pending;
+};
+
+class OutputFile {
+public:
+
+    explicit OutputFile(const std::string& path) : path(path) {
+        file = std::fopen(path.c_str(), "wb");
+        if (!file) {
+            throw std::runtime_error("Cannot open " + path + " for writing");
+        }
+    }
+
+    ~OutputFile() {
+        if (file) {
+            std::fclose(file);
+            std::remove(path.c_str());
+        }
+    }
+
+    void write(const void* data, size_t size) {
+        if (size > 0 && std::fwrite(data, 1, size, file) != size) {
+            throw std::runtime_error("Failed writing " + path);
+        }
+    }
+
+    void pad(size_t size) {
+        static const char zeros[SECTION_ALIGNMENT] = {};
+        write(zeros, size);
+    }
+
+    // Flushes to disk and renames over target; the temporary is removed on failure.
+    void commit(const std::string& target) {
+        bool synced = std::fflush(file) == 0 && fsync(fileno(file)) == 0;
+        bool closed = std::fclose(file) == 0;
+        file = nullptr;
+        if (!synced || !closed || std::rename(path.c_str(), target.c_str()) != 0) {
+            std::remove(path.c_str());
+            throw std::runtime_error("Failed to commit checkpoint " + target);
+        }
+    }
+
+private:
+    std::string path;
+    std::FILE* file = nullptr;
+};
+
+void SectionWriter::write(const std::string& path) const {
+    std::vector<SectionEntry> entries(pending.size());
+    size_t offset = alignUp(sizeof(FileHeader) + entries.size() * sizeof(SectionEntry));
+    for (size_t s = 0; s < pending.size(); ++s) {
+        const Pending& section = pending[s];
+        size_t bytes = section.count * section.elementSize;
+        entries[s] = {section.tag, section.elementSize, section.count, offset,
+                      Checkpoint::checksum(section.data, bytes)};
+        offset = alignUp(offset + bytes);
+    }
+
+    FileHeader header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = Checkpoint::VERSION;
+    header.endianTag = ENDIAN_TAG;
+    header.fileSize = offset;
+    header.tableChecksum = Checkpoint::checksum(entries.data(), entries.size() * sizeof(SectionEntry));
+    header.numSections = static_cast<uint32_t>(entries.size());
+
+    OutputFile file(path + ".tmp");
+    file.write(&header, sizeof(header));
+    file.write(entries.data(), entries.size() * sizeof(SectionEntry));
+    size_t written = sizeof(FileHeader) + entries.size() * sizeof(SectionEntry);
+    for (size_t s = 0; s < pending.size(); ++s) {
+        file.pad(entries[s].offset - written);
+        size_t bytes = pending[s].count * pending[s].elementSize;
+        file.write(pending[s].data, bytes);
+        written = entries[s].offset + bytes;
+    }
+    file.pad(offset - written);
+    file.commit(path);
+}
+
+class SectionReader {
+public:
+
+    SectionReader(const MappedFile& file, const std::string& path)
+        : bytes(reinterpret_cast<const unsigned char*>(file.getData())),
+          size(file.getSize()),
+          path(path) {
+        if (size < sizeof(FileHeader)) {
+            fail("file is too short");
+        }
+        FileHeader header;
+        std::memcpy(&header, bytes, sizeof(header));
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+            fail("not a checkpoint file");
+        }
+        if (header.endianTag != ENDIAN_TAG) {
+            fail("written on a machine with different byte order");
+        }
+        if (header.version < Checkpoint::OLDEST_READABLE_VERSION || header.version > Checkpoint::VERSION) {
+            fail("unsupported version " + std::to_string(header.version));
+        }
+        version = header.version;
+        if (header.fileSize != size) {
+            fail("file is truncated");
+        }
+
+        size_t tableBytes = static_cast<size_t>(header.numSections) * sizeof(SectionEntry);
+        if (tableBytes > size - sizeof(FileHeader)) {
+            fail("section table is truncated");
+        }
+        const unsigned char* table = bytes + sizeof(FileHeader);
+        if (Checkpoint::checksum(table, tableBytes) != header.tableChecksum) {
+            fail("section table checksum mismatch");
+        }
+
+        sections.assign(NUM_SECTION_TAGS, nullptr);
+        entries.resize(header.numSections);
+        std::memcpy(entries.data(), table, tableBytes);
+        for (const SectionEntry& entry : entries) {
+            if (entry.elementSize == 0 || entry.offset % SECTION_ALIGNMENT != 0 || entry.offset > size ||
+                entry.count > (size - entry.offset) / entry.elementSize) {
+                fail("section " + std::to_string(entry.tag) + " lies outside the file");
+            }
+            if (Checkpoint::checksum(bytes + entry.offset, entry.count * entry.elementSize) !=
+                entry.checksum) {
+                fail("section " + std::to_string(entry.tag) + " checksum mismatch");
+            }
+            if (entry.tag < NUM_SECTION_TAGS) {
+                sections[entry.tag] = &entry;
+            }
+        }
+    }
+
+    template <typename T>
+    void read(SectionTag tag, std::vector<T>& values, size_t expectedCount = SIZE_MAX) const {
+        const SectionEntry* entry = sections[tag];
+        if (!entry) {
+            fail("section " + std::to_string(tag) + " is missing");
+        }
+        if (entry->elementSize != sizeof(T) ||
+            (expectedCount != SIZE_MAX && entry->count != expectedCount)) {
+            fail("section " + std::to_string(tag) + " has an unexpected size");
+        }
+        // Payloads start on 64-byte boundaries of the page-aligned mapping.
+        const T* first = reinterpret_cast<const T*>(bytes + entry->offset);
+        values.assign(first, first + entry->count);
+    }
+
+    uint32_t getVersion() const {
+        return version;
+    }
+
+    [[noreturn]] void fail(const std::string& reason) const {
+        throw std::runtime_error("Invalid checkpoint " + path + ": " + reason);
+    }
+
+private:
+    const unsigned char* bytes;
+    size_t size;
+    std::string path;
+    uint32_t version = 0;
+    std::vector<SectionEntry> entries;
+    std::vector<const SectionEntry*> sections;
+};
+
+void checkIndex(int index, size_t limit, const SectionReader& reader) {
+    if (index < 0 || static_cast<size_t>(index) >= limit) {
+        reader.fail("atom index " + std::to_string(index) + " out of range");
+    }
+}
+
+void checkIndices(const std::vector<int>& indices, size_t limit, const SectionReader& reader) {
+    for (int index : indices) {
+        checkIndex(index, limit, reader);
+    }
+}
+
+void checkOffsets(const std::vector<int>& offsets, size_t numValues, const SectionReader& reader) {
+    if (offsets.empty() || offsets.front() != 0 ||
+        static_cast<size_t>(offsets.back()) != numValues) {
+        reader.fail("inconsistent offsets");
+    }
+    for (size_t k = 1; k < offsets.size(); ++k) {
+        if (offsets[k] < offsets[k - 1]) {
+            reader.fail("inconsistent offsets");
+        }
+    }
+}
+
+}
+
+uint64_t Checkpoint::checksum(const void* data, size_t size) {
+    const uint64_t prime1 = 11400714785074694791ULL;
+    const uint64_t prime2 = 14029467366897019727ULL;
+    const uint64_t prime3 = 1609587929392839161ULL;
+    const uint64_t prime4 = 9650029242287828579ULL;
+    const uint64_t prime5 = 2870177450012600261ULL;
+
+    auto rotate = [](uint64_t value, int bits) {
+        return (value << bits) | (value >> (64 - bits));
+    };
+    auto mix = [&](uint64_t accumulator, uint64_t word) {
+        return rotate(accumulator + word * prime2, 31) * prime1;
+    };
+
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    const unsigned char* end = bytes + size;
+
+    // Four independent lanes over 32-byte blocks keep the multiplies in flight.
+    uint64_t lanes[4] = {prime1 + prime2, prime2, 0, 0 - prime1};
+    while (end - bytes >= 32) {
+        uint64_t words[4];
+        std::memcpy(words, bytes, sizeof(words));
+        for (int lane = 0; lane < 4; ++lane) {
+            lanes[lane] = mix(lanes[lane], words[lane]);
+        }
+        bytes += 32;
+    }
+
+    uint64_t hash = rotate(lanes[0], 1) + rotate(lanes[1], 7) +
+                    rotate(lanes[2], 12) + rotate(lanes[3], 18) + size;
+    while (end - bytes >= 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes, sizeof(word));
+        hash = rotate(hash ^ mix(0, word), 27) * prime1 + prime4;
+        bytes += 8;
+    }
+    while (bytes < end) {
+        hash = rotate(hash ^ (*bytes * prime5), 11) * prime1;
+        ++bytes;
+    }
+
+    hash ^= hash >> 33;
+    hash *= prime2;
+    hash ^= hash >> 29;
+    hash *= prime3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+void Checkpoint::save(const System& system, const std::string& path) {
+    const ParticleArrays& particles = system.particles;
+    const TopologyData& topology = *system.topology;
+    const NeighborList& neighborList = system.neighborList;
+    const size_t numAtoms = particles.size();
+
+    std::vector<int64_t> integers(NUM_SCALAR_INTEGERS);
+    integers[NUM_ATOMS] = static_cast<int64_t>(numAtoms);
+    integers[PRECISION_MODE] = static_cast<int64_t>(system.precisionMode);
+    integers[SORT_INTERVAL] = system.sortInterval;
+    integers[STEP_COUNT] = system.stepCount;
+    integers[FORCES_CURRENT] = system.forcesCurrent;
+    integers[EXCLUSIONS_VALID] = !system.topologyChanged;
+    integers[NEIGHBOR_LIST_VALID] = neighborList.isValid() && !system.topologyChanged;
+    integers[NUM_PAIR_TYPES] = system.pairTables ? system.pairTables->getNumTypes() : -1;
+
+    const SystemEnergy& energy = system.lastEnergy;
+    std::vector<double> reals = {
+        system.boxLength[0], system.boxLength[1], system.boxLength[2],
+        system.dielectricConstant,
+        neighborList.getCutoffDistance(), neighborList.getSkinDistance(),
+        energy.bonded.bondEnergy, energy.bonded.angleEnergy, energy.bonded.dihedralEnergy,
+        energy.bonded.improperEnergy, energy.bonded.total,
+        energy.nonbonded.lennardJones, energy.nonbonded.coulomb, energy.nonbonded.total,
+        energy.kinetic, energy.potential, energy.total};
+
+    std::vector<int> elementOffsets(numAtoms + 1, 0);
+    std::vector<char> elementCharacters;
+    for (size_t i = 0; i < numAtoms; ++i) {
+        elementCharacters.insert(elementCharacters.end(),
+                                 particles.element[i].begin(), particles.element[i].end());
+        elementOffsets[i + 1] = static_cast<int>(elementCharacters.size());
+    }
+
+    std::vector<int> bondAtoms, angleAtoms, dihedralAtoms, improperAtoms;
+    std::vector<double> bondParameters, angleParameters, dihedralParameters, improperParameters;
+    for (const auto& bond : topology.bonds) {
+        bondAtoms.insert(bondAtoms.end(), {bond.atom1Id, bond.atom2Id, bond.order, bond.isRotatable ? 1 : 0});
+        bondParameters.insert(bondParameters.end(), {bond.equilibriumLength, bond.forceConstant});
+    }
+    for (const auto& angle : topology.angles) {
+        angleAtoms.insert(angleAtoms.end(), {angle.atom1Id, angle.atom2Id, angle.atom3Id});
+        angleParameters.insert(angleParameters.end(), {angle.equilibriumAngle, angle.forceConstant});
+    }
+    for (const auto& dihedral : topology.dihedrals) {
+        dihedralAtoms.insert(dihedralAtoms.end(),
+                             {dihedral.atom1Id, dihedral.atom2Id, dihedral.atom3Id, dihedral.atom4Id});
+        dihedralParameters.insert(dihedralParameters.end(),
+                                  {dihedral.periodicity, dihedral.barrierHeight, dihedral.phaseOffset});
+    }
+    for (const auto& improper : topology.impropers) {
+        improperAtoms.insert(improperAtoms.end(),
+                             {improper.atom1Id, improper.atom2Id, improper.atom3Id, improper.atom4Id});
+        improperParameters.insert(improperParameters.end(),
+                                  {improper.equilibriumAngle, improper.forceConstant});
+    }
+
+    // Per table: type pair ({-1, -1} for the Coulomb table) and coefficient count.
+    std::vector<int> tableLayout;
+    std::vector<double> tableGeometry;
+    std::vector<double> tableCoefficients;
+    if (system.pairTables) {
+        const PairTableSet& tables = *system.pairTables;
+        const int numTypes = tables.getNumTypes();
+        const std::vector<int>& tableIndex = tables.getTableIndex();
+        for (size_t t = 0; t < tables.getTables().size(); ++t) {
+            int typeI = -1;
+            int typeJ = -1;
+            for (int a = 0; a < numTypes && typeI < 0; ++a) {
+                for (int b = a; b < numTypes; ++b) {
+                    if (tableIndex[a * numTypes + b] == static_cast<int>(t)) {
+                        typeI = a;
+                        typeJ = b;
+                        break;
+                    }
+                }
+            }
+            const PairTable& table = tables.getTables()[t];
+            tableLayout.insert(tableLayout.end(),
+                               {typeI, typeJ, static_cast<int>(table.getCoefficients().size())});
+            tableGeometry.insert(tableGeometry.end(),
+                                 {table.getInnerDistance(), table.getCutoffDistance(),
+                                  table.getInverseSpacing()});
+            tableCoefficients.insert(tableCoefficients.end(),
+                                     table.getCoefficients().begin(), table.getCoefficients().end());
+        }
+    }
+
+    // Generalized Born options and the solvation part of the saved energy;
+    // empty without implicit solvent.
+    std::vector<double> implicitSolvent;
+    if (system.implicitSolvent) {
+        const GeneralizedBornOptions& options = system.solventOptions;
+        implicitSolvent = {options.solventDielectric, options.radiusOffset,
+                           options.alpha, options.beta, options.gamma,
+                           static_cast<double>(options.numThreads), energy.solvation};
+    }
+
+    const std::vector<int> none;
+    const bool exclusionsValid = integers[EXCLUSIONS_VALID] != 0;
+    const bool neighborListValid = integers[NEIGHBOR_LIST_VALID] != 0;
+    const std::vector<double> noPositions;
+
+    SectionWriter writer;
+    writer.add(SCALAR_INTEGERS, integers);
+    writer.add(SCALAR_REALS, reals);
+    writer.add(ELEMENT_OFFSETS, elementOffsets);
+    writer.add(ELEMENT_CHARACTERS, elementCharacters);
+    writer.add(POSITION_X, particles.x);
+    writer.add(POSITION_Y, particles.y);
+    writer.add(POSITION_Z, particles.z);
+    writer.add(VELOCITY_X, particles.vx);
+    writer.add(VELOCITY_Y, particles.vy);
+    writer.add(VELOCITY_Z, particles.vz);
+    writer.add(FORCE_X, particles.fx);
+    writer.add(FORCE_Y, particles.fy);
+    writer.add(FORCE_Z, particles.fz);
+    writer.add(MASS, particles.mass);
+    writer.add(CHARGE, particles.charge);
+    writer.add(SIGMA, particles.sigma);
+    writer.add(EPSILON, particles.epsilon);
+    writer.add(ATOM_TYPE, particles.type);
+    writer.add(ORIGINAL_ID, particles.originalId);
+    writer.add(CURRENT_INDEX, system.currentIndex);
+    writer.add(BOND_ATOMS, bondAtoms);
+    writer.add(BOND_PARAMETERS, bondParameters);
+    writer.add(ANGLE_ATOMS, angleAtoms);
+    writer.add(ANGLE_PARAMETERS, angleParameters);
+    writer.add(DIHEDRAL_ATOMS, dihedralAtoms);
+    writer.add(DIHEDRAL_PARAMETERS, dihedralParameters);
+    writer.add(IMPROPER_ATOMS, improperAtoms);
+    writer.add(IMPROPER_PARAMETERS, improperParameters);
+    writer.add(EXCLUSION_OFFSETS, exclusionsValid ? system.exclusions->offsets : none);
+    writer.add(EXCLUSION_INDICES, exclusionsValid ? system.exclusions->indices : none);
+    writer.add(NEIGHBOR_OFFSETS, neighborListValid ? neighborList.getData().offsets : none);
+    writer.add(NEIGHBOR_INDICES, neighborListValid ? neighborList.getData().indices : none);
+    writer.add(NEIGHBOR_REFERENCE_X, neighborListValid ? neighborList.getReferenceX() : noPositions);
+    writer.add(NEIGHBOR_REFERENCE_Y, neighborListValid ? neighborList.getReferenceY() : noPositions);
+    writer.add(NEIGHBOR_REFERENCE_Z, neighborListValid ? neighborList.getReferenceZ() : noPositions);
+    writer.add(TABLE_LAYOUT, tableLayout);
+    writer.add(TABLE_GEOMETRY, tableGeometry);
+    writer.add(TABLE_COEFFICIENTS, tableCoefficients);
+    writer.add(IMPLICIT_SOLVENT, implicitSolvent);
+    writer.add(BORN_RADII, system.implicitSolvent ? system.bornRadii : noPositions);
+    writer.write(path);
+}
+
+System Checkpoint::load(const std::string& path) {
+    MappedFile file(path);
+    SectionReader reader(file, path);
+
+    std::vector<int64_t> integers;
+    std::vector<double> reals;
+    reader.read(SCALAR_INTEGERS, integers, NUM_SCALAR_INTEGERS);
+    reader.read(SCALAR_REALS, reals, NUM_SCALAR_REALS);
+
+    if (integers[NUM_ATOMS] < 0 || integers[NUM_ATOMS] > INT32_MAX) {
+        reader.fail("invalid atom count");
+    }
+    const size_t numAtoms = static_cast<size_t>(integers[NUM_ATOMS]);
+
+    System system;
+    ParticleArrays& particles = system.particles;
+
+    std::vector<int> elementOffsets;
+    std::vector<char> elementCharacters;
+    reader.read(ELEMENT_OFFSETS, elementOffsets, numAtoms + 1);
+    reader.read(ELEMENT_CHARACTERS, elementCharacters);
+    checkOffsets(elementOffsets, elementCharacters.size(), reader);
+    particles.element.resize(numAtoms);
+    for (size_t i = 0; i < numAtoms; ++i) {
+        particles.element[i].assign(elementCharacters.data() + elementOffsets[i],
+                                    elementCharacters.data() + elementOffsets[i + 1]);
+    }
+
+    reader.read(POSITION_X, particles.x, numAtoms);
+    reader.read(POSITION_Y, particles.y, numAtoms);
+    reader.read(POSITION_Z, particles.z, numAtoms);
+    reader.read(VELOCITY_X, particles.vx, numAtoms);
+    reader.read(VELOCITY_Y, particles.vy, numAtoms);
+    reader.read(VELOCITY_Z, particles.vz, numAtoms);
+    reader.read(FORCE_X, particles.fx, numAtoms);
+    reader.read(FORCE_Y, particles.fy, numAtoms);
+    reader.read(FORCE_Z, particles.fz, numAtoms);
+    reader.read(MASS, particles.mass, numAtoms);
+    reader.read(CHARGE, particles.charge, numAtoms);
+    reader.read(SIGMA, particles.sigma, numAtoms);
+    reader.read(EPSILON, particles.epsilon, numAtoms);
+    reader.read(ATOM_TYPE, particles.type, numAtoms);
+    reader.read(ORIGINAL_ID, particles.originalId, numAtoms);
+    reader.read(CURRENT_INDEX, system.currentIndex, numAtoms);
+    checkIndices(particles.originalId, numAtoms, reader);
+    checkIndices(system.currentIndex, numAtoms, reader);
+
+    std::vector<int> atoms;
+    std::vector<double> parameters;
+    TopologyData& topology = system.mutableTopology();
+
+    reader.read(BOND_ATOMS, atoms);
+    reader.read(BOND_PARAMETERS, parameters, atoms.size() / 4 * 2);
+    if (atoms.size() % 4 != 0) reader.fail("bond section has an unexpected size");
+    topology.bonds.resize(atoms.size() / 4);
+    for (size_t t = 0; t < topology.bonds.size(); ++t) {
+        topology.bonds[t] = {atoms[4 * t], atoms[4 * t + 1], atoms[4 * t + 2],
+                             parameters[2 * t], parameters[2 * t + 1], atoms[4 * t + 3] != 0};
+        checkIndex(atoms[4 * t], numAtoms, reader);
+        checkIndex(atoms[4 * t + 1], numAtoms, reader);
+    }
+
+    reader.read(ANGLE_ATOMS, atoms);
+    reader.read(ANGLE_PARAMETERS, parameters, atoms.size() / 3 * 2);
+    if (atoms.size() % 3 != 0) reader.fail("angle section has an unexpected size");
+    checkIndices(atoms, numAtoms, reader);
+    topology.angles.resize(atoms.size() / 3);
+    for (size_t t = 0; t < topology.angles.size(); ++t) {
+        topology.angles[t] = {atoms[3 * t], atoms[3 * t + 1], atoms[3 * t + 2],
+                              parameters[2 * t], parameters[2 * t + 1]};
+    }
+
+    reader.read(DIHEDRAL_ATOMS, atoms);
+    reader.read(DIHEDRAL_PARAMETERS, parameters, atoms.size() / 4 * 3);
+    if (atoms.size() % 4 != 0) reader.fail("dihedral section has an unexpected size");
+    checkIndices(atoms, numAtoms, reader);
+    topology.dihedrals.resize(atoms.size() / 4);
+    for (size_t t = 0; t < topology.dihedrals.size(); ++t) {
+        topology.dihedrals[t] = {atoms[4 * t], atoms[4 * t + 1], atoms[4 * t + 2], atoms[4 * t + 3],
+                                 parameters[3 * t], parameters[3 * t + 1], parameters[3 * t + 2]};
+    }
+
+    reader.read(IMPROPER_ATOMS, atoms);
+    reader.read(IMPROPER_PARAMETERS, parameters, atoms.size() / 4 * 2);
+    if (atoms.size() % 4 != 0) reader.fail("improper section has an unexpected size");
+    checkIndices(atoms, numAtoms, reader);
+    topology.impropers.resize(atoms.size() / 4);
+    for (size_t t = 0; t < topology.impropers.size(); ++t) {
+        topology.impropers[t] = {atoms[4 * t], atoms[4 * t + 1], atoms[4 * t + 2], atoms[4 * t + 3],
+                                 parameters[2 * t], parameters[2 * t + 1]};
+    }
+
+    system.boxLength = {reals[BOX_X], reals[BOX_Y], reals[BOX_Z]};
+    system.dielectricConstant = reals[DIELECTRIC_CONSTANT];
+    system.neighborList.setCutoff(reals[CUTOFF_DISTANCE], reals[SKIN_DISTANCE]);
+
+    if (integers[EXCLUSIONS_VALID]) {
+        ExclusionLists& exclusions = system.mutableExclusions();
+        reader.read(EXCLUSION_OFFSETS, exclusions.offsets, numAtoms + 1);
+        reader.read(EXCLUSION_INDICES, exclusions.indices);
+        checkOffsets(exclusions.offsets, exclusions.indices.size(), reader);
+        checkIndices(exclusions.indices, numAtoms, reader);
+        system.topologyChanged = false;
+    }
+
+    if (integers[NEIGHBOR_LIST_VALID]) {
+        NeighborListData data;
+        std::vector<double> referenceX, referenceY, referenceZ;
+        reader.read(NEIGHBOR_OFFSETS, data.offsets, numAtoms + 1);
+        reader.read(NEIGHBOR_INDICES, data.indices);
+        reader.read(NEIGHBOR_REFERENCE_X, referenceX, numAtoms);
+        reader.read(NEIGHBOR_REFERENCE_Y, referenceY, numAtoms);
+        reader.read(NEIGHBOR_REFERENCE_Z, referenceZ, numAtoms);
+        checkOffsets(data.offsets, data.indices.size(), reader);
+        checkIndices(data.indices, numAtoms, reader);
+        system.neighborList.restore(data, referenceX, referenceY, referenceZ);
+    }
+
+    if (integers[NUM_PAIR_TYPES] >= 0) {
+        std::vector<int> tableLayout;
+        std::vector<double> tableGeometry;
+        std::vector<double> tableCoefficients;
+        reader.read(TABLE_LAYOUT, tableLayout);
+        reader.read(TABLE_GEOMETRY, tableGeometry, tableLayout.size());
+        reader.read(TABLE_COEFFICIENTS, tableCoefficients);
+        if (tableLayout.size() % 3 != 0) reader.fail("table section has an unexpected size");
+
+        auto tables = std::make_shared<PairTableSet>(static_cast<int>(integers[NUM_PAIR_TYPES]));
+        size_t next = 0;
+        for (size_t t = 0; t < tableLayout.size() / 3; ++t) {
+            size_t count = static_cast<size_t>(tableLayout[3 * t + 2]);
+            if (count > tableCoefficients.size() - next) reader.fail("table coefficients are truncated");
+            PairTable table = PairTable::fromCoefficients(
+                tableGeometry[3 * t], tableGeometry[3 * t + 1], tableGeometry[3 * t + 2],
+                std::vector<double>(tableCoefficients.begin() + next,
+                                    tableCoefficients.begin() + next + count));
+            next += count;
+
+            if (tableLayout[3 * t] < 0) {
+                tables->setCoulombTable(table);
+            } else {
+                tables->setTable(tableLayout[3 * t], tableLayout[3 * t + 1], table);
+            }
+        }
+        system.pairTables = std::move(tables);
+    }
+
+    if (integers[PRECISION_MODE] < static_cast<int64_t>(PrecisionMode::Double) ||
+        integers[PRECISION_MODE] > static_cast<int64_t>(PrecisionMode::Mixed)) {
+        reader.fail("unknown precision mode");
+    }
+    system.precisionMode = static_cast<PrecisionMode>(integers[PRECISION_MODE]);
+    system.sortInterval = static_cast<int>(integers[SORT_INTERVAL]);
+    system.stepCount = integers[STEP_COUNT];
+    system.forcesCurrent = integers[FORCES_CURRENT] != 0;
+    system.parametersChanged = true;
+
+    SystemEnergy& energy = system.lastEnergy;
+    const double* saved = &reals[LAST_ENERGY];
+    energy.bonded = {saved[0], saved[1], saved[2], saved[3], saved[4]};
+    energy.nonbonded.lennardJones = saved[5];
+    energy.nonbonded.coulomb = saved[6];
+    energy.nonbonded.total = saved[7];
+    energy.kinetic = saved[8];
+    energy.potential = saved[9];
+    energy.total = saved[10];
+
+    // Version 1 files predate implicit solvent and have neither section.
+    if (reader.getVersion() >= 2) {
+        std::vector<double> implicitSolvent;
+        reader.read(IMPLICIT_SOLVENT, implicitSolvent);
+        if (!implicitSolvent.empty()) {
+            if (implicitSolvent.size() != 7) reader.fail("implicit solvent section has an unexpected size");
+            GeneralizedBornOptions& options = system.solventOptions;
+            options.solventDielectric = implicitSolvent[0];
+            options.radiusOffset = implicitSolvent[1];
+            options.alpha = implicitSolvent[2];
+            options.beta = implicitSolvent[3];
+            options.gamma = implicitSolvent[4];
+            options.numThreads = static_cast<int>(implicitSolvent[5]);
+            energy.solvation = implicitSolvent[6];
+            system.implicitSolvent = true;
+
+            reader.read(BORN_RADII, system.bornRadii);
+            if (!system.bornRadii.empty() && system.bornRadii.size() != numAtoms) {
+                reader.fail("Born radii section has an unexpected size");
+            }
+        }
+    }
+
+    return system;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "system.h"
+
+// Binary restart file for a System. The file is a 64-byte header, a table
+// of sections and the section payloads, each payload starting on a 64-byte
+// boundary. Every section carries its own checksum and the header carries
+// the checksum of the section table. Sections hold the raw SoA arrays, so
+// loading maps the file and copies each array in one pass.
+//
+// Everything the integrator reads is saved, including the last forces and
+// the neighbor list with its reference positions, so a run continued from
+// a checkpoint is bitwise identical to one that was never interrupted.
+// System has no random number state yet; new state goes into new section
+// tags. Readers ignore tags they do not know, so state that changes the
+// physics also raises VERSION and older readers refuse the file instead
+// of silently running without it.
+class Checkpoint {
+public:
+
+    // Version 2 added the implicit solvent sections.
+    static constexpr uint32_t VERSION = 2;
+
+    // Files from this version up to VERSION load; missing later state keeps its defaults.
+    static constexpr uint32_t OLDEST_READABLE_VERSION = 1;
+
+    // Writes to path + ".tmp", syncs it and renames it over path, so an
+    // interrupted save never leaves a truncated checkpoint behind.
+    static void save(const System& system, const std::string& path);
+
+    static System load(const std::string& path);
+
+    static uint64_t checksum(const void* data, size_t size);
+};
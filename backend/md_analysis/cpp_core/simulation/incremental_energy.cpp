@@ -0,0 +1,651 @@
+#include "incremental_energy.h"
+#include "bonded_interactions.h"
+#include "nonbond_interactions.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+IncrementalEnergy::IncrementalEnergy(System& system) : system(system) {}
+
+template <typename GetAtoms>
+static void buildIncidence(
+    int numAtoms,
+    int numTerms,
+    int atomsPerTerm,
+    GetAtoms getAtoms,
+    std::vector<int>& offsets,
+    std::vector<int>& terms) {
+
+    offsets.assign(numAtoms + 1, 0);
+    std::array<int, 4> atoms;
+    for (int t = 0; t < numTerms; ++t) {
+        getAtoms(t, atoms);
+        for (int a = 0; a < atomsPerTerm; ++a) {
+            offsets[atoms[a] + 1]++;
+        }
+    }
+    for (int i = 0; i < numAtoms; ++i) {
+        offsets[i + 1] += offsets[i];
+    }
+
+    terms.resize(offsets[numAtoms]);
+    std::vector<int> cursor(offsets.begin(), offsets.end() - 1);
+    for (int t = 0; t < numTerms; ++t) {
+        getAtoms(t, atoms);
+        for (int a = 0; a < atomsPerTerm; ++a) {
+            terms[cursor[atoms[a]]++] = t;
+        }
+    }
+}
+
+void IncrementalEnergy::rebuild() {
+    // Born radii couple every atom to all its neighbors, so moves are not local.
+    if (system.hasImplicitSolvent()) {
+        throw std::runtime_error("Incremental energies do not support implicit solvent");
+    }
+
+    const ParticleArrays& particles = system.getParticles();
+    const TopologyData& topology = system.getTopology();
+    const int numAtoms = static_cast<int>(particles.size());
+
+    ExclusionTable table = Exclusions::buildExclusionTable(numAtoms, topology.bonds);
+    exclusions = Exclusions::buildExclusionLists(numAtoms, table);
+
+    buildIncidence(numAtoms, static_cast<int>(topology.bonds.size()), 2,
+        [&](int t, std::array<int, 4>& atoms) {
+            atoms[0] = topology.bonds[t].atom1Id;
+            atoms[1] = topology.bonds[t].atom2Id;
+        }, bondOffsets, bondTerms);
+    buildIncidence(numAtoms, static_cast<int>(topology.angles.size()), 3,
+        [&](int t, std::array<int, 4>& atoms) {
+            atoms[0] = topology.angles[t].atom1Id;
+            atoms[1] = topology.angles[t].atom2Id;
+            atoms[2] = topology.angles[t].atom3Id;
+        }, angleOffsets, angleTerms);
+    buildIncidence(numAtoms, static_cast<int>(topology.dihedrals.size()), 4,
+        [&](int t, std::array<int, 4>& atoms) {
+            atoms[0] = topology.dihedrals[t].atom1Id;
+            atoms[1] = topology.dihedrals[t].atom2Id;
+            atoms[2] = topology.dihedrals[t].atom3Id;
+            atoms[3] = topology.dihedrals[t].atom4Id;
+        }, dihedralOffsets, dihedralTerms);
+    buildIncidence(numAtoms, static_cast<int>(topology.impropers.size()), 4,
+        [&](int t, std::array<int, 4>& atoms) {
+            atoms[0] = topology.impropers[t].atom1Id;
+            atoms[1] = topology.impropers[t].atom2Id;
+            atoms[2] = topology.impropers[t].atom3Id;
+            atoms[3] = topology.impropers[t].atom4Id;
+        }, improperOffsets, improperTerms);
+
+    bondedTotal = 0.0;
+    bondEnergies.resize(topology.bonds.size());
+    for (size_t t = 0; t < bondEnergies.size(); ++t) {
+        bondEnergies[t] = bondTermEnergy(static_cast<int>(t));
+        bondedTotal += bondEnergies[t];
+    }
+    angleEnergies.resize(topology.angles.size());
+    for (size_t t = 0; t < angleEnergies.size(); ++t) {
+        angleEnergies[t] = angleTermEnergy(static_cast<int>(t));
+        bondedTotal += angleEnergies[t];
+    }
+    dihedralEnergies.resize(topology.dihedrals.size());
+    for (size_t t = 0; t < dihedralEnergies.size(); ++t) {
+        dihedralEnergies[t] = dihedralTermEnergy(static_cast<int>(t));
+        bondedTotal += dihedralEnergies[t];
+    }
+    improperEnergies.resize(topology.impropers.size());
+    for (size_t t = 0; t < improperEnergies.size(); ++t) {
+        improperEnergies[t] = improperTermEnergy(static_cast<int>(t));
+        bondedTotal += improperEnergies[t];
+    }
+
+    double cutoff = system.getNeighborList().getCutoffDistance();
+    cutoff2 = cutoff * cutoff;
+    boxLength = system.getBoxLength();
+    periodic = boxLength[0] > 0.0 && boxLength[1] > 0.0 && boxLength[2] > 0.0;
+    buildCells();
+
+    pairTotal = 0.0;
+    atomPairEnergy.assign(numAtoms, 0.0);
+    for (int i = 0; i < numAtoms; ++i) {
+        forEachCandidate(particles.x[i], particles.y[i], particles.z[i], [&](int j) {
+            if (j != i) atomPairEnergy[i] += pairEnergy(i, j);
+        });
+        pairTotal += 0.5 * atomPairEnergy[i];
+    }
+
+    movedStamp.assign(numAtoms, 0u);
+    bondStamps.assign(topology.bonds.size(), 0u);
+    angleStamps.assign(topology.angles.size(), 0u);
+    dihedralStamps.assign(topology.dihedrals.size(), 0u);
+    improperStamps.assign(topology.impropers.size(), 0u);
+    currentStamp = 0;
+
+    version = system.getStateVersion();
+    built = true;
+    pending = false;
+}
+
+void IncrementalEnergy::ensureCurrent() {
+    if (pending) {
+        throw std::runtime_error("A proposed move must be committed or rejected first");
+    }
+    if (!built || version != system.getStateVersion()) {
+        rebuild();
+    }
+}
+
+void IncrementalEnergy::buildCells() {
+    const ParticleArrays& particles = system.getParticles();
+    const int numAtoms = static_cast<int>(particles.size());
+    const double cutoff = std::sqrt(cutoff2);
+    const double* coordinates[3] = {particles.x.data(), particles.y.data(), particles.z.data()};
+    const double maxCells = std::max(27.0, 2.0 * numAtoms);
+    double extents[3];
+
+    for (int d = 0; d < 3; ++d) {
+        double extent;
+        if (periodic) {
+            cellOrigin[d] = 0.0;
+            extent = boxLength[d];
+        } else if (numAtoms > 0) {
+            auto range = std::minmax_element(coordinates[d], coordinates[d] + numAtoms);
+            cellOrigin[d] = *range.first;
+            extent = *range.second - *range.first;
+        } else {
+            cellOrigin[d] = 0.0;
+            extent = 0.0;
+        }
+        extents[d] = extent;
+        cellDimensions[d] = static_cast<int>(std::max(1.0, std::min(std::floor(extent / cutoff), maxCells)));
+    }
+
+    // Sparse open systems, such as one atom far from the rest, would
+    // otherwise get far more cells than atoms; halve the longest axis
+    // until the total is back under the cap.
+    while (static_cast<double>(cellDimensions[0]) * cellDimensions[1] * cellDimensions[2] > maxCells) {
+        int longest = static_cast<int>(std::max_element(cellDimensions.begin(), cellDimensions.end()) -
+                                       cellDimensions.begin());
+        cellDimensions[longest] = (cellDimensions[longest] + 1) / 2;
+    }
+
+    for (int d = 0; d < 3; ++d) {
+        inverseCellSize[d] = extents[d] > 0.0 ? cellDimensions[d] / extents[d] : 0.0;
+    }
+
+    useCells = !periodic ||
+        (cellDimensions[0] >= 3 && cellDimensions[1] >= 3 && cellDimensions[2] >= 3);
+
+    cellNext.assign(numAtoms, -1);
+    cellPrevious.assign(numAtoms, -1);
+    atomCell.assign(numAtoms, 0);
+    cellHead.assign(useCells ? static_cast<size_t>(cellDimensions[0]) * cellDimensions[1] * cellDimensions[2] : 1, -1);
+
+    for (int i = numAtoms - 1; i >= 0; --i) {
+        insertIntoCell(i, useCells ? cellOf(particles.x[i], particles.y[i], particles.z[i]) : 0);
+    }
+}
+
+int IncrementalEnergy::cellOf(double x, double y, double z) const {
+    const double position[3] = {x, y, z};
+    int index[3];
+    for (int d = 0; d < 3; ++d) {
+        int c = static_cast<int>(std::floor((position[d] - cellOrigin[d]) * inverseCellSize[d]));
+        if (periodic) {
+            c %= cellDimensions[d];
+            if (c < 0) c += cellDimensions[d];
+        } else {
+            c = std::max(0, std::min(c, cellDimensions[d] - 1));
+        }
+        index[d] = c;
+    }
+    return (index[0] * cellDimensions[1] + index[1]) * cellDimensions[2] + index[2];
+}
+
+void IncrementalEnergy::insertIntoCell(int atom, int cell) {
+    atomCell[atom] = cell;
+    cellPrevious[atom] = -1;
+    cellNext[atom] = cellHead[cell];
+    if (cellHead[cell] >= 0) {
+        cellPrevious[cellHead[cell]] = atom;
+    }
+    cellHead[cell] = atom;
+}
+
+void IncrementalEnergy::removeFromCell(int atom) {
+    if (cellPrevious[atom] >= 0) {
+        cellNext[cellPrevious[atom]] = cellNext[atom];
+    } else {
+        cellHead[atomCell[atom]] = cellNext[atom];
+    }
+    if (cellNext[atom] >= 0) {
+        cellPrevious[cellNext[atom]] = cellPrevious[atom];
+    }
+    cellNext[atom] = -1;
+    cellPrevious[atom] = -1;
+}
+
+template <typename Visitor>
+void IncrementalEnergy::forEachCandidate(double x, double y, double z, Visitor&& visit) const {
+    if (!useCells) {
+        for (int j = cellHead[0]; j >= 0; j = cellNext[j]) {
+            visit(j);
+        }
+        return;
+    }
+
+    const int cell = cellOf(x, y, z);
+    const int cx = cell / (cellDimensions[1] * cellDimensions[2]);
+    const int cy = (cell / cellDimensions[2]) % cellDimensions[1];
+    const int cz = cell % cellDimensions[2];
+
+    for (int dx = -1; dx <= 1; ++dx) {
+        int nx = cx + dx;
+        if (periodic) {
+            nx = (nx + cellDimensions[0]) % cellDimensions[0];
+        } else if (nx < 0 || nx >= cellDimensions[0]) {
+            continue;
+        }
+        for (int dy = -1; dy <= 1; ++dy) {
+            int ny = cy + dy;
+            if (periodic) {
+                ny = (ny + cellDimensions[1]) % cellDimensions[1];
+            } else if (ny < 0 || ny >= cellDimensions[1]) {
+                continue;
+            }
+            for (int dz = -1; dz <= 1; ++dz) {
+                int nz = cz + dz;
+                if (periodic) {
+                    nz = (nz + cellDimensions[2]) % cellDimensions[2];
+                } else if (nz < 0 || nz >= cellDimensions[2]) {
+                    continue;
+                }
+                int neighborCell = (nx * cellDimensions[1] + ny) * cellDimensions[2] + nz;
+                for (int j = cellHead[neighborCell]; j >= 0; j = cellNext[j]) {
+                    visit(j);
+                }
+            }
+        }
+    }
+}
+
+bool IncrementalEnergy::isExcluded(int i, int j) const {
+    for (int e = exclusions.offsets[i]; e < exclusions.offsets[i + 1]; ++e) {
+        if (exclusions.indices[e] == j) return true;
+        if (exclusions.indices[e] > j) return false;
+    }
+    return false;
+}
+
+double IncrementalEnergy::pairEnergy(int i, int j) const {
+    const ParticleArrays& particles = system.getParticles();
+
+    double dx = particles.x[i] - particles.x[j];
+    double dy = particles.y[i] - particles.y[j];
+    double dz = particles.z[i] - particles.z[j];
+
+    if (periodic) {
+        dx -= boxLength[0] * std::round(dx / boxLength[0]);
+        dy -= boxLength[1] * std::round(dy / boxLength[1]);
+        dz -= boxLength[2] * std::round(dz / boxLength[2]);
+    }
+
+    double r2 = dx * dx + dy * dy + dz * dz;
+    if (r2 > cutoff2 || r2 < 1e-20 || isExcluded(i, j)) return 0.0;
+
+    if (const PairTableSet* tables = system.getPairTables()) {
+        const std::vector<PairTable>& tableList = tables->getTables();
+        double energy = 0.0;
+        int pairTable = tables->getTableIndex()[particles.type[i] * tables->getNumTypes() + particles.type[j]];
+        if (pairTable >= 0) {
+            energy += tableList[pairTable].evaluate(r2)[0];
+        }
+        if (tables->hasCoulombTable()) {
+            energy += COULOMB_CONSTANT * particles.charge[i] * particles.charge[j] /
+                      system.getDielectricConstant() *
+                      tableList[tables->getCoulombIndex()].evaluate(r2)[0];
+        }
+        return energy;
+    }
+
+    double sigma = 0.5 * (particles.sigma[i] + particles.sigma[j]);
+    double epsilon = std::sqrt(particles.epsilon[i] * particles.epsilon[j]);
+    double sr2 = sigma * sigma / r2;
+    double sr6 = sr2 * sr2 * sr2;
+
+    double lj = 4.0 * epsilon * (sr6 * sr6 - sr6);
+    double coulomb = COULOMB_CONSTANT * particles.charge[i] * particles.charge[j] /
+                     (system.getDielectricConstant() * std::sqrt(r2));
+
+    return lj + coulomb;
+}
+
+static std::array<double, 3> positionOf(const ParticleArrays& particles, int atom) {
+    return {particles.x[atom], particles.y[atom], particles.z[atom]};
+}
+
+double IncrementalEnergy::bondTermEnergy(int term) const {
+    const ParticleArrays& particles = system.getParticles();
+    const BondData& bond = system.getTopology().bonds[term];
+    double length = BondedInteractions::calculateBondLength(
+        positionOf(particles, bond.atom1Id), positionOf(particles, bond.atom2Id));
+    return BondedInteractions::calculateBondEnergy(
+        length, bond.equilibriumLength, bond.forceConstant);
+}
+
+double IncrementalEnergy::angleTermEnergy(int term) const {
+    const ParticleArrays& particles = system.getParticles();
+    const AngleData& angle = system.getTopology().angles[term];
+    double theta = BondedInteractions::calculateAngle(
+        positionOf(particles, angle.atom1Id),
+        positionOf(particles, angle.atom2Id),
+        positionOf(particles, angle.atom3Id));
+    return BondedInteractions::calculateAngleEnergy(
+        theta, angle.equilibriumAngle, angle.forceConstant);
+}
+
+double IncrementalEnergy::dihedralTermEnergy(int term) const {
+    const ParticleArrays& particles = system.getParticles();
+    const DihedralData& dihedral = system.getTopology().dihedrals[term];
+    double phi = BondedInteractions::calculateDihedral(
+        positionOf(particles, dihedral.atom1Id),
+        positionOf(particles, dihedral.atom2Id),
+        positionOf(particles, dihedral.atom3Id),
+        positionOf(particles, dihedral.atom4Id));
+    return BondedInteractions::calculateDihedralEnergy(
+        phi, dihedral.periodicity, dihedral.barrierHeight, dihedral.phaseOffset);
+}
+
+double IncrementalEnergy::improperTermEnergy(int term) const {
+    const ParticleArrays& particles = system.getParticles();
+    const ImproperData& improper = system.getTopology().impropers[term];
+    double xi = BondedInteractions::calculateImproper(
+        positionOf(particles, improper.atom1Id),
+        positionOf(particles, improper.atom2Id),
+        positionOf(particles, improper.atom3Id),
+        positionOf(particles, improper.atom4Id));
+    return BondedInteractions::calculateImproperEnergy(
+        xi, improper.equilibriumAngle, improper.forceConstant);
+}
+
+// Pairs between two moved atoms are skipped: proposals move either a
+// single atom or a rigid fragment, so those distances do not change.
+double IncrementalEnergy::movedPairEnergy(double sign) {
+    const ParticleArrays& particles = system.getParticles();
+    double total = 0.0;
+
+    for (int i : movedAtoms) {
+        forEachCandidate(particles.x[i], particles.y[i], particles.z[i], [&](int j) {
+            if (movedStamp[j] == currentStamp) return;
+            double energy = pairEnergy(i, j);
+            if (energy == 0.0) return;
+            total += energy;
+            pairChanges.push_back({i, sign * energy});
+            pairChanges.push_back({j, sign * energy});
+        });
+    }
+
+    return total;
+}
+
+void IncrementalEnergy::collectTerms(
+    const std::vector<int>& offsets,
+    const std::vector<int>& terms,
+    std::vector<unsigned>& stamps,
+    std::vector<TermChange>& changes) {
+
+    changes.clear();
+    for (int atom : movedAtoms) {
+        for (int e = offsets[atom]; e < offsets[atom + 1]; ++e) {
+            int term = terms[e];
+            if (stamps[term] == currentStamp) continue;
+            stamps[term] = currentStamp;
+            changes.push_back({term, 0.0});
+        }
+    }
+}
+
+double IncrementalEnergy::evaluateMove() {
+    ParticleArrays& particles = system.getParticles();
+
+    pairChanges.clear();
+    double oldPair = movedPairEnergy(-1.0);
+
+    collectTerms(bondOffsets, bondTerms, bondStamps, bondChanges);
+    collectTerms(angleOffsets, angleTerms, angleStamps, angleChanges);
+    collectTerms(dihedralOffsets, dihedralTerms, dihedralStamps, dihedralChanges);
+    collectTerms(improperOffsets, improperTerms, improperStamps, improperChanges);
+
+    // The bonded kernels throw on degenerate geometry, such as a trial
+    // position on top of a neighbor; the System must not keep it then.
+    double newPair = 0.0;
+    double delta = 0.0;
+    savedPositions.clear();
+    try {
+        for (size_t m = 0; m < movedAtoms.size(); ++m) {
+            int atom = movedAtoms[m];
+            savedPositions.push_back(positionOf(particles, atom));
+            particles.x[atom] = trialPositions[m][0];
+            particles.y[atom] = trialPositions[m][1];
+            particles.z[atom] = trialPositions[m][2];
+        }
+
+        newPair = movedPairEnergy(1.0);
+        delta = newPair - oldPair;
+
+        for (auto& change : bondChanges) {
+            change.energy = bondTermEnergy(change.term);
+            delta += change.energy - bondEnergies[change.term];
+        }
+        for (auto& change : angleChanges) {
+            change.energy = angleTermEnergy(change.term);
+            delta += change.energy - angleEnergies[change.term];
+        }
+        for (auto& change : dihedralChanges) {
+            change.energy = dihedralTermEnergy(change.term);
+            delta += change.energy - dihedralEnergies[change.term];
+        }
+        for (auto& change : improperChanges) {
+            change.energy = improperTermEnergy(change.term);
+            delta += change.energy - improperEnergies[change.term];
+        }
+    } catch (...) {
+        restorePositions();
+        throw;
+    }
+
+    pendingPairDelta = newPair - oldPair;
+    pending = true;
+    return delta;
+}
+
+void IncrementalEnergy::advanceStamp() {
+    if (++currentStamp != 0) return;
+    std::fill(movedStamp.begin(), movedStamp.end(), 0u);
+    std::fill(bondStamps.begin(), bondStamps.end(), 0u);
+    std::fill(angleStamps.begin(), angleStamps.end(), 0u);
+    std::fill(dihedralStamps.begin(), dihedralStamps.end(), 0u);
+    std::fill(improperStamps.begin(), improperStamps.end(), 0u);
+    currentStamp = 1;
+}
+
+double IncrementalEnergy::proposeAtomMove(int atomId, const std::array<double, 3>& newPosition) {
+    ensureCurrent();
+
+    if (atomId < 0 || static_cast<size_t>(atomId) >= system.getNumAtoms()) {
+        throw std::runtime_error("Atom index " + std::to_string(atomId) + " out of range");
+    }
+
+    advanceStamp();
+    int atom = system.getCurrentIndex(atomId);
+    movedAtoms.assign(1, atom);
+    movedStamp[atom] = currentStamp;
+    trialPositions.assign(1, newPosition);
+
+    return evaluateMove();
+}
+
+double IncrementalEnergy::proposeBondRotation(int bondIndex, double angle) {
+    ensureCurrent();
+
+    const TopologyData& topology = system.getTopology();
+    if (bondIndex < 0 || static_cast<size_t>(bondIndex) >= topology.bonds.size()) {
+        throw std::runtime_error("Bond index " + std::to_string(bondIndex) + " out of range");
+    }
+
+    const BondData& bond = topology.bonds[bondIndex];
+    if (!bond.isRotatable) {
+        throw std::runtime_error("Bond " + std::to_string(bondIndex) + " is not rotatable");
+    }
+
+    advanceStamp();
+
+    // Everything reachable from atom2 without crossing the bond rotates.
+    const int pivot = bond.atom1Id;
+    const int axisAtom = bond.atom2Id;
+    searchQueue.assign(1, axisAtom);
+    movedStamp[axisAtom] = currentStamp;
+    movedAtoms.clear();
+
+    for (size_t head = 0; head < searchQueue.size(); ++head) {
+        int atom = searchQueue[head];
+        for (int e = bondOffsets[atom]; e < bondOffsets[atom + 1]; ++e) {
+            int term = bondTerms[e];
+            if (term == bondIndex) continue;
+
+            const BondData& other = topology.bonds[term];
+            int neighbor = other.atom1Id == atom ? other.atom2Id : other.atom1Id;
+            if (neighbor == pivot) {
+                throw std::runtime_error("Bond " + std::to_string(bondIndex) + " is part of a ring");
+            }
+            if (movedStamp[neighbor] == currentStamp) continue;
+
+            movedStamp[neighbor] = currentStamp;
+            searchQueue.push_back(neighbor);
+            movedAtoms.push_back(neighbor);
+        }
+    }
+    movedStamp[axisAtom] = 0;
+
+    const ParticleArrays& particles = system.getParticles();
+    const std::array<double, 3> origin = positionOf(particles, axisAtom);
+    std::array<double, 3> axis = {
+        origin[0] - particles.x[pivot],
+        origin[1] - particles.y[pivot],
+        origin[2] - particles.z[pivot]};
+    double axisLength = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    if (axisLength < 1e-10) {
+        throw std::runtime_error("Bond " + std::to_string(bondIndex) + " has zero length");
+    }
+    for (double& component : axis) component /= axisLength;
+
+    const double c = std::cos(angle);
+    const double s = std::sin(angle);
+    trialPositions.clear();
+    for (int atom : movedAtoms) {
+        double vx = particles.x[atom] - origin[0];
+        double vy = particles.y[atom] - origin[1];
+        double vz = particles.z[atom] - origin[2];
+        double dot = axis[0] * vx + axis[1] * vy + axis[2] * vz;
+        double cx = axis[1] * vz - axis[2] * vy;
+        double cy = axis[2] * vx - axis[0] * vz;
+        double cz = axis[0] * vy - axis[1] * vx;
+        trialPositions.push_back({
+            origin[0] + vx * c + cx * s + axis[0] * dot * (1.0 - c),
+            origin[1] + vy * c + cy * s + axis[1] * dot * (1.0 - c),
+            origin[2] + vz * c + cz * s + axis[2] * dot * (1.0 - c)});
+    }
+
+    return evaluateMove();
+}
+
+void IncrementalEnergy::commit() {
+    if (!pending) {
+        throw std::runtime_error("No proposed move to commit");
+    }
+
+    for (const auto& change : bondChanges) {
+        bondedTotal += change.energy - bondEnergies[change.term];
+        bondEnergies[change.term] = change.energy;
+    }
+    for (const auto& change : angleChanges) {
+        bondedTotal += change.energy - angleEnergies[change.term];
+        angleEnergies[change.term] = change.energy;
+    }
+    for (const auto& change : dihedralChanges) {
+        bondedTotal += change.energy - dihedralEnergies[change.term];
+        dihedralEnergies[change.term] = change.energy;
+    }
+    for (const auto& change : improperChanges) {
+        bondedTotal += change.energy - improperEnergies[change.term];
+        improperEnergies[change.term] = change.energy;
+    }
+    for (const auto& change : pairChanges) {
+        atomPairEnergy[change.atom] += change.energy;
+    }
+    pairTotal += pendingPairDelta;
+
+    const ParticleArrays& particles = system.getParticles();
+    if (useCells) {
+        for (int atom : movedAtoms) {
+            int cell = cellOf(particles.x[atom], particles.y[atom], particles.z[atom]);
+            if (cell == atomCell[atom]) continue;
+            removeFromCell(atom);
+            insertIntoCell(atom, cell);
+        }
+    }
+
+    system.markPositionsChanged();
+    version = system.getStateVersion();
+    pending = false;
+}
+
+void IncrementalEnergy::reject() {
+    if (!pending) {
+        throw std::runtime_error("No proposed move to reject");
+    }
+
+    restorePositions();
+    pending = false;
+}
+
+void IncrementalEnergy::restorePositions() {
+    ParticleArrays& particles = system.getParticles();
+    for (size_t m = 0; m < savedPositions.size(); ++m) {
+        int atom = movedAtoms[m];
+        particles.x[atom] = savedPositions[m][0];
+        particles.y[atom] = savedPositions[m][1];
+        particles.z[atom] = savedPositions[m][2];
+    }
+}
+
+double IncrementalEnergy::getTotalEnergy() {
+    ensureCurrent();
+    return bondedTotal + pairTotal;
+}
+
+double IncrementalEnergy::getAtomEnergy(int atomId) {
+    ensureCurrent();
+
+    if (atomId < 0 || static_cast<size_t>(atomId) >= system.getNumAtoms()) {
+        throw std::runtime_error("Atom index " + std::to_string(atomId) + " out of range");
+    }
+
+    // Each bonded term is shared equally between its atoms and each pair
+    // between its two atoms, so the atom energies sum to the total.
+    int atom = system.getCurrentIndex(atomId);
+    double energy = 0.5 * atomPairEnergy[atom];
+    for (int e = bondOffsets[atom]; e < bondOffsets[atom + 1]; ++e) {
+        energy += bondEnergies[bondTerms[e]] / 2.0;
+    }
+    for (int e = angleOffsets[atom]; e < angleOffsets[atom + 1]; ++e) {
+        energy += angleEnergies[angleTerms[e]] / 3.0;
+    }
+    for (int e = dihedralOffsets[atom]; e < dihedralOffsets[atom + 1]; ++e) {
+        energy += dihedralEnergies[dihedralTerms[e]] / 4.0;
+    }
+    for (int e = improperOffsets[atom]; e < improperOffsets[atom + 1]; ++e) {
+        energy += improperEnergies[improperTerms[e]] / 4.0;
+    }
+    return energy;
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include "generate_exclusions.h"
+#include "system.h"
+
+// Caches per-term bonded energies and per-atom nonbonded sums for a System
+// so that the energy change of moving one atom, or of rotating the atoms
+// behind a rotatable bond, is computed from the affected terms and
+// neighbor pairs only. A proposal is applied to the System positions
+// tentatively and must be followed by commit() or reject().
+//
+// Atom ids are insertion-order ids, as everywhere else on System.
+class IncrementalEnergy {
+public:
+
+    explicit IncrementalEnergy(System& system);
+
+    void rebuild();
+
+    double getTotalEnergy();
+
+    double getAtomEnergy(int atomId);
+
+    double proposeAtomMove(int atomId, const std::array<double, 3>& newPosition);
+
+    double proposeBondRotation(int bondIndex, double angle);
+
+    void commit();
+
+    void reject();
+
+    bool hasPendingMove() const { return pending; }
+
+    const std::vector<int>& getMovedAtoms() const { return movedAtoms; }
+
+private:
+
+    struct TermChange {
+        int term;
+        double energy;
+    };
+
+    struct PairChange {
+        int atom;
+        double energy;
+    };
+
+    void ensureCurrent();
+
+    void buildCells();
+
+    int cellOf(double x, double y, double z) const;
+
+    template <typename Visitor>
+    void forEachCandidate(double x, double y, double z, Visitor&& visit) const;
+
+    void insertIntoCell(int atom, int cell);
+
+    void removeFromCell(int atom);
+
+    double pairEnergy(int i, int j) const;
+
+    double movedPairEnergy(double sign);
+
+    double bondTermEnergy(int term) const;
+
+    double angleTermEnergy(int term) const;
+
+    double dihedralTermEnergy(int term) const;
+
+    double improperTermEnergy(int term) const;
+
+    double evaluateMove();
+
+    void restorePositions();
+
+    void advanceStamp();
+
+    void collectTerms(
+        const std::vector<int>& offsets,
+        const std::vector<int>& terms,
+        std::vector<unsigned>& stamps,
+        std::vector<TermChange>& changes);
+
+    bool isExcluded(int i, int j) const;
+
+    System& system;
+    unsigned long long version = 0;
+    bool built = false;
+    bool pending = false;
+
+    ExclusionLists exclusions;
+    std::vector<int> bondOffsets, bondTerms;
+    std::vector<int> angleOffsets, angleTerms;
+    std::vector<int> dihedralOffsets, dihedralTerms;
+    std::vector<int> improperOffsets, improperTerms;
+
+    std::vector<double> bondEnergies;
+    std::vector<double> angleEnergies;
+    std::vector<double> dihedralEnergies;
+    std::vector<double> improperEnergies;
+    std::vector<double> atomPairEnergy;
+    double bondedTotal = 0.0;
+    double pairTotal = 0.0;
+
+    double cutoff2 = 0.0;
+    std::array<double, 3> boxLength = {0.0, 0.0, 0.0};
+    bool periodic = false;
+    bool useCells = false;
+    std::array<int, 3> cellDimensions = {1, 1, 1};
+    std::array<double, 3> cellOrigin = {0.0, 0.0, 0.0};
+    std::array<double, 3> inverseCellSize = {0.0, 0.0, 0.0};
+    std::vector<int> cellHead;
+    std::vector<int> cellNext;
+    std::vector<int> cellPrevious;
+    std::vector<int> atomCell;
+
+    std::vector<int> movedAtoms;
+    std::vector<unsigned> movedStamp;
+    unsigned currentStamp = 0;
+    std::vector<std::array<double, 3>> savedPositions;
+    std::vector<std::array<double, 3>> trialPositions;
+    std::vector<int> searchQueue;
+    std::vector<unsigned> bondStamps, angleStamps, dihedralStamps, improperStamps;
+    std::vector<TermChange> bondChanges, angleChanges, dihedralChanges, improperChanges;
+    std::vector<PairChange> pairChanges;
+    double pendingPairDelta = 0.0;
+};
@@ -0,0 +1,196 @@
+#include "replica_exchange.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+ReplicaExchange::ReplicaExchange(
+    const System& system,
+    const std::vector<double>& temperatures,
+    const ReplicaExchangeOptions& options)
+    : options(options),
+      temperatures(temperatures),
+      swapGenerator(options.seed),
+      pool(options.numThreads) {
+
+    if (temperatures.empty()) {
+        throw std::runtime_error("Replica exchange needs at least one temperature");
+    }
+    for (size_t k = 0; k < temperatures.size(); ++k) {
+        if (temperatures[k] <= 0.0 || (k > 0 && temperatures[k] <= temperatures[k - 1])) {
+            throw std::runtime_error("Replica temperatures must be positive and increasing");
+        }
+    }
+    if (options.timestep <= 0.0 || options.exchangeInterval < 1 ||
+        options.thermostatInterval < 1 || options.thermostatTimeConstant <= 0.0) {
+        throw std::runtime_error("Invalid replica exchange options");
+    }
+    if (system.getNumAtoms() == 0) {
+        throw std::runtime_error("Replica exchange needs a system with atoms");
+    }
+
+    // Building exclusions and parameters once before copying lets every
+    // replica share them.
+    System prepared = system;
+
+    // The replicas already keep the pool busy; Generalized Born threads of
+    // their own would only oversubscribe it.
+    if (prepared.hasImplicitSolvent()) {
+        GeneralizedBornOptions solventOptions = prepared.getImplicitSolventOptions();
+        solventOptions.numThreads = 1;
+        prepared.setImplicitSolvent(solventOptions);
+    }
+    const double initialPotential = prepared.computeForces().potential;
+
+    const int numAtoms = static_cast<int>(prepared.getNumAtoms());
+    degreesOfFreedom = numAtoms > 1 ? 3 * numAtoms - 3 : 3;
+
+    const int numReplicas = static_cast<int>(temperatures.size());
+    replicas.reserve(numReplicas);
+    for (int r = 0; r < numReplicas; ++r) {
+        std::seed_seq seed = {static_cast<uint32_t>(options.seed),
+                              static_cast<uint32_t>(options.seed >> 32),
+                              static_cast<uint32_t>(r + 1)};
+        generators.emplace_back(seed);
+        replicas.push_back(prepared);
+
+        // Maxwell-Boltzmann velocities with zero total momentum.
+        ParticleArrays& particles = replicas[r].getParticles();
+        std::normal_distribution<double> normal(0.0, 1.0);
+        double momentum[3] = {0.0, 0.0, 0.0};
+        double totalMass = 0.0;
+        for (int i = 0; i < numAtoms; ++i) {
+            double width = std::sqrt(BOLTZMANN_CONSTANT * temperatures[r] * ACCELERATION_CONVERSION /
+                                     particles.mass[i]);
+            particles.vx[i] = width * normal(generators[r]);
+            particles.vy[i] = width * normal(generators[r]);
+            particles.vz[i] = width * normal(generators[r]);
+            momentum[0] += particles.mass[i] * particles.vx[i];
+            momentum[1] += particles.mass[i] * particles.vy[i];
+            momentum[2] += particles.mass[i] * particles.vz[i];
+            totalMass += particles.mass[i];
+        }
+        if (numAtoms > 1) {
+            for (int i = 0; i < numAtoms; ++i) {
+                particles.vx[i] -= momentum[0] / totalMass;
+                particles.vy[i] -= momentum[1] / totalMass;
+                particles.vz[i] -= momentum[2] / totalMass;
+            }
+        }
+    }
+
+    temperatureIndex.resize(numReplicas);
+    for (int r = 0; r < numReplicas; ++r) {
+        temperatureIndex[r] = r;
+    }
+    potentialEnergy.assign(numReplicas, initialPotential);
+    pairAttempts.assign(std::max(numReplicas - 1, 0), 0);
+    pairAccepts.assign(std::max(numReplicas - 1, 0), 0);
+    replicaAttempts.assign(numReplicas, 0);
+    replicaAccepts.assign(numReplicas, 0);
+}
+
+void ReplicaExchange::run(int numExchanges) {
+    for (int e = 0; e < numExchanges; ++e) {
+        pool.run(getNumReplicas(), [this](int replica) { advance(replica); });
+        attemptSwaps();
+    }
+}
+
+const System& ReplicaExchange::getReplica(int replica) const {
+    if (replica < 0 || replica >= getNumReplicas()) {
+        throw std::runtime_error("Replica index " + std::to_string(replica) + " out of range");
+    }
+    return replicas[replica];
+}
+
+void ReplicaExchange::advance(int replica) {
+    System& system = replicas[replica];
+    SystemEnergy energy = {};
+    for (int done = 0; done < options.exchangeInterval; done += options.thermostatInterval) {
+        int numSteps = std::min(options.thermostatInterval, options.exchangeInterval - done);
+        energy = system.step(numSteps, options.timestep);
+        thermostat(replica, numSteps);
+    }
+    potentialEnergy[replica] = energy.potential;
+}
+
+void ReplicaExchange::rescaleVelocities(int replica, double factor) {
+    ParticleArrays& particles = replicas[replica].getParticles();
+    for (size_t i = 0; i < particles.size(); ++i) {
+        particles.vx[i] *= factor;
+        particles.vy[i] *= factor;
+        particles.vz[i] *= factor;
+    }
+}
+
+// Stochastic velocity rescaling (Bussi, Donadio and Parrinello,
+// J. Chem. Phys. 126, 014101 (2007)): draws the new kinetic energy from
+// the canonical distribution relaxed over thermostatTimeConstant after
+// numSteps steps.
+void ReplicaExchange::thermostat(int replica, int numSteps) {
+    const double kinetic = replicas[replica].computeKineticEnergy();
+    if (kinetic <= 0.0) {
+        return;
+    }
+
+    const double dof = degreesOfFreedom;
+    const double target = 0.5 * dof * BOLTZMANN_CONSTANT * temperatures[temperatureIndex[replica]];
+    const double c = std::exp(-numSteps * options.timestep /
+                              options.thermostatTimeConstant);
+
+    std::mt19937_64& generator = generators[replica];
+    std::normal_distribution<double> normal(0.0, 1.0);
+    const double r1 = normal(generator);
+    double sumSquares = 0.0;
+    if (degreesOfFreedom > 1) {
+        std::gamma_distribution<double> chiSquared(0.5 * (dof - 1.0), 2.0);
+        sumSquares = chiSquared(generator);
+    }
+
+    const double ratio = target / (dof * kinetic);
+    double alpha2 = c + (1.0 - c) * (sumSquares + r1 * r1) * ratio +
+                    2.0 * r1 * std::sqrt(c * (1.0 - c) * ratio);
+    double alpha = std::sqrt(std::max(alpha2, 0.0));
+    if (r1 + std::sqrt(c / ((1.0 - c) * ratio)) < 0.0) {
+        alpha = -alpha;
+    }
+    rescaleVelocities(replica, alpha);
+}
+
+void ReplicaExchange::attemptSwaps() {
+    const int numTemperatures = static_cast<int>(temperatures.size());
+    std::vector<int> replicaAt(numTemperatures);
+    for (int r = 0; r < getNumReplicas(); ++r) {
+        replicaAt[temperatureIndex[r]] = r;
+    }
+
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    for (int k = static_cast<int>(exchangeCount % 2); k + 1 < numTemperatures; k += 2) {
+        const int a = replicaAt[k];
+        const int b = replicaAt[k + 1];
+        const double betaA = 1.0 / (BOLTZMANN_CONSTANT * temperatures[k]);
+        const double betaB = 1.0 / (BOLTZMANN_CONSTANT * temperatures[k + 1]);
+        const double delta = (betaA - betaB) * (potentialEnergy[a] - potentialEnergy[b]);
+
+        ++pairAttempts[k];
+        ++replicaAttempts[a];
+        ++replicaAttempts[b];
+
+        const double draw = uniform(swapGenerator);
+        if (delta >= 0.0 || draw < std::exp(delta)) {
+            temperatureIndex[a] = k + 1;
+            temperatureIndex[b] = k;
+            replicaAt[k] = b;
+            replicaAt[k + 1] = a;
+            rescaleVelocities(a, std::sqrt(temperatures[k + 1] / temperatures[k]));
+            rescaleVelocities(b, std::sqrt(temperatures[k] / temperatures[k + 1]));
+
+            ++pairAccepts[k];
+            ++replicaAccepts[a];
+            ++replicaAccepts[b];
+        }
+    }
+
+    ++exchangeCount;
+}
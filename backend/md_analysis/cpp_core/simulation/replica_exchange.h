@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "system.h"
+#include "work_stealing_pool.h"
+
+struct ReplicaExchangeOptions {
+    double timestep = 1.0;
+    // MD steps each replica runs between two rounds of swap attempts.
+    int exchangeInterval = 500;
+    // Steps between stochastic velocity rescalings (Bussi thermostat) and
+    // its relaxation time in fs.
+    int thermostatInterval = 10;
+    double thermostatTimeConstant = 100.0;
+    uint64_t seed = 12345;
+    int numThreads = 0;
+};
+
+// Parallel tempering over copies of one System. Replicas share the
+// template's topology, exclusions and pair tables read-only (copies of a
+// System share them until one modifies or sorts its own), while each keeps
+// its own particles and neighbor list. Between exchanges the replicas run
+// concurrently on a WorkStealingPool, each thermostatted at its current
+// temperature; implicit solvent runs serially within each replica. Every
+// exchange round attempts Metropolis swaps between neighboring
+// temperatures, alternating even and odd pairs; an accepted swap exchanges
+// the replicas' temperatures and rescales their velocities.
+//
+// All random numbers come from per-replica generators and one driver
+// generator seeded from options.seed, and every force term sums in an
+// order fixed by the atom count, so results do not depend on the number
+// of threads.
+class ReplicaExchange {
+public:
+
+    // temperatures in K, in increasing order; replica r starts at
+    // temperatures[r] with Maxwell-Boltzmann velocities.
+    ReplicaExchange(
+        const System& system,
+        const std::vector<double>& temperatures,
+        const ReplicaExchangeOptions& options = ReplicaExchangeOptions());
+
+    // Runs numExchanges rounds of exchangeInterval steps plus swap attempts.
+    void run(int numExchanges);
+
+    int getNumReplicas() const { return static_cast<int>(replicas.size()); }
+
+    const System& getReplica(int replica) const;
+
+    const std::vector<double>& getTemperatures() const { return temperatures; }
+
+    // Index into getTemperatures() that each replica currently runs at.
+    const std::vector<int>& getTemperatureIndices() const { return temperatureIndex; }
+
+    const std::vector<double>& getPotentialEnergies() const { return potentialEnergy; }
+
+    long long getExchangeCount() const { return exchangeCount; }
+
+    // Swap attempts and acceptances between temperatures k and k + 1.
+    const std::vector<long long>& getPairAttempts() const { return pairAttempts; }
+
+    const std::vector<long long>& getPairAccepts() const { return pairAccepts; }
+
+    // Swap attempts and acceptances in which each replica took part.
+    const std::vector<long long>& getReplicaAttempts() const { return replicaAttempts; }
+
+    const std::vector<long long>& getReplicaAccepts() const { return replicaAccepts; }
+
+    int getDegreesOfFreedom() const { return degreesOfFreedom; }
+
+    int getNumThreads() const { return pool.getNumThreads(); }
+
+private:
+
+    void advance(int replica);
+
+    void rescaleVelocities(int replica, double factor);
+
+    void thermostat(int replica, int numSteps);
+
+    void attemptSwaps();
+
+    ReplicaExchangeOptions options;
+    std::vector<double> temperatures;
+    std::vector<System> replicas;
+    std::vector<std::mt19937_64> generators;
+    std::vector<int> temperatureIndex;
+    std::vector<double> potentialEnergy;
+    std::mt19937_64 swapGenerator;
+    int degreesOfFreedom = 0;
+    long long exchangeCount = 0;
+    std::vector<long long> pairAttempts;
+    std::vector<long long> pairAccepts;
+    std::vector<long long> replicaAttempts;
+    std::vector<long long> replicaAccepts;
+    WorkStealingPool pool;
+};
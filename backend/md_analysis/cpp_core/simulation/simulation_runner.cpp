@@ -0,0 +1,129 @@
+#include "simulation_runner.h"
+#include <algorithm>
+#include <stdexcept>
+
+SimulationRunner::SimulationRunner(System& system, double timestep, int stepsPerFrame)
+    : system(system), timestep(timestep), stepsPerFrame(std::max(1, stepsPerFrame)) {}
+
+SimulationRunner::~SimulationRunner() {
+    stop();
+}
+
+void SimulationRunner::start() {
+    if (worker.joinable()) {
+        throw std::runtime_error("Simulation runner is already started");
+    }
+
+    const size_t numValues = 3 * system.getNumAtoms();
+    snapshots.forEachSlot([numValues](SimulationSnapshot& snapshot) {
+        snapshot.positions.assign(numValues, 0.0);
+    });
+
+    {
+        std::lock_guard<std::mutex> lock(controlMutex);
+        stopRequested = false;
+        paused = false;
+        pendingSteps = 0;
+        error.clear();
+    }
+
+    running.store(true, std::memory_order_release);
+    worker = std::thread(&SimulationRunner::run, this);
+}
+
+void SimulationRunner::pause() {
+    std::lock_guard<std::mutex> lock(controlMutex);
+    paused = true;
+}
+
+void SimulationRunner::resume() {
+    {
+        std::lock_guard<std::mutex> lock(controlMutex);
+        paused = false;
+    }
+    controlChanged.notify_one();
+}
+
+void SimulationRunner::step(int numSteps) {
+    {
+        std::lock_guard<std::mutex> lock(controlMutex);
+        paused = true;
+        pendingSteps += std::max(0, numSteps);
+    }
+    controlChanged.notify_one();
+}
+
+void SimulationRunner::stop() {
+    {
+        std::lock_guard<std::mutex> lock(controlMutex);
+        stopRequested = true;
+    }
+    controlChanged.notify_one();
+
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+bool SimulationRunner::isPaused() const {
+    std::lock_guard<std::mutex> lock(controlMutex);
+    return paused;
+}
+
+void SimulationRunner::setStepsPerFrame(int numSteps) {
+    stepsPerFrame.store(std::max(1, numSteps), std::memory_order_relaxed);
+}
+
+std::string SimulationRunner::getError() const {
+    std::lock_guard<std::mutex> lock(controlMutex);
+    return error;
+}
+
+void SimulationRunner::publish() {
+    const ParticleArrays& particles = system.getParticles();
+    SimulationSnapshot& snapshot = snapshots.getWriteBuffer();
+
+    snapshot.positions.resize(3 * particles.size());
+    for (size_t i = 0; i < particles.size(); ++i) {
+        double* row = &snapshot.positions[3 * static_cast<size_t>(particles.originalId[i])];
+        row[0] = particles.x[i];
+        row[1] = particles.y[i];
+        row[2] = particles.z[i];
+    }
+    snapshot.step = system.getStepCount();
+    snapshot.time = timestep * static_cast<double>(snapshot.step);
+
+    snapshots.publish();
+}
+
+void SimulationRunner::run() {
+    try {
+        snapshots.getWriteBuffer().energy = system.computeForces();
+        publish();
+
+        while (true) {
+            int numSteps;
+            {
+                std::unique_lock<std::mutex> lock(controlMutex);
+                controlChanged.wait(lock, [this] {
+                    return stopRequested || !paused || pendingSteps > 0;
+                });
+                if (stopRequested) break;
+
+                numSteps = stepsPerFrame.load(std::memory_order_relaxed);
+                if (paused) {
+                    numSteps = static_cast<int>(std::min<long long>(pendingSteps, numSteps));
+                    pendingSteps -= numSteps;
+                }
+            }
+
+            snapshots.getWriteBuffer().energy = system.step(numSteps, timestep);
+            publish();
+        }
+    } catch (const std::exception& exception) {
+        std::lock_guard<std::mutex> lock(controlMutex);
+        error = exception.what();
+    }
+
+    running.store(false, std::memory_order_release);
+}
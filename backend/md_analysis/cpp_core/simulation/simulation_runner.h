@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "system.h"
+#include "triple_buffer.h"
+
+struct SimulationSnapshot {
+    std::vector<double> positions;
+    SystemEnergy energy = {};
+    long long step = 0;
+    double time = 0.0;
+};
+
+// Advances a System on a worker thread and publishes a snapshot every
+// stepsPerFrame steps. While the runner is active the System belongs to
+// the worker and must not be used from other threads. Snapshot positions
+// are (N, 3) row-major in insertion order.
+class SimulationRunner {
+public:
+
+    SimulationRunner(System& system, double timestep, int stepsPerFrame = 10);
+
+    ~SimulationRunner();
+
+    SimulationRunner(const SimulationRunner&) = delete;
+    SimulationRunner& operator=(const SimulationRunner&) = delete;
+
+    void start();
+
+    void pause();
+
+    void resume();
+
+    void step(int numSteps);
+
+    void stop();
+
+    bool isRunning() const { return running.load(std::memory_order_acquire); }
+
+    bool isPaused() const;
+
+    void setStepsPerFrame(int numSteps);
+
+    int getStepsPerFrame() const { return stepsPerFrame.load(std::memory_order_relaxed); }
+
+    bool poll() { return snapshots.update(); }
+
+    const SimulationSnapshot& getSnapshot() const { return snapshots.getReadBuffer(); }
+
+    std::string getError() const;
+
+private:
+
+    void run();
+
+    void publish();
+
+    System& system;
+    double timestep;
+    std::atomic<int> stepsPerFrame;
+    TripleBuffer<SimulationSnapshot> snapshots;
+
+    std::thread worker;
+    mutable std::mutex controlMutex;
+    std::condition_variable controlChanged;
+    bool stopRequested = false;
+    bool paused = false;
+    long long pendingSteps = 0;
+    std::atomic<bool> running{false};
+    std::string error;
+};
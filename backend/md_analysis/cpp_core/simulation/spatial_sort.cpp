@@ -0,0 +1,71 @@
+#include "spatial_sort.h"
+#include "allocation_counter.h"
+#include "scratch_arena.h"
+#include <algorithm>
+#include <cmath>
+
+static uint32_t spreadBits(uint32_t value) {
+    value &= 0x3ff;
+    value = (value | (value << 16)) & 0x030000ff;
+    value = (value | (value << 8)) & 0x0300f00f;
+    value = (value | (value << 4)) & 0x030c30c3;
+    value = (value | (value << 2)) & 0x09249249;
+    return value;
+}
+
+uint32_t SpatialSort::mortonKey(uint32_t ix, uint32_t iy, uint32_t iz) {
+    return (spreadBits(ix) << 2) | (spreadBits(iy) << 1) | spreadBits(iz);
+}
+
+void SpatialSort::computeMortonOrder(
+    const PositionArrays<double>& positions,
+    const std::array<double, 3>& boxLength,
+    std::vector<int>& order) {
+
+    const size_t numAtoms = positions.count;
+    const double* coordinates[3] = {positions.x, positions.y, positions.z};
+    const bool periodic = boxLength[0] > 0.0 && boxLength[1] > 0.0 && boxLength[2] > 0.0;
+    const double gridSize = static_cast<double>(1 << BITS_PER_AXIS);
+
+    double origin[3];
+    double scale[3];
+    for (int d = 0; d < 3; ++d) {
+        double extent;
+        if (periodic) {
+            origin[d] = 0.0;
+            extent = boxLength[d];
+        } else {
+            auto range = std::minmax_element(coordinates[d], coordinates[d] + numAtoms);
+            origin[d] = numAtoms > 0 ? *range.first : 0.0;
+            extent = numAtoms > 0 ? *range.second - *range.first : 0.0;
+        }
+        scale[d] = extent > 0.0 ? gridSize / extent : 0.0;
+    }
+
+    // Key in the high half, atom index in the low half, so one integer sort
+    // orders atoms along the curve and keeps ties in index order.
+    ScratchArena& arena = ScratchArena::forThread();
+    ScratchArena::Scope scratch(arena);
+    uint64_t* keys = arena.allocate<uint64_t>(numAtoms);
+
+    for (size_t i = 0; i < numAtoms; ++i) {
+        uint32_t cell[3];
+        for (int d = 0; d < 3; ++d) {
+            double u = (coordinates[d][i] - origin[d]) * scale[d];
+            if (periodic) {
+                u -= gridSize * std::floor(u / gridSize);
+            }
+            cell[d] = static_cast<uint32_t>(std::min(std::max(u, 0.0), gridSize - 1.0));
+        }
+        keys[i] = (static_cast<uint64_t>(mortonKey(cell[0], cell[1], cell[2])) << 32) | i;
+    }
+
+    std::sort(keys, keys + numAtoms);
+
+    const size_t capacity = order.capacity();
+    order.resize(numAtoms);
+    for (size_t k = 0; k < numAtoms; ++k) {
+        order[k] = static_cast<int>(keys[k] & 0xffffffffu);
+    }
+    AllocationCounter::recordGrowth(order, capacity);
+}
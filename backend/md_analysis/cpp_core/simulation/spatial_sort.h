@@ -0,0 +1,20 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "precision.h"
+
+class SpatialSort {
+public:
+
+    static constexpr int BITS_PER_AXIS = 10;
+
+    static uint32_t mortonKey(uint32_t ix, uint32_t iy, uint32_t iz);
+
+    // order[k] is the current index of the atom that should move to index k.
+    static void computeMortonOrder(
+        const PositionArrays<double>& positions,
+        const std::array<double, 3>& boxLength,
+        std::vector<int>& order);
+};
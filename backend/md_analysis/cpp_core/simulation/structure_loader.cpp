@@ -0,0 +1,700 @@
+#include "structure_loader.h"
+#include "mapped_file.h"
+#include "radii_lists.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Powers of ten that are exact in a double.
+const double EXACT_POWERS_OF_TEN[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+const uint64_t MAX_EXACT_MANTISSA = uint64_t(1) << 53;
+
+struct Line {
+    const char* begin;
+    const char* end;
+};
+
+class LineReader {
+public:
+
+    LineReader(const char* data, size_t size) : next(data), last(data + size) {}
+
+    bool read(Line& line) {
+        if (next >= last) {
+            return false;
+        }
+        const char* newline = static_cast<const char*>(std::memchr(next, '\n', last - next));
+        line.begin = next;
+        line.end = newline ? newline : last;
+        if (line.end > line.begin && line.end[-1] == '\r') {
+            --line.end;
+        }
+        next = newline ? newline + 1 : last;
+        ++lineNumber;
+        return true;
+    }
+
+    int getLineNumber() const { return lineNumber; }
+
+private:
+    const char* next;
+    const char* last;
+    int lineNumber = 0;
+};
+
+bool isBlank(char c) {
+    return c == ' ' || c == '\t';
+}
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+const char* skipBlanks(const char* p, const char* end) {
+    while (p < end && isBlank(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+// Parses a decimal number at p, skipping leading blanks, and advances p past
+// it. Up to 19 significant digits with a power of ten no larger than 1e22
+// are converted with a single correctly rounded multiply or divide; anything
+// else falls back to strtod on a copy of the token.
+bool parseReal(const char*& p, const char* end, double& value) {
+    p = skipBlanks(p, end);
+    const char* start = p;
+
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        ++p;
+    }
+
+    uint64_t mantissa = 0;
+    int significantDigits = 0;
+    int exponent = 0;
+    bool anyDigits = false;
+    bool exact = true;
+
+    while (p < end && isDigit(*p)) {
+        anyDigits = true;
+        if (significantDigits < 19) {
+            mantissa = mantissa * 10 + (*p - '0');
+            significantDigits += mantissa != 0;
+        } else {
+            exact = false;
+        }
+        ++p;
+    }
+    if (p < end && *p == '.') {
+        ++p;
+        while (p < end && isDigit(*p)) {
+            anyDigits = true;
+            if (significantDigits < 19) {
+                mantissa = mantissa * 10 + (*p - '0');
+                significantDigits += mantissa != 0;
+                --exponent;
+            } else {
+                exact = false;
+            }
+            ++p;
+        }
+    }
+    if (!anyDigits) {
+        p = start;
+        return false;
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        bool negativeExponent = false;
+        if (q < end && (*q == '-' || *q == '+')) {
+            negativeExponent = *q == '-';
+            ++q;
+        }
+        if (q < end && isDigit(*q)) {
+            int written = 0;
+            while (q < end && isDigit(*q)) {
+                written = std::min(written * 10 + (*q - '0'), 100000);
+                ++q;
+            }
+            exponent += negativeExponent ? -written : written;
+            p = q;
+        }
+    }
+
+    if (exact && mantissa <= MAX_EXACT_MANTISSA && exponent >= -22 && exponent <= 22) {
+        double magnitude = static_cast<double>(mantissa);
+        magnitude = exponent < 0 ? magnitude / EXACT_POWERS_OF_TEN[-exponent]
+                                 : magnitude * EXACT_POWERS_OF_TEN[exponent];
+        value = negative ? -magnitude : magnitude;
+        return true;
+    }
+
+    std::string token(start, p);
+    value = std::strtod(token.c_str(), nullptr);
+    return true;
+}
+
+bool parseInteger(const char*& p, const char* end, long& value) {
+    p = skipBlanks(p, end);
+    const char* start = p;
+
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        ++p;
+    }
+    if (p == end || !isDigit(*p)) {
+        p = start;
+        return false;
+    }
+
+    long magnitude = 0;
+    while (p < end && isDigit(*p)) {
+        if (magnitude > 100000000000L) {
+            p = start;
+            return false;
+        }
+        magnitude = magnitude * 10 + (*p - '0');
+        ++p;
+    }
+    value = negative ? -magnitude : magnitude;
+    return true;
+}
+
+bool onlyBlanks(const char* p, const char* end) {
+    return skipBlanks(p, end) == end;
+}
+
+// Columns [column, column + width) of a fixed-format line, 1-based and
+// clipped to the line length.
+Line field(const Line& line, int column, int width) {
+    const char* begin = std::min(line.begin + column - 1, line.end);
+    const char* end = std::min(begin + width, line.end);
+    return {begin, end};
+}
+
+bool parseRealField(const Line& line, int column, int width, double& value) {
+    Line text = field(line, column, width);
+    const char* p = text.begin;
+    return parseReal(p, text.end, value) && onlyBlanks(p, text.end);
+}
+
+bool isRecord(const Line& line, const char* name) {
+    for (int i = 0; i < 6; ++i) {
+        char c = line.begin + i < line.end ? line.begin[i] : ' ';
+        if (c != name[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int base36Digit(char c) {
+    if (isDigit(c)) return c - '0';
+    if (c >= 'A' && c <= 'Z') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'z') return c - 'a' + 10;
+    return -1;
+}
+
+// Decodes a PDB atom serial, which is decimal up to 99999 and hybrid-36
+// beyond that ("A0000" = 100000, lowercase once the uppercase range runs out).
+bool parseSerial(const Line& text, long& serial) {
+    const char* p = skipBlanks(text.begin, text.end);
+    if (p == text.end) {
+        return false;
+    }
+    if (isDigit(*p) || *p == '-') {
+        return parseInteger(p, text.end, serial) && onlyBlanks(p, text.end);
+    }
+
+    const int width = static_cast<int>(text.end - text.begin);
+    if (width != 5 || p != text.begin) {
+        return false;
+    }
+    const bool upper = *p >= 'A' && *p <= 'Z';
+    long value = 0;
+    for (const char* c = text.begin; c < text.end; ++c) {
+        int digit = base36Digit(*c);
+        if (digit < 0 || (digit >= 10 && (*c >= 'A' && *c <= 'Z') != upper)) {
+            return false;
+        }
+        value = value * 36 + digit;
+    }
+
+    const long firstLetter = 10L * 36 * 36 * 36 * 36;
+    const long upperCount = 26L * 36 * 36 * 36 * 36;
+    serial = value - firstLetter + 100000 + (upper ? 0 : upperCount);
+    return true;
+}
+
+struct ElementParameters {
+    uint16_t code;
+    std::string symbol;
+    double mass;
+    double sigma;
+    double covalentRadius;
+};
+
+// Packs an element token into two characters with element case ("CL" and
+// "cl" both become "Cl"), dropping trailing labels such as the digits of
+// "C12". Returns 0 for tokens that do not start with a letter.
+uint16_t elementCode(const char* begin, const char* end) {
+    auto isLetter = [](char c) { return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z'); };
+    if (begin == end || !isLetter(*begin)) {
+        return 0;
+    }
+    char first = static_cast<char>(*begin & ~0x20);
+    char second = begin + 1 < end && isLetter(begin[1]) ? static_cast<char>(begin[1] | 0x20) : 0;
+    return static_cast<uint16_t>((static_cast<unsigned char>(first) << 8) |
+                                 static_cast<unsigned char>(second));
+}
+
+// Per-load cache of element parameters, so the hash lookups in RadiiLists
+// happen once per element rather than once per atom.
+class ElementCache {
+public:
+
+    // Index into getEntries() of the element, or -1 if it is unknown.
+    int find(uint16_t code) {
+        if (code == 0) {
+            return -1;
+        }
+        for (size_t i = 0; i < entries.size(); ++i) {
+            if (entries[i].code == code) {
+                return static_cast<int>(i);
+            }
+        }
+
+        std::string symbol(1, static_cast<char>(code >> 8));
+        if (code & 0xff) {
+            symbol += static_cast<char>(code & 0xff);
+        }
+        if (!RadiiLists::hasElement(symbol)) {
+            return -1;
+        }
+
+        // The VDW radius is half the LJ minimum distance 2^(1/6) sigma.
+        double sigma = 2.0 * RadiiLists::getVdwRadius(symbol) / std::pow(2.0, 1.0 / 6.0);
+        entries.push_back({code, symbol, RadiiLists::getAtomicMass(symbol), sigma,
+                           RadiiLists::getCovalentRadius(symbol)});
+        return static_cast<int>(entries.size()) - 1;
+    }
+
+    const ElementParameters& get(int index) const { return entries[index]; }
+
+private:
+    std::vector<ElementParameters> entries;
+};
+
+[[noreturn]] void throwParseError(const std::string& path, int lineNumber, const std::string& message) {
+    throw std::runtime_error(path + ":" + std::to_string(lineNumber) + ": " + message);
+}
+
+struct ParsedAtom {
+    int element;
+    std::array<double, 3> position;
+    double charge;
+};
+
+// Appends the atoms once the whole file has parsed, so that a malformed
+// file leaves the System as it was.
+void appendAtoms(System& system, const std::vector<ParsedAtom>& atoms,
+                 const ElementCache& elements, double epsilon) {
+    for (const auto& atom : atoms) {
+        const ElementParameters& element = elements.get(atom.element);
+        system.addAtom(element.symbol, atom.position, element.mass, atom.charge, element.sigma, epsilon);
+    }
+}
+
+// Element of a PDB atom from columns 77-78, or from the atom name when
+// those are blank. Names starting with a blank or a digit in column 13
+// have a one-letter element in column 14 (" CA ", "1HB "). Names starting
+// with a letter are two-letter elements ("FE  ", "CL1 "), except
+// hydrogens whose names fill column 13 ("HG21", "HE2 "), which would
+// otherwise read as mercury or helium.
+int pdbElement(const Line& line, ElementCache& elements) {
+    Line symbol = field(line, 77, 2);
+    const char* begin = skipBlanks(symbol.begin, symbol.end);
+    if (begin < symbol.end) {
+        return elements.find(elementCode(begin, symbol.end));
+    }
+
+    Line name = field(line, 13, 4);
+    if (name.begin == name.end) {
+        return -1;
+    }
+    if (*name.begin == ' ' || isDigit(*name.begin)) {
+        return elements.find(elementCode(name.begin + 1, std::min(name.begin + 2, name.end)));
+    }
+    const char* nameEnd = name.end;
+    while (nameEnd > name.begin && nameEnd[-1] == ' ') --nameEnd;
+    if ((*name.begin == 'H' || *name.begin == 'h') && nameEnd - name.begin > 2) {
+        return elements.find(elementCode(name.begin, name.begin + 1));
+    }
+    int index = elements.find(elementCode(name.begin, std::min(name.begin + 2, name.end)));
+    if (index < 0) {
+        index = elements.find(elementCode(name.begin, name.begin + 1));
+    }
+    return index;
+}
+
+// Formal charge from columns 79-80, written as "1-", "2+", ...
+double pdbCharge(const Line& line) {
+    Line text = field(line, 79, 2);
+    if (text.end - text.begin == 2 && isDigit(text.begin[0])) {
+        double magnitude = text.begin[0] - '0';
+        if (text.begin[1] == '+') return magnitude;
+        if (text.begin[1] == '-') return -magnitude;
+    }
+    return 0.0;
+}
+
+// Flags the bonds that may be rotated: those outside rings whose atoms
+// both have other bonds. Pairs hold (i << 32) | j with i < j. A bond lies
+// in a ring exactly when it is not a bridge of the bond graph, which an
+// iterative Tarjan low-link search finds in one pass.
+std::vector<uint8_t> rotatableBonds(int numAtoms, const std::vector<uint64_t>& pairs) {
+    std::vector<int> offsets(numAtoms + 1, 0);
+    for (uint64_t pair : pairs) {
+        ++offsets[(pair >> 32) + 1];
+        ++offsets[(pair & 0xffffffffu) + 1];
+    }
+    for (int a = 0; a < numAtoms; ++a) {
+        offsets[a + 1] += offsets[a];
+    }
+
+    std::vector<int> neighbors(2 * pairs.size());
+    std::vector<int> bondOf(2 * pairs.size());
+    std::vector<int> cursor(offsets.begin(), offsets.end() - 1);
+    for (size_t b = 0; b < pairs.size(); ++b) {
+        int i = static_cast<int>(pairs[b] >> 32);
+        int j = static_cast<int>(pairs[b] & 0xffffffffu);
+        neighbors[cursor[i]] = j;
+        bondOf[cursor[i]++] = static_cast<int>(b);
+        neighbors[cursor[j]] = i;
+        bondOf[cursor[j]++] = static_cast<int>(b);
+    }
+
+    struct Frame {
+        int atom;
+        int parentBond;
+        int next;
+    };
+    std::vector<int> order(numAtoms, -1);
+    std::vector<int> low(numAtoms, 0);
+    std::vector<uint8_t> bridge(pairs.size(), 0);
+    std::vector<Frame> stack;
+    int visited = 0;
+
+    for (int root = 0; root < numAtoms; ++root) {
+        if (order[root] >= 0) continue;
+        order[root] = low[root] = visited++;
+        stack.push_back({root, -1, offsets[root]});
+
+        while (!stack.empty()) {
+            Frame& frame = stack.back();
+            if (frame.next < offsets[frame.atom + 1]) {
+                const int k = frame.next++;
+                const int neighbor = neighbors[k];
+                if (bondOf[k] == frame.parentBond) continue;
+                if (order[neighbor] < 0) {
+                    order[neighbor] = low[neighbor] = visited++;
+                    stack.push_back({neighbor, bondOf[k], offsets[neighbor]});
+                } else {
+                    low[frame.atom] = std::min(low[frame.atom], order[neighbor]);
+                }
+                continue;
+            }
+
+            const Frame done = frame;
+            stack.pop_back();
+            if (!stack.empty()) {
+                const int parent = stack.back().atom;
+                low[parent] = std::min(low[parent], low[done.atom]);
+                if (low[done.atom] > order[parent]) {
+                    bridge[done.parentBond] = 1;
+                }
+            }
+        }
+    }
+
+    std::vector<uint8_t> rotatable(pairs.size(), 0);
+    for (size_t b = 0; b < pairs.size(); ++b) {
+        int i = static_cast<int>(pairs[b] >> 32);
+        int j = static_cast<int>(pairs[b] & 0xffffffffu);
+        rotatable[b] = bridge[b] && offsets[i + 1] - offsets[i] > 1 && offsets[j + 1] - offsets[j] > 1;
+    }
+    return rotatable;
+}
+
+}  // namespace
+
+StructureInfo StructureLoader::loadXyz(
+    const std::string& path,
+    System& system,
+    const StructureLoadOptions& options) {
+
+    MappedFile file(path);
+    LineReader reader(file.getData(), file.getSize());
+    ElementCache elements;
+
+    StructureInfo info{static_cast<int>(system.getNumAtoms()), 0, 0, {0.0, 0.0, 0.0}};
+
+    Line line{nullptr, nullptr};
+    long count = 0;
+    bool validHeader = reader.read(line);
+    const char* p = line.begin;
+    if (!validHeader || !parseInteger(p, line.end, count) || !onlyBlanks(p, line.end) || count < 0) {
+        throwParseError(path, reader.getLineNumber(), "expected the atom count");
+    }
+    if (!reader.read(line)) {
+        throwParseError(path, reader.getLineNumber(), "missing comment line");
+    }
+
+    // Every atom line takes at least eight bytes, which bounds a corrupt count.
+    std::vector<ParsedAtom> atoms;
+    atoms.reserve(std::min<size_t>(count, file.getSize() / 8));
+
+    for (long i = 0; i < count; ++i) {
+        if (!reader.read(line)) {
+            throwParseError(path, reader.getLineNumber(),
+                            "expected " + std::to_string(count) + " atoms, found " + std::to_string(i));
+        }
+
+        const char* symbolBegin = skipBlanks(line.begin, line.end);
+        const char* symbolEnd = symbolBegin;
+        while (symbolEnd < line.end && !isBlank(*symbolEnd)) {
+            ++symbolEnd;
+        }
+        int element = elements.find(elementCode(symbolBegin, symbolEnd));
+        if (element < 0) {
+            throwParseError(path, reader.getLineNumber(),
+                            "unknown element '" + std::string(symbolBegin, symbolEnd) + "'");
+        }
+
+        std::array<double, 3> position;
+        p = symbolEnd;
+        if (!parseReal(p, line.end, position[0]) ||
+            !parseReal(p, line.end, position[1]) ||
+            !parseReal(p, line.end, position[2])) {
+            throwParseError(path, reader.getLineNumber(), "expected x y z coordinates");
+        }
+
+        atoms.push_back({element, position, 0.0});
+    }
+
+    system.reserve(system.getNumAtoms() + atoms.size());
+    appendAtoms(system, atoms, elements, options.epsilon);
+    info.numAtoms = static_cast<int>(count);
+    return info;
+}
+
+StructureInfo StructureLoader::loadPdb(
+    const std::string& path,
+    System& system,
+    const StructureLoadOptions& options) {
+
+    MappedFile file(path);
+    LineReader reader(file.getData(), file.getSize());
+    ElementCache elements;
+
+    StructureInfo info{static_cast<int>(system.getNumAtoms()), 0, 0, {0.0, 0.0, 0.0}};
+
+    // ATOM records are 80 columns, so this over-reserves only by the
+    // non-atom records.
+    std::vector<ParsedAtom> atoms;
+    atoms.reserve(file.getSize() / 81);
+
+    std::vector<std::pair<long, int>> serials;
+    std::vector<std::pair<long, long>> connections;
+    bool modelDone = false;
+    // Alternate location kept for disordered atoms, set by the first one seen.
+    char keptAltLoc = ' ';
+
+    Line line{nullptr, nullptr};
+    while (reader.read(line)) {
+        if (isRecord(line, "ATOM  ") || isRecord(line, "HETATM")) {
+            if (modelDone) {
+                continue;
+            }
+
+            Line altLoc = field(line, 17, 1);
+            if (altLoc.begin < altLoc.end && *altLoc.begin != ' ') {
+                if (keptAltLoc == ' ') {
+                    keptAltLoc = *altLoc.begin;
+                } else if (*altLoc.begin != keptAltLoc) {
+                    continue;
+                }
+            }
+
+            long serial = 0;
+            if (!parseSerial(field(line, 7, 5), serial)) {
+                throwParseError(path, reader.getLineNumber(), "invalid atom serial number");
+            }
+
+            std::array<double, 3> position;
+            if (!parseRealField(line, 31, 8, position[0]) ||
+                !parseRealField(line, 39, 8, position[1]) ||
+                !parseRealField(line, 47, 8, position[2])) {
+                throwParseError(path, reader.getLineNumber(), "invalid coordinates");
+            }
+
+            int element = pdbElement(line, elements);
+            if (element < 0) {
+                throwParseError(path, reader.getLineNumber(), "unknown element");
+            }
+
+            atoms.push_back({element, position, pdbCharge(line)});
+            serials.push_back({serial, info.numAtoms});
+            ++info.numAtoms;
+        } else if (isRecord(line, "CONECT")) {
+            long from = 0;
+            if (!parseSerial(field(line, 7, 5), from)) {
+                throwParseError(path, reader.getLineNumber(), "invalid CONECT serial number");
+            }
+            for (int column = 12; column <= 27; column += 5) {
+                Line text = field(line, column, 5);
+                if (onlyBlanks(text.begin, text.end)) {
+                    continue;
+                }
+                long to = 0;
+                if (!parseSerial(text, to)) {
+                    throwParseError(path, reader.getLineNumber(), "invalid CONECT serial number");
+                }
+                connections.push_back({from, to});
+            }
+        } else if (isRecord(line, "CRYST1")) {
+            double a, b, c, alpha, beta, gamma;
+            bool valid = parseRealField(line, 7, 9, a) &&
+                         parseRealField(line, 16, 9, b) &&
+                         parseRealField(line, 25, 9, c) &&
+                         parseRealField(line, 34, 7, alpha) &&
+                         parseRealField(line, 41, 7, beta) &&
+                         parseRealField(line, 48, 7, gamma);
+            bool orthorhombic = valid &&
+                                std::abs(alpha - 90.0) < 1e-3 &&
+                                std::abs(beta - 90.0) < 1e-3 &&
+                                std::abs(gamma - 90.0) < 1e-3;
+            // A 1 x 1 x 1 cell is the placeholder for structures without a box.
+            bool placeholder = valid && a == 1.0 && b == 1.0 && c == 1.0;
+            if (orthorhombic && !placeholder && a > 0.0 && b > 0.0 && c > 0.0) {
+                info.boxLength = {a, b, c};
+            }
+        } else if (isRecord(line, "ENDMDL")) {
+            modelDone = true;
+        } else if (isRecord(line, "END   ")) {
+            break;
+        }
+    }
+
+    if (connections.empty()) {
+        system.reserve(system.getNumAtoms() + atoms.size());
+        appendAtoms(system, atoms, elements, options.epsilon);
+        return info;
+    }
+
+    // CONECT lists each bond from both ends; resolve serials, then keep one
+    // copy of each pair.
+    if (!std::is_sorted(serials.begin(), serials.end())) {
+        std::sort(serials.begin(), serials.end());
+    }
+    for (size_t i = 1; i < serials.size(); ++i) {
+        if (serials[i].first == serials[i - 1].first) {
+            throw std::runtime_error(path + ": duplicate atom serial " +
+                                     std::to_string(serials[i].first) +
+                                     ", CONECT records are ambiguous");
+        }
+    }
+    auto resolve = [&serials](long serial) {
+        auto it = std::lower_bound(serials.begin(), serials.end(), std::make_pair(serial, -1));
+        return it != serials.end() && it->first == serial ? it->second : -1;
+    };
+
+    std::vector<uint64_t> pairs;
+    pairs.reserve(connections.size());
+    for (const auto& connection : connections) {
+        int i = resolve(connection.first);
+        int j = resolve(connection.second);
+        if (i < 0 || j < 0 || i == j) {
+            continue;
+        }
+        pairs.push_back((static_cast<uint64_t>(std::min(i, j)) << 32) |
+                        static_cast<uint32_t>(std::max(i, j)));
+    }
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+    const std::vector<uint8_t> rotatable = rotatableBonds(info.numAtoms, pairs);
+    system.reserve(system.getNumAtoms() + atoms.size(), system.getTopology().bonds.size() + pairs.size());
+    appendAtoms(system, atoms, elements, options.epsilon);
+    for (size_t b = 0; b < pairs.size(); ++b) {
+        int i = static_cast<int>(pairs[b] >> 32);
+        int j = static_cast<int>(pairs[b] & 0xffffffffu);
+        double length = elements.get(atoms[i].element).covalentRadius +
+                        elements.get(atoms[j].element).covalentRadius;
+        system.addBond({info.firstAtom + i, info.firstAtom + j, 1,
+                        length, options.bondForceConstant, rotatable[b] != 0});
+    }
+    info.numBonds = static_cast<int>(pairs.size());
+    return info;
+}
+
+StructureInfo StructureLoader::load(
+    const std::string& path,
+    System& system,
+    const StructureLoadOptions& options) {
+
+    size_t dot = path.find_last_of('.');
+    std::string extension = dot == std::string::npos ? "" : path.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    if (extension == "xyz") {
+        return loadXyz(path, system, options);
+    }
+    if (extension == "pdb" || extension == "ent") {
+        return loadPdb(path, system, options);
+    }
+    throw std::runtime_error("Unsupported structure file format: " + path);
+}
+
+LoaderBenchmark StructureLoader::benchmark(const std::string& path, int repeats) {
+    if (repeats < 1) {
+        throw std::runtime_error("Benchmark needs at least one repeat");
+    }
+
+    LoaderBenchmark result{0, MappedFile(path).getSize(), 0.0, 0.0, 0.0};
+    for (int run = 0; run < repeats; ++run) {
+        System system;
+        auto start = std::chrono::steady_clock::now();
+        StructureInfo info = load(path, system);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (run == 0 || seconds < result.bestSeconds) {
+            result.bestSeconds = seconds;
+        }
+        result.numAtoms = info.numAtoms;
+    }
+
+    if (result.bestSeconds > 0.0) {
+        result.atomsPerSecond = result.numAtoms / result.bestSeconds;
+        result.megabytesPerSecond = result.fileBytes / result.bestSeconds / 1.0e6;
+    }
+    return result;
+}
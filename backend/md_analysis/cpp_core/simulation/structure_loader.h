@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include "system.h"
+
+struct StructureLoadOptions {
+    // Harmonic constant for bonds read from CONECT records, in kcal/(mol*A^2);
+    // the equilibrium length is the sum of the covalent radii.
+    double bondForceConstant = 300.0;
+    // LJ well depth given to every atom; sigma follows from the VDW radius.
+    double epsilon = 0.1;
+};
+
+struct StructureInfo {
+    int firstAtom;
+    int numAtoms;
+    int numBonds;
+    // Orthorhombic CRYST1 edge lengths, zero when the file has no usable box.
+    std::array<double, 3> boxLength;
+};
+
+struct LoaderBenchmark {
+    int numAtoms;
+    size_t fileBytes;
+    double bestSeconds;
+    double atomsPerSecond;
+    double megabytesPerSecond;
+};
+
+// Streaming XYZ and PDB readers that append atoms and bonds to a System.
+// Files are memory mapped and numbers parsed in place; element data (mass,
+// VDW and covalent radii) comes from RadiiLists. Nothing is appended until
+// the whole file has parsed, so a malformed file throws without changing
+// the System. XYZ files contribute their first frame, PDB files their
+// first MODEL plus all CONECT bonds between atoms that were read. Of atoms
+// with alternate locations, only the first location identifier in the
+// file (usually A) is read. CONECT bonds are rotatable unless they close a
+// ring or end at an atom with no other bond.
+class StructureLoader {
+public:
+
+    static StructureInfo loadXyz(
+        const std::string& path,
+        System& system,
+        const StructureLoadOptions& options = StructureLoadOptions());
+
+    static StructureInfo loadPdb(
+        const std::string& path,
+        System& system,
+        const StructureLoadOptions& options = StructureLoadOptions());
+
+    // Chooses the reader from the extension (.xyz, or .pdb / .ent).
+    static StructureInfo load(
+        const std::string& path,
+        System& system,
+        const StructureLoadOptions& options = StructureLoadOptions());
+
+    // Loads the file into a fresh System repeats times and reports the best run.
+    static LoaderBenchmark benchmark(const std::string& path, int repeats = 5);
+};
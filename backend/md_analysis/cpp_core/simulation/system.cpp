@@ -0,0 +1,553 @@
+#include "system.h"
+#include "bonded_forces.h"
+#include "generalized_born.h"
+#include "nonbonded_forces.h"
+#include "radii_lists.h"
+#include "scratch_arena.h"
+#include "spatial_sort.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <type_traits>
+
+int System::addAtom(
+    const std::string& element,
+    const std::array<double, 3>& position,
+    double mass,
+    double charge,
+    double sigma,
+    double epsilon) {
+
+    if (mass <= 0.0) {
+        throw std::runtime_error("Atom mass must be positive");
+    }
+
+    particles.element.push_back(element);
+    particles.x.push_back(position[0]);
+    particles.y.push_back(position[1]);
+    particles.z.push_back(position[2]);
+    particles.vx.push_back(0.0);
+    particles.vy.push_back(0.0);
+    particles.vz.push_back(0.0);
+    particles.fx.push_back(0.0);
+    particles.fy.push_back(0.0);
+    particles.fz.push_back(0.0);
+    particles.mass.push_back(mass);
+    particles.charge.push_back(charge);
+    particles.sigma.push_back(sigma);
+    particles.epsilon.push_back(epsilon);
+    particles.type.push_back(0);
+    particles.originalId.push_back(static_cast<int>(currentIndex.size()));
+    currentIndex.push_back(static_cast<int>(particles.size()) - 1);
+
+    topologyChanged = true;
+    parametersChanged = true;
+    forcesCurrent = false;
+    ++stateVersion;
+
+    return static_cast<int>(particles.size()) - 1;
+}
+
+void System::reserve(size_t numAtoms, size_t numBonds) {
+    particles.element.reserve(numAtoms);
+    for (auto* values : {&particles.x, &particles.y, &particles.z,
+                         &particles.vx, &particles.vy, &particles.vz,
+                         &particles.fx, &particles.fy, &particles.fz,
+                         &particles.mass, &particles.charge,
+                         &particles.sigma, &particles.epsilon}) {
+        values->reserve(numAtoms);
+    }
+    particles.type.reserve(numAtoms);
+    particles.originalId.reserve(numAtoms);
+    currentIndex.reserve(numAtoms);
+    mutableTopology().bonds.reserve(numBonds);
+}
+
+static void checkAtomId(int atomId, size_t numAtoms) {
+    if (atomId < 0 || static_cast<size_t>(atomId) >= numAtoms) {
+        throw std::runtime_error("Atom index " + std::to_string(atomId) + " out of range");
+    }
+}
+
+int System::toCurrentIndex(int originalId) const {
+    checkAtomId(originalId, currentIndex.size());
+    return currentIndex[originalId];
+}
+
+TopologyData& System::mutableTopology() {
+    if (topology.use_count() > 1) {
+        topology = std::make_shared<TopologyData>(*topology);
+    }
+    return *topology;
+}
+
+ExclusionLists& System::mutableExclusions() {
+    if (exclusions.use_count() > 1) {
+        exclusions = std::make_shared<ExclusionLists>(*exclusions);
+    }
+    return *exclusions;
+}
+
+void System::addBond(const BondData& bond) {
+    BondData mapped = bond;
+    mapped.atom1Id = toCurrentIndex(bond.atom1Id);
+    mapped.atom2Id = toCurrentIndex(bond.atom2Id);
+    mutableTopology().bonds.push_back(mapped);
+    topologyChanged = true;
+    forcesCurrent = false;
+    ++stateVersion;
+}
+
+void System::addAngle(const AngleData& angle) {
+    AngleData mapped = angle;
+    mapped.atom1Id = toCurrentIndex(angle.atom1Id);
+    mapped.atom2Id = toCurrentIndex(angle.atom2Id);
+    mapped.atom3Id = toCurrentIndex(angle.atom3Id);
+    mutableTopology().angles.push_back(mapped);
+    forcesCurrent = false;
+    ++stateVersion;
+}
+
+void System::addDihedral(const DihedralData& dihedral) {
+    DihedralData mapped = dihedral;
+    mapped.atom1Id = toCurrentIndex(dihedral.atom1Id);
+    mapped.atom2Id = toCurrentIndex(dihedral.atom2Id);
+    mapped.atom3Id = toCurrentIndex(dihedral.atom3Id);
+    mapped.atom4Id = toCurrentIndex(dihedral.atom4Id);
+    mutableTopology().dihedrals.push_back(mapped);
+    forcesCurrent = false;
+    ++stateVersion;
+}
+
+void System::addImproper(const ImproperData& improper) {
+    ImproperData mapped = improper;
+    mapped.atom1Id = toCurrentIndex(improper.atom1Id);
+    mapped.atom2Id = toCurrentIndex(improper.atom2Id);
+    mapped.atom3Id = toCurrentIndex(improper.atom3Id);
+    mapped.atom4Id = toCurrentIndex(improper.atom4Id);
+    mutableTopology().impropers.push_back(mapped);
+    forcesCurrent = false;
+    ++stateVersion;
+}
+
+void System::setBoxLength(const std::array<double, 3>& boxLength) {
+    this->boxLength = boxLength;
+    neighborList.invalidate();
+    forcesCurrent = false;
+    ++stateVersion;
+}
+
+void System::setCutoff(double cutoffDistance, double skinDistance) {
+    neighborList.setCutoff(cutoffDistance, skinDistance);
+    forcesCurrent = false;
+    ++stateVersion;
+}
+
+void System::setDielectricConstant(double dielectricConstant) {
+    this->dielectricConstant = dielectricConstant;
+    forcesCurrent = false;
+    ++stateVersion;
+}
+
+void System::setAtomType(int atomId, int type) {
+    if (type < 0) {
+        throw std::runtime_error("Atom type must not be negative");
+    }
+    particles.type[toCurrentIndex(atomId)] = type;
+    parametersChanged = true;
+    forcesCurrent = false;
+    ++stateVersion;
+}
+
+int System::getAtomType(int atomId) const {
+    return particles.type[toCurrentIndex(atomId)];
+}
+
+void System::setPairTables(std::shared_ptr<const PairTableSet> tables) {
+    pairTables = std::move(tables);
+    parametersChanged = true;
+    forcesCurrent = false;
+    ++stateVersion;
+}
+
+void System::useTabulatedLennardJones(
+    CutoffModifier modifier,
+    double switchDistance,
+    int numIntervals) {
+
+    const size_t numAtoms = particles.size();
+    std::vector<std::array<double, 2>> typeParameters;
+    for (size_t i = 0; i < numAtoms; ++i) {
+        std::array<double, 2> parameters = {particles.sigma[i], particles.epsilon[i]};
+        auto found = std::find(typeParameters.begin(), typeParameters.end(), parameters);
+        particles.type[i] = static_cast<int>(found - typeParameters.begin());
+        if (found == typeParameters.end()) {
+            typeParameters.push_back(parameters);
+        }
+    }
+
+    const int numTypes = static_cast<int>(typeParameters.size());
+    const double cutoff = neighborList.getCutoffDistance();
+    auto tables = std::make_shared<PairTableSet>(numTypes);
+    for (int a = 0; a < numTypes; ++a) {
+        for (int b = a; b < numTypes; ++b) {
+            double sigma = 0.5 * (typeParameters[a][0] + typeParameters[b][0]);
+            double epsilon = std::sqrt(typeParameters[a][1] * typeParameters[b][1]);
+            if (epsilon == 0.0) continue;
+            tables->setTable(a, b, PairTable::lennardJones(
+                sigma, epsilon, cutoff, modifier, switchDistance, numIntervals));
+        }
+    }
+    tables->setCoulombTable(PairTable::coulomb(cutoff, modifier, switchDistance, numIntervals));
+
+    setPairTables(std::move(tables));
+}
+
+void System::clearPairTables() {
+    setPairTables(nullptr);
+}
+
+void System::setImplicitSolvent(const GeneralizedBornOptions& options) {
+    if (options.solventDielectric <= 0.0 || options.radiusOffset < 0.0) {
+        throw std::runtime_error("Invalid implicit solvent options");
+    }
+    implicitSolvent = true;
+    solventOptions = options;
+    parametersChanged = true;
+    forcesCurrent = false;
+    ++stateVersion;
+}
+
+void System::clearImplicitSolvent() {
+    implicitSolvent = false;
+    bornRadii.clear();
+    forcesCurrent = false;
+    ++stateVersion;
+}
+
+void System::markPositionsChanged() {
+    forcesCurrent = false;
+    ++stateVersion;
+}
+
+template <typename T>
+static void permuteInPlace(std::vector<T>& values, const std::vector<int>& order, ScratchArena& arena) {
+    const size_t count = values.size();
+    T* previous = arena.allocate<T>(count);
+    std::copy(values.begin(), values.end(), previous);
+    for (size_t k = 0; k < count; ++k) {
+        values[k] = previous[order[k]];
+    }
+}
+
+void System::sortAtoms() {
+    const size_t numAtoms = particles.size();
+    if (numAtoms < 2) return;
+
+    ScratchArena& arena = ScratchArena::forThread();
+    arena.reset();
+
+    PositionArrays<double> positions = {
+        particles.x.data(), particles.y.data(), particles.z.data(), numAtoms};
+    SpatialSort::computeMortonOrder(positions, boxLength, sortOrder);
+
+    for (auto* values : {&particles.x, &particles.y, &particles.z,
+                         &particles.vx, &particles.vy, &particles.vz,
+                         &particles.fx, &particles.fy, &particles.fz,
+                         &particles.mass, &particles.charge,
+                         &particles.sigma, &particles.epsilon}) {
+        permuteInPlace(*values, sortOrder, arena);
+    }
+    permuteInPlace(particles.type, sortOrder, arena);
+    permuteInPlace(particles.originalId, sortOrder, arena);
+    if (bornRadii.size() == numAtoms) {
+        permuteInPlace(bornRadii, sortOrder, arena);
+    }
+
+    // Strings are moved along the cycles of the permutation so sorting
+    // does not reallocate the element names.
+    bool* placed = arena.allocateZeroed<bool>(numAtoms);
+    for (size_t start = 0; start < numAtoms; ++start) {
+        if (placed[start]) continue;
+        std::string carried = std::move(particles.element[start]);
+        size_t k = start;
+        while (true) {
+            placed[k] = true;
+            size_t source = static_cast<size_t>(sortOrder[k]);
+            if (source == start) {
+                particles.element[k] = std::move(carried);
+                break;
+            }
+            particles.element[k] = std::move(particles.element[source]);
+            k = source;
+        }
+    }
+
+    int* newIndex = arena.allocate<int>(numAtoms);
+    for (size_t k = 0; k < numAtoms; ++k) {
+        newIndex[sortOrder[k]] = static_cast<int>(k);
+        currentIndex[particles.originalId[k]] = static_cast<int>(k);
+    }
+
+    TopologyData& terms = mutableTopology();
+    for (auto& bond : terms.bonds) {
+        bond.atom1Id = newIndex[bond.atom1Id];
+        bond.atom2Id = newIndex[bond.atom2Id];
+    }
+    for (auto& angle : terms.angles) {
+        angle.atom1Id = newIndex[angle.atom1Id];
+        angle.atom2Id = newIndex[angle.atom2Id];
+        angle.atom3Id = newIndex[angle.atom3Id];
+    }
+    for (auto& dihedral : terms.dihedrals) {
+        dihedral.atom1Id = newIndex[dihedral.atom1Id];
+        dihedral.atom2Id = newIndex[dihedral.atom2Id];
+        dihedral.atom3Id = newIndex[dihedral.atom3Id];
+        dihedral.atom4Id = newIndex[dihedral.atom4Id];
+    }
+    for (auto& improper : terms.impropers) {
+        improper.atom1Id = newIndex[improper.atom1Id];
+        improper.atom2Id = newIndex[improper.atom2Id];
+        improper.atom3Id = newIndex[improper.atom3Id];
+        improper.atom4Id = newIndex[improper.atom4Id];
+    }
+
+    if (!topologyChanged) {
+        ExclusionLists& lists = mutableExclusions();
+        int* previousOffsets = arena.allocate<int>(numAtoms + 1);
+        int* previousIndices = arena.allocate<int>(lists.indices.size());
+        std::copy(lists.offsets.begin(), lists.offsets.end(), previousOffsets);
+        std::copy(lists.indices.begin(), lists.indices.end(), previousIndices);
+
+        int next = 0;
+        for (size_t k = 0; k < numAtoms; ++k) {
+            int old = sortOrder[k];
+            int first = next;
+            lists.offsets[k] = first;
+            for (int e = previousOffsets[old]; e < previousOffsets[old + 1]; ++e) {
+                lists.indices[next++] = newIndex[previousIndices[e]];
+            }
+            std::sort(lists.indices.begin() + first, lists.indices.begin() + next);
+        }
+        lists.offsets[numAtoms] = next;
+    }
+
+    parametersChanged = true;
+    neighborList.invalidate();
+    ++stateVersion;
+}
+
+void System::prepareParameters() {
+    if (!parametersChanged) return;
+
+    const size_t numAtoms = particles.size();
+    halfSigma.resize(numAtoms);
+    sqrtEpsilon.resize(numAtoms);
+    for (size_t i = 0; i < numAtoms; ++i) {
+        halfSigma[i] = 0.5 * particles.sigma[i];
+        sqrtEpsilon[i] = std::sqrt(particles.epsilon[i]);
+    }
+
+    singleCharge.assign(particles.charge.begin(), particles.charge.end());
+    singleHalfSigma.assign(halfSigma.begin(), halfSigma.end());
+    singleSqrtEpsilon.assign(sqrtEpsilon.begin(), sqrtEpsilon.end());
+
+    if (implicitSolvent) {
+        solventRadius.resize(numAtoms);
+        solventScaledRadius.resize(numAtoms);
+        for (size_t i = 0; i < numAtoms; ++i) {
+            solventRadius[i] = RadiiLists::getVdwRadius(particles.element[i]);
+            if (solventRadius[i] <= solventOptions.radiusOffset) {
+                throw std::runtime_error("VDW radius of " + particles.element[i] +
+                                         " does not exceed the Born radius offset");
+            }
+            solventScaledRadius[i] = RadiiLists::getGbScreeningScale(particles.element[i]) *
+                                     (solventRadius[i] - solventOptions.radiusOffset);
+        }
+    }
+
+    if (pairTables) {
+        for (size_t i = 0; i < numAtoms; ++i) {
+            if (particles.type[i] >= pairTables->getNumTypes()) {
+                throw std::runtime_error("Atom type " + std::to_string(particles.type[i]) +
+                                         " has no entry in the pair tables");
+            }
+        }
+    }
+
+    parametersChanged = false;
+}
+
+void System::prepareNeighborList() {
+    const int numAtoms = static_cast<int>(particles.size());
+
+    if (topologyChanged) {
+        ExclusionTable table = Exclusions::buildExclusionTable(numAtoms, topology->bonds);
+        exclusions = std::make_shared<ExclusionLists>(Exclusions::buildExclusionLists(numAtoms, table));
+        neighborList.invalidate();
+        topologyChanged = false;
+    }
+
+    PositionArrays<double> positions = {
+        particles.x.data(), particles.y.data(), particles.z.data(), particles.size()};
+    if (neighborList.needsRebuild(positions)) {
+        neighborList.build(positions, boxLength, *exclusions);
+    }
+}
+
+template <PrecisionMode Mode>
+SystemEnergy System::computeForcesImpl() {
+    using Real = typename PrecisionTraits<Mode>::Real;
+    using Accum = typename PrecisionTraits<Mode>::Accum;
+
+    const size_t numAtoms = particles.size();
+    ScratchArena& arena = ScratchArena::forThread();
+    arena.reset();
+
+    prepareParameters();
+    prepareNeighborList();
+
+    PositionArrays<Real> positions;
+    PairParameterArrays<Real> parameters;
+
+    if constexpr (std::is_same<Real, double>::value) {
+        positions = {particles.x.data(), particles.y.data(), particles.z.data(), numAtoms};
+        parameters = {particles.charge.data(), halfSigma.data(), sqrtEpsilon.data()};
+    } else {
+        float* singleX = arena.allocate<float>(numAtoms);
+        float* singleY = arena.allocate<float>(numAtoms);
+        float* singleZ = arena.allocate<float>(numAtoms);
+        for (size_t i = 0; i < numAtoms; ++i) {
+            singleX[i] = static_cast<float>(particles.x[i]);
+            singleY[i] = static_cast<float>(particles.y[i]);
+            singleZ[i] = static_cast<float>(particles.z[i]);
+        }
+        positions = {singleX, singleY, singleZ, numAtoms};
+        parameters = {singleCharge.data(), singleHalfSigma.data(), singleSqrtEpsilon.data()};
+    }
+
+    ForceArrays<Accum> forces;
+
+    if constexpr (std::is_same<Accum, double>::value) {
+        particles.fx.assign(numAtoms, 0.0);
+        particles.fy.assign(numAtoms, 0.0);
+        particles.fz.assign(numAtoms, 0.0);
+        forces = {particles.fx.data(), particles.fy.data(), particles.fz.data()};
+    } else {
+        forces = {arena.allocateZeroed<Accum>(numAtoms),
+                  arena.allocateZeroed<Accum>(numAtoms),
+                  arena.allocateZeroed<Accum>(numAtoms)};
+    }
+
+    SystemEnergy energy = {};
+    energy.bonded = BasicBondedForces<Real, Accum>::computeBondedForces(
+        topology->bonds, topology->angles, topology->dihedrals, topology->impropers,
+        positions, forces);
+    if (pairTables) {
+        if (pairTables->getCutoffDistance() > neighborList.getCutoffDistance()) {
+            throw std::runtime_error("Pair table cutoff exceeds the neighbor list cutoff");
+        }
+        energy.nonbonded = BasicNonbondedForces<Real, Accum>::computeTabulatedPairForces(
+            neighborList.getData(), positions, parameters.charge, particles.type.data(),
+            *pairTables, forces, boxLength, dielectricConstant);
+    } else {
+        energy.nonbonded = BasicNonbondedForces<Real, Accum>::computePairForces(
+            neighborList.getData(), positions, parameters, forces,
+            boxLength, neighborList.getCutoffDistance(), dielectricConstant);
+    }
+
+    if (implicitSolvent) {
+        GeneralizedBornParameters solventParameters = {
+            particles.charge.data(), solventRadius.data(), solventScaledRadius.data()};
+        energy.solvation = BasicGeneralizedBornForces<Real, Accum>::computeForces(
+            neighborList.getData(), *exclusions, positions, solventParameters, forces,
+            boxLength, neighborList.getCutoffDistance(), dielectricConstant,
+            solventOptions, bornRadii);
+    }
+
+    if constexpr (!std::is_same<Accum, double>::value) {
+        particles.fx.assign(forces.x, forces.x + numAtoms);
+        particles.fy.assign(forces.y, forces.y + numAtoms);
+        particles.fz.assign(forces.z, forces.z + numAtoms);
+    }
+
+    energy.potential = energy.bonded.total + energy.nonbonded.total + energy.solvation;
+    energy.kinetic = computeKineticEnergy();
+    energy.total = energy.potential + energy.kinetic;
+
+    return energy;
+}
+
+SystemEnergy System::computeForces() {
+    return computeForces(precisionMode);
+}
+
+SystemEnergy System::computeForces(PrecisionMode mode) {
+    switch (mode) {
+        case PrecisionMode::Single:
+            lastEnergy = computeForcesImpl<PrecisionMode::Single>();
+            break;
+        case PrecisionMode::Mixed:
+            lastEnergy = computeForcesImpl<PrecisionMode::Mixed>();
+            break;
+        default:
+            lastEnergy = computeForcesImpl<PrecisionMode::Double>();
+            break;
+    }
+
+    forcesCurrent = true;
+    return lastEnergy;
+}
+
+SystemEnergy System::step(int numSteps, double timestep) {
+    const size_t numAtoms = particles.size();
+
+    if (!forcesCurrent) {
+        computeForces();
+    }
+
+    for (int n = 0; n < numSteps; ++n) {
+        if (sortInterval > 0 && stepCount > 0 && stepCount % sortInterval == 0) {
+            sortAtoms();
+        }
+
+        for (size_t i = 0; i < numAtoms; ++i) {
+            double halfKick = 0.5 * timestep * ACCELERATION_CONVERSION / particles.mass[i];
+            particles.vx[i] += halfKick * particles.fx[i];
+            particles.vy[i] += halfKick * particles.fy[i];
+            particles.vz[i] += halfKick * particles.fz[i];
+            particles.x[i] += timestep * particles.vx[i];
+            particles.y[i] += timestep * particles.vy[i];
+            particles.z[i] += timestep * particles.vz[i];
+        }
+
+        computeForces();
+
+        for (size_t i = 0; i < numAtoms; ++i) {
+            double halfKick = 0.5 * timestep * ACCELERATION_CONVERSION / particles.mass[i];
+            particles.vx[i] += halfKick * particles.fx[i];
+            particles.vy[i] += halfKick * particles.fy[i];
+            particles.vz[i] += halfKick * particles.fz[i];
+        }
+
+        ++stepCount;
+    }
+
+    ++stateVersion;
+
+    lastEnergy.kinetic = computeKineticEnergy();
+    lastEnergy.total = lastEnergy.potential + lastEnergy.kinetic;
+
+    return lastEnergy;
+}
+
+double System::computeKineticEnergy() const {
+    double kinetic = 0.0;
+    for (size_t i = 0; i < particles.size(); ++i) {
+        double v2 = particles.vx[i] * particles.vx[i] +
+                    particles.vy[i] * particles.vy[i] +
+                    particles.vz[i] * particles.vz[i];
+        kinetic += 0.5 * particles.mass[i] * v2;
+    }
+    return kinetic / ACCELERATION_CONVERSION;
+}
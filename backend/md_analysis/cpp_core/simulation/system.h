@@ -0,0 +1,224 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+#include "bonded_interactions.h"
+#include "nonbond_interactions.h"
+#include "generate_exclusions.h"
+#include "generalized_born.h"
+#include "neighbor_list.h"
+#include "pair_table.h"
+#include "precision.h"
+
+// kcal/(mol*Angstrom*amu) to Angstrom/fs^2
+constexpr double ACCELERATION_CONVERSION = 4.184e-4;
+
+// kcal/(mol*K)
+constexpr double BOLTZMANN_CONSTANT = 0.0019872041;
+
+struct ParticleArrays {
+    std::vector<std::string> element;
+    std::vector<double> x, y, z;
+    std::vector<double> vx, vy, vz;
+    std::vector<double> fx, fy, fz;
+    std::vector<double> mass;
+    std::vector<double> charge;
+    std::vector<double> sigma;
+    std::vector<double> epsilon;
+    std::vector<int> type;
+    std::vector<int> originalId;
+
+    size_t size() const { return x.size(); }
+};
+
+struct TopologyData {
+    std::vector<BondData> bonds;
+    std::vector<AngleData> angles;
+    std::vector<DihedralData> dihedrals;
+    std::vector<ImproperData> impropers;
+};
+
+struct SystemEnergy {
+    BondedInteractions::BondedEnergy bonded;
+    NonbondedInteractions::NonbondedEnergy nonbonded;
+    // Generalized Born polarization energy; zero without implicit solvent.
+    double solvation;
+    double kinetic;
+    double potential;
+    double total;
+};
+
+// Atom ids passed into System (bonds, angles, dihedrals, impropers)
+// are insertion
+// order ids. Internally the particle arrays may be permuted along a
+// space-filling curve by sortAtoms(); particles.originalId and
+// getCurrentIndex() translate between the two orders.
+//
+// Positions, velocities and forces are always kept in double; the
+// precision mode only selects the type the force kernels read positions
+// in and sum forces and energies in. Per-evaluation float mirrors are
+// drawn from the calling thread's ScratchArena, which is reset at the
+// start of every force evaluation.
+//
+// When pair tables are set, the nonbonded term is evaluated from them,
+// indexed by the per-atom type, instead of closed-form LJ and Coulomb.
+//
+// With implicit solvent, a Generalized Born term is added on top of the
+// nonbonded one, with the dielectric constant as the solute dielectric
+// and intrinsic radii taken from RadiiLists::VDW_RADII by element.
+class System {
+public:
+
+    int addAtom(
+        const std::string& element,
+        const std::array<double, 3>& position,
+        double mass,
+        double charge,
+        double sigma,
+        double epsilon);
+
+    // Reserves particle and bond storage ahead of adding many atoms.
+    void reserve(size_t numAtoms, size_t numBonds = 0);
+
+    void addBond(const BondData& bond);
+
+    void addAngle(const AngleData& angle);
+
+    void addDihedral(const DihedralData& dihedral);
+
+    void addImproper(const ImproperData& improper);
+
+    void setBoxLength(const std::array<double, 3>& boxLength);
+
+    const std::array<double, 3>& getBoxLength() const { return boxLength; }
+
+    void setCutoff(double cutoffDistance, double skinDistance = 2.0);
+
+    void setDielectricConstant(double dielectricConstant);
+
+    double getDielectricConstant() const { return dielectricConstant; }
+
+    void setPrecisionMode(PrecisionMode mode) { precisionMode = mode; }
+
+    PrecisionMode getPrecisionMode() const { return precisionMode; }
+
+    void setAtomType(int atomId, int type);
+
+    int getAtomType(int atomId) const;
+
+    void setPairTables(std::shared_ptr<const PairTableSet> tables);
+
+    // Assigns one type per distinct (sigma, epsilon) and tabulates the
+    // Lorentz-Berthelot LJ of every type pair plus Coulomb at the current cutoff.
+    void useTabulatedLennardJones(
+        CutoffModifier modifier,
+        double switchDistance = 0.0,
+        int numIntervals = 4096);
+
+    void clearPairTables();
+
+    const PairTableSet* getPairTables() const { return pairTables.get(); }
+
+    void setImplicitSolvent(const GeneralizedBornOptions& options);
+
+    void clearImplicitSolvent();
+
+    bool hasImplicitSolvent() const { return implicitSolvent; }
+
+    const GeneralizedBornOptions& getImplicitSolventOptions() const { return solventOptions; }
+
+    // Effective Born radii of the last force evaluation, in current atom order.
+    const std::vector<double>& getBornRadii() const { return bornRadii; }
+
+    SystemEnergy computeForces();
+
+    SystemEnergy computeForces(PrecisionMode mode);
+
+    SystemEnergy step(int numSteps, double timestep);
+
+    double computeKineticEnergy() const;
+
+    size_t getNumAtoms() const { return particles.size(); }
+
+    ParticleArrays& getParticles() { return particles; }
+
+    const ParticleArrays& getParticles() const { return particles; }
+
+    const TopologyData& getTopology() const { return *topology; }
+
+    // True when both systems read the same topology and exclusion storage,
+    // as copies of one System do until either modifies or reorders it.
+    bool sharesTopologyWith(const System& other) const {
+        return topology == other.topology && exclusions == other.exclusions;
+    }
+
+    const NeighborList& getNeighborList() const { return neighborList; }
+
+    void markPositionsChanged();
+
+    void sortAtoms();
+
+    void setSortInterval(int numSteps) { sortInterval = numSteps; }
+
+    int getSortInterval() const { return sortInterval; }
+
+    int getCurrentIndex(int originalId) const { return currentIndex[originalId]; }
+
+    long long getStepCount() const { return stepCount; }
+
+    // Increases whenever positions, topology, atom order or box change,
+    // so callers caching energies can tell when they are stale.
+    unsigned long long getStateVersion() const { return stateVersion; }
+
+private:
+
+    friend class Checkpoint;
+
+    template <PrecisionMode Mode>
+    SystemEnergy computeForcesImpl();
+
+    int toCurrentIndex(int originalId) const;
+
+    TopologyData& mutableTopology();
+
+    ExclusionLists& mutableExclusions();
+
+    void prepareParameters();
+
+    void prepareNeighborList();
+
+    ParticleArrays particles;
+    // Copy-on-write: copies of a System share these read-only until one
+    // of them needs to change its own.
+    std::shared_ptr<TopologyData> topology = std::make_shared<TopologyData>();
+    std::shared_ptr<ExclusionLists> exclusions = std::make_shared<ExclusionLists>();
+    NeighborList neighborList;
+    std::array<double, 3> boxLength = {0.0, 0.0, 0.0};
+    double dielectricConstant = 1.0;
+    PrecisionMode precisionMode = PrecisionMode::Double;
+    std::shared_ptr<const PairTableSet> pairTables;
+    bool implicitSolvent = false;
+    GeneralizedBornOptions solventOptions;
+    bool topologyChanged = true;
+    bool parametersChanged = true;
+    bool forcesCurrent = false;
+    SystemEnergy lastEnergy = {};
+    int sortInterval = 0;
+    long long stepCount = 0;
+    unsigned long long stateVersion = 0;
+    std::vector<int> currentIndex;
+    std::vector<int> sortOrder;
+
+    std::vector<double> halfSigma;
+    std::vector<double> sqrtEpsilon;
+
+    std::vector<float> singleCharge;
+    std::vector<float> singleHalfSigma;
+    std::vector<float> singleSqrtEpsilon;
+
+    std::vector<double> solventRadius;
+    std::vector<double> solventScaledRadius;
+    std::vector<double> bornRadii;
+};
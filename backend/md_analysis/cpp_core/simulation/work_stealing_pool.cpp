@@ -0,0 +1,123 @@
+#include "work_stealing_pool.h"
+#include <algorithm>
+
+WorkStealingPool::WorkStealingPool(int numThreads) {
+    int count = numThreads > 0 ? numThreads : static_cast<int>(std::thread::hardware_concurrency());
+    count = std::max(1, count);
+
+    for (int i = 0; i < count; ++i) {
+        queues.push_back(std::make_unique<TaskQueue>());
+    }
+    for (int i = 1; i < count; ++i) {
+        threads.emplace_back(&WorkStealingPool::workerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::run(int count, const std::function<void(int)>& task) {
+    if (count <= 0) {
+        return;
+    }
+
+    currentTask = &task;
+    firstError = nullptr;
+    remaining.store(count);
+
+    const int numQueues = getNumThreads();
+    for (int q = 0; q < numQueues; ++q) {
+        std::lock_guard<std::mutex> lock(queues[q]->mutex);
+        queues[q]->tasks.clear();
+        queues[q]->head = 0;
+        for (int i = q; i < count; i += numQueues) {
+            queues[q]->tasks.push_back(i);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++generation;
+    }
+    wakeCondition.notify_all();
+
+    drain(0);
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        doneCondition.wait(lock, [this] { return remaining.load() == 0; });
+    }
+    currentTask = nullptr;
+
+    if (firstError) {
+        std::exception_ptr error = firstError;
+        firstError = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void WorkStealingPool::workerLoop(int worker) {
+    unsigned long long seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeCondition.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+        }
+        drain(worker);
+    }
+}
+
+void WorkStealingPool::drain(int worker) {
+    int task;
+    while (popOwn(worker, task) || steal(worker, task)) {
+        try {
+            (*currentTask)(task);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!firstError) {
+                firstError = std::current_exception();
+            }
+        }
+
+        if (remaining.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> lock(mutex);
+            doneCondition.notify_all();
+        }
+    }
+}
+
+bool WorkStealingPool::popOwn(int worker, int& task) {
+    TaskQueue& queue = *queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.size() == queue.head) {
+        return false;
+    }
+    task = queue.tasks.back();
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::steal(int worker, int& task) {
+    const int numQueues = getNumThreads();
+    for (int k = 1; k < numQueues; ++k) {
+        TaskQueue& victim = *queues[(worker + k) % numQueues];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tasks.size() > victim.head) {
+            task = victim.tasks[victim.head++];
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads, each with its own task queue. A worker
+// takes tasks from the back of its own queue and, once that is empty,
+// steals from the front of the others', so uneven tasks (replicas whose
+// neighbor lists rebuild at different rates) still keep every thread busy.
+// The thread calling run() works as worker 0.
+class WorkStealingPool {
+public:
+
+    // numThreads <= 0 uses every hardware thread.
+    explicit WorkStealingPool(int numThreads = 0);
+
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Calls task(i) once for every i in [0, count) and returns when all
+    // calls have finished. The first exception thrown by a task is rethrown.
+    void run(int count, const std::function<void(int)>& task);
+
+    int getNumThreads() const { return static_cast<int>(queues.size()); }
+
+private:
+
+    // Owner pops from the back, thieves take tasks[head]. run() refills
+    // the vector in place, so repeated runs reuse its capacity.
+    struct TaskQueue {
+        std::mutex mutex;
+        std::vector<int> tasks;
+        size_t head = 0;
+    };
+
+    void workerLoop(int worker);
+
+    // Runs tasks until every queue is empty.
+    void drain(int worker);
+
+    bool popOwn(int worker, int& task);
+
+    bool steal(int worker, int& task);
+
+    std::vector<std::unique_ptr<TaskQueue>> queues;
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    std::condition_variable wakeCondition;
+    std::condition_variable doneCondition;
+    unsigned long long generation = 0;
+    bool stopping = false;
+
+    const std::function<void(int)>* currentTask = nullptr;
+    std::atomic<int> remaining{0};
+    std::exception_ptr firstError;
+};
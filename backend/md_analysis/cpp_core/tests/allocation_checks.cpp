@@ -0,0 +1,87 @@
+// Counts every global operator new during steady-state System::step calls
+// and exits non-zero if any of the test systems allocates after warm-up:
+// plain LJ in every precision mode, implicit solvent on a thread pool, and
+// bonded chains with pair tables, periodic sorting and implicit solvent.
+
+#include "test_systems.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+namespace {
+
+std::atomic<unsigned long long> numAllocations{0};
+
+void* allocate(std::size_t size) {
+    numAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size > 0 ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+}  // namespace
+
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
+
+namespace {
+
+// Runs numWarmup steps, then counts the heap allocations of numSteps more.
+bool checkSteadyState(const char* name, System& system, int numWarmup, int numSteps, double timestep) {
+    system.step(numWarmup, timestep);
+
+    const int buildsBefore = system.getNeighborList().getBuildCount();
+    numAllocations.store(0);
+    system.step(numSteps, timestep);
+    const unsigned long long count = numAllocations.load();
+    const int rebuilds = system.getNeighborList().getBuildCount() - buildsBefore;
+
+    std::printf("%-14s %5d steps  %d neighbor list rebuilds  %llu heap allocations  %s\n",
+                name, numSteps, rebuilds, count, count == 0 ? "ok" : "FAILED");
+    return count == 0;
+}
+
+}  // namespace
+
+int main() {
+    const struct {
+        const char* name;
+        PrecisionMode mode;
+    } modes[] = {{"double", PrecisionMode::Double}, {"single", PrecisionMode::Single}, {"mixed", PrecisionMode::Mixed}};
+
+    // Building the system allocates, which shows the counting operator new is in use.
+    numAllocations.store(0);
+    System lattice = TestSystems::argon();
+    if (numAllocations.load() == 0) {
+        std::printf("operator new is not being counted\n");
+        return 1;
+    }
+
+    int numFailures = 0;
+    for (const auto& entry : modes) {
+        System system = lattice;
+        system.setPrecisionMode(entry.mode);
+        if (!checkSteadyState(entry.name, system, 200, 2000, 1.0)) ++numFailures;
+    }
+
+    System solvated = TestSystems::solvatedLattice(4);
+    if (!checkSteadyState("gb", solvated, 50, 200, 1.0)) ++numFailures;
+
+    // Bonded terms, pair tables, periodic re-sorting and implicit solvent
+    // together; the counted steps include two sorts.
+    const System chains = TestSystems::solvatedChains(4);
+    for (const auto& entry : modes) {
+        System system = chains;
+        system.setPrecisionMode(entry.mode);
+        const std::string name = std::string("chains_") + entry.name;
+        if (!checkSteadyState(name.c_str(), system, 60, 100, 0.5)) ++numFailures;
+    }
+    return numFailures > 0 ? 1 : 0;
+}
@@ -0,0 +1,339 @@
+// Checks TrajectoryAnalysis: RMSD against an explicit Kabsch superposition,
+// g(r) of an ideal gas, and results that do not depend on the number of
+// threads.
+
+#include "trajectory_analysis.h"
+#include "test_systems.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+int numFailures = 0;
+
+void check(const std::string& name, bool passed) {
+    std::printf("%-52s %s\n", name.c_str(), passed ? "ok" : "FAILED");
+    if (!passed) ++numFailures;
+}
+
+using Matrix = std::array<std::array<double, 3>, 3>;
+
+// Eigenvalues (descending) and eigenvectors (columns) of a symmetric 3x3
+// matrix by cyclic Jacobi rotations.
+std::pair<std::array<double, 3>, Matrix> symmetricEigen(Matrix a) {
+    Matrix v = {{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}};
+    for (int sweep = 0; sweep < 50; ++sweep) {
+        const double offDiagonal = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+        if (offDiagonal < 1e-30) break;
+        for (int p = 0; p < 2; ++p) {
+            for (int q = p + 1; q < 3; ++q) {
+                if (a[p][q] == 0.0) continue;
+                const double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+                const double t = (theta >= 0 ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt(theta * theta + 1.0));
+                const double c = 1.0 / std::sqrt(t * t + 1.0);
+                const double s = t * c;
+                for (int k = 0; k < 3; ++k) {
+                    const double akp = a[k][p];
+                    const double akq = a[k][q];
+                    a[k][p] = c * akp - s * akq;
+                    a[k][q] = s * akp + c * akq;
+                }
+                for (int k = 0; k < 3; ++k) {
+                    const double apk = a[p][k];
+                    const double aqk = a[q][k];
+                    a[p][k] = c * apk - s * aqk;
+                    a[q][k] = s * apk + c * aqk;
+                }
+                for (int k = 0; k < 3; ++k) {
+                    const double vkp = v[k][p];
+                    const double vkq = v[k][q];
+                    v[k][p] = c * vkp - s * vkq;
+                    v[k][q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+
+    std::array<int, 3> order = {0, 1, 2};
+    std::sort(order.begin(), order.end(), [&](int i, int j) { return a[i][i] > a[j][j]; });
+    std::array<double, 3> values;
+    Matrix vectors;
+    for (int i = 0; i < 3; ++i) {
+        values[i] = a[order[i]][order[i]];
+        for (int k = 0; k < 3; ++k) vectors[k][i] = v[k][order[i]];
+    }
+    return {values, vectors};
+}
+
+std::array<double, 3> cross(const std::array<double, 3>& a, const std::array<double, 3>& b) {
+    return {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+}
+
+// Kabsch: with H = sum w a b^T over centered frame a and reference b, and
+// H = U S V^T where U and V are proper rotations and the last singular
+// value carries the sign of det H, R = V U^T is the best proper rotation.
+// The frame is rotated explicitly and the RMSD summed directly.
+double kabschRmsd(const double* frame, const double* reference, const std::vector<double>& weights, int numAtoms) {
+    std::array<double, 3> frameCenter = {0, 0, 0};
+    std::array<double, 3> referenceCenter = {0, 0, 0};
+    double totalWeight = 0.0;
+    for (int i = 0; i < numAtoms; ++i) {
+        for (int k = 0; k < 3; ++k) {
+            frameCenter[k] += weights[i] * frame[3 * i + k];
+            referenceCenter[k] += weights[i] * reference[3 * i + k];
+        }
+        totalWeight += weights[i];
+    }
+    for (int k = 0; k < 3; ++k) {
+        frameCenter[k] /= totalWeight;
+        referenceCenter[k] /= totalWeight;
+    }
+
+    Matrix h = {};
+    for (int i = 0; i < numAtoms; ++i) {
+        for (int p = 0; p < 3; ++p) {
+            for (int q = 0; q < 3; ++q) {
+                h[p][q] += weights[i] * (frame[3 * i + p] - frameCenter[p]) * (reference[3 * i + q] - referenceCenter[q]);
+            }
+        }
+    }
+
+    Matrix hth = {};
+    for (int p = 0; p < 3; ++p) {
+        for (int q = 0; q < 3; ++q) {
+            for (int k = 0; k < 3; ++k) hth[p][q] += h[k][p] * h[k][q];
+        }
+    }
+    auto [values, v] = symmetricEigen(hth);
+    Matrix vColumns;
+    for (int i = 0; i < 2; ++i) vColumns[i] = {v[0][i], v[1][i], v[2][i]};
+    vColumns[2] = cross(vColumns[0], vColumns[1]);
+
+    Matrix uColumns;
+    for (int i = 0; i < 2; ++i) {
+        const double sigma = std::sqrt(values[i]);
+        for (int k = 0; k < 3; ++k) {
+            uColumns[i][k] = (h[k][0] * vColumns[i][0] + h[k][1] * vColumns[i][1] + h[k][2] * vColumns[i][2]) / sigma;
+        }
+    }
+    uColumns[2] = cross(uColumns[0], uColumns[1]);
+
+    Matrix rotation = {};
+    for (int p = 0; p < 3; ++p) {
+        for (int q = 0; q < 3; ++q) {
+            for (int i = 0; i < 3; ++i) rotation[p][q] += vColumns[i][p] * uColumns[i][q];
+        }
+    }
+
+    double sum = 0.0;
+    for (int i = 0; i < numAtoms; ++i) {
+        for (int p = 0; p < 3; ++p) {
+            double rotated = 0.0;
+            for (int q = 0; q < 3; ++q) rotated += rotation[p][q] * (frame[3 * i + q] - frameCenter[q]);
+            const double d = rotated - (reference[3 * i + p] - referenceCenter[p]);
+            sum += weights[i] * d * d;
+        }
+    }
+    return std::sqrt(sum / totalWeight);
+}
+
+Matrix randomRotation(std::mt19937& rng) {
+    std::normal_distribution<double> normal(0.0, 1.0);
+    double w = normal(rng), x = normal(rng), y = normal(rng), z = normal(rng);
+    const double norm = std::sqrt(w * w + x * x + y * y + z * z);
+    w /= norm;
+    x /= norm;
+    y /= norm;
+    z /= norm;
+    return {{{1 - 2 * (y * y + z * z), 2 * (x * y - w * z), 2 * (x * z + w * y)},
+             {2 * (x * y + w * z), 1 - 2 * (x * x + z * z), 2 * (y * z - w * x)},
+             {2 * (x * z - w * y), 2 * (y * z + w * x), 1 - 2 * (x * x + y * y)}}};
+}
+
+// Appends rotation * reference + shift, with optional Gaussian noise.
+void appendMovedFrame(std::vector<double>& frames, const std::vector<double>& reference,
+                      const Matrix& rotation, const std::array<double, 3>& shift, double noise, std::mt19937& rng) {
+    std::normal_distribution<double> jitter(0.0, noise > 0.0 ? noise : 1.0);
+    for (size_t i = 0; i < reference.size() / 3; ++i) {
+        for (int p = 0; p < 3; ++p) {
+            double value = shift[p];
+            for (int q = 0; q < 3; ++q) value += rotation[p][q] * reference[3 * i + q];
+            frames.push_back(noise > 0.0 ? value + jitter(rng) : value);
+        }
+    }
+}
+
+std::vector<double> randomMolecule(int numAtoms, std::mt19937& rng) {
+    std::uniform_real_distribution<double> uniform(-8.0, 8.0);
+    std::vector<double> coordinates(3 * numAtoms);
+    for (double& value : coordinates) value = uniform(rng);
+    return coordinates;
+}
+
+void checkRigidMotion() {
+    std::mt19937 rng(3);
+    const int numAtoms = 60;
+    const std::vector<double> reference = randomMolecule(numAtoms, rng);
+    std::uniform_real_distribution<double> shift(-20.0, 20.0);
+
+    std::vector<double> frames;
+    for (int f = 0; f < 20; ++f) {
+        appendMovedFrame(frames, reference, randomRotation(rng), {shift(rng), shift(rng), shift(rng)}, 0.0, rng);
+    }
+    const FrameBlock block{frames.data(), 20, numAtoms};
+    const std::vector<double> values = TrajectoryAnalysis::rmsd(block, reference.data(), {}, 1);
+
+    check("rmsd: rotated and translated frames give 0",
+          *std::max_element(values.begin(), values.end()) < 1e-6);
+}
+
+void checkAgainstKabsch() {
+    std::mt19937 rng(4);
+    const int numAtoms = 80;
+    const std::vector<double> reference = randomMolecule(numAtoms, rng);
+    std::uniform_real_distribution<double> shift(-20.0, 20.0);
+    const int numFrames = 30;
+
+    std::vector<double> frames;
+    for (int f = 0; f < numFrames; ++f) {
+        Matrix rotation = randomRotation(rng);
+        // Every fifth frame is mirrored, so no proper rotation fits it well.
+        if (f % 5 == 4) {
+            for (auto& row : rotation) row[0] = -row[0];
+        }
+        appendMovedFrame(frames, reference, rotation, {shift(rng), shift(rng), shift(rng)}, 0.1 + 0.1 * f, rng);
+    }
+    const FrameBlock block{frames.data(), numFrames, numAtoms};
+
+    std::vector<double> weights(numAtoms);
+    std::uniform_real_distribution<double> weight(0.5, 16.0);
+    for (int i = 0; i < numAtoms; ++i) weights[i] = i % 7 == 0 ? 0.0 : weight(rng);
+    const std::vector<double> unitWeights(numAtoms, 1.0);
+
+    const std::vector<double> plain = TrajectoryAnalysis::rmsd(block, reference.data(), {}, 1);
+    const std::vector<double> weighted = TrajectoryAnalysis::rmsd(block, reference.data(), weights, 1);
+    double plainError = 0.0;
+    double weightedError = 0.0;
+    for (int f = 0; f < numFrames; ++f) {
+        plainError = std::max(plainError,
+                              std::abs(plain[f] - kabschRmsd(block.frame(f), reference.data(), unitWeights, numAtoms)));
+        weightedError = std::max(weightedError,
+                                 std::abs(weighted[f] - kabschRmsd(block.frame(f), reference.data(), weights, numAtoms)));
+    }
+    check("rmsd: matches Kabsch, including mirrored frames", plainError < 1e-8);
+    check("rmsd: weighted matches weighted Kabsch", weightedError < 1e-8);
+}
+
+void checkIdealGas() {
+    std::mt19937 rng(5);
+    const int numAtoms = 2000;
+    const int numFrames = 20;
+    const std::array<double, 3> box = {30.0, 32.0, 34.0};
+    std::vector<double> frames;
+    for (int f = 0; f < numFrames; ++f) {
+        for (int i = 0; i < numAtoms; ++i) {
+            for (int k = 0; k < 3; ++k) {
+                frames.push_back(std::uniform_real_distribution<double>(0.0, box[k])(rng));
+            }
+        }
+    }
+    const FrameBlock block{frames.data(), numFrames, numAtoms};
+    const RadialDistribution rdf = TrajectoryAnalysis::radialDistribution(block, box, 14.0, 28, {}, {}, 1);
+
+    // Each bin past 2 A holds over 5 x 10^4 pairs, so noise stays well below 1%.
+    double worst = 0.0;
+    double sum = 0.0;
+    int count = 0;
+    for (size_t b = 0; b < rdf.g.size(); ++b) {
+        if (rdf.radius[b] < 2.0) continue;
+        worst = std::max(worst, std::abs(rdf.g[b] - 1.0));
+        sum += rdf.g[b];
+        ++count;
+    }
+    check("g(r): uniform gas stays near 1 in every bin", worst < 0.05);
+    check("g(r): uniform gas averages to 1", std::abs(sum / count - 1.0) < 0.01);
+}
+
+bool sameEnergies(const std::vector<SystemEnergy>& a, const std::vector<SystemEnergy>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t f = 0; f < a.size(); ++f) {
+        if (a[f].potential != b[f].potential || a[f].total != b[f].total || a[f].solvation != b[f].solvation) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void checkThreadIndependence() {
+    std::mt19937 rng(6);
+
+    // Frames and velocities of the chain in insertion order.
+    System system = TestSystems::chain();
+    const int numAtoms = static_cast<int>(system.getNumAtoms());
+    const int numFrames = 41;
+    std::vector<double> positions;
+    std::vector<double> velocities;
+    std::vector<double> masses;
+    for (int i = 0; i < numAtoms; ++i) masses.push_back(system.getParticles().mass[system.getCurrentIndex(i)]);
+    for (int f = 0; f < numFrames; ++f) {
+        system.step(20, 0.25);
+        const ParticleArrays& particles = system.getParticles();
+        for (int i = 0; i < numAtoms; ++i) {
+            const int index = system.getCurrentIndex(i);
+            positions.insert(positions.end(), {particles.x[index], particles.y[index], particles.z[index]});
+            velocities.insert(velocities.end(), {particles.vx[index], particles.vy[index], particles.vz[index]});
+        }
+    }
+    const FrameBlock positionBlock{positions.data(), numFrames, numAtoms};
+    const FrameBlock velocityBlock{velocities.data(), numFrames, numAtoms};
+    const System reference = TestSystems::chain();
+
+    check("threads: rmsd",
+          TrajectoryAnalysis::rmsd(positionBlock, positions.data(), masses, 1) ==
+          TrajectoryAnalysis::rmsd(positionBlock, positions.data(), masses, 4));
+    check("threads: kinetic energy and temperature",
+          TrajectoryAnalysis::kineticEnergy(velocityBlock, masses, 1) ==
+          TrajectoryAnalysis::kineticEnergy(velocityBlock, masses, 4) &&
+          TrajectoryAnalysis::temperature(velocityBlock, masses, 0, 1) ==
+          TrajectoryAnalysis::temperature(velocityBlock, masses, 0, 4));
+    check("threads: frame energies",
+          sameEnergies(TrajectoryAnalysis::frameEnergies(reference, positionBlock, 1),
+                       TrajectoryAnalysis::frameEnergies(reference, positionBlock, 4)));
+
+    // g(r) over a gas with more frames than threads, so the chunks are uneven.
+    const int gasAtoms = 500;
+    const int gasFrames = 11;
+    std::vector<double> gas(3 * gasAtoms * gasFrames);
+    std::uniform_real_distribution<double> uniform(0.0, 20.0);
+    for (double& value : gas) value = uniform(rng);
+    const FrameBlock gasBlock{gas.data(), gasFrames, gasAtoms};
+    std::vector<int> selection;
+    for (int i = 0; i < gasAtoms; i += 3) selection.push_back(i);
+    const RadialDistribution serial =
+        TrajectoryAnalysis::radialDistribution(gasBlock, {20.0, 20.0, 20.0}, 9.0, 90, selection, {}, 1);
+    const RadialDistribution parallel =
+        TrajectoryAnalysis::radialDistribution(gasBlock, {20.0, 20.0, 20.0}, 9.0, 90, selection, {}, 4);
+    check("threads: g(r)", serial.radius == parallel.radius && serial.g == parallel.g);
+}
+
+}  // namespace
+
+int main() {
+    checkRigidMotion();
+    checkAgainstKabsch();
+    checkIdealGas();
+    checkThreadIndependence();
+
+    if (numFailures > 0) {
+        std::printf("%d check(s) failed\n", numFailures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,132 @@
+// Checks that a run continued from a checkpoint is bitwise identical to the
+// uninterrupted run, and that damaged checkpoint files are refused.
+
+#include "checkpoint.h"
+#include "test_systems.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+int numFailures = 0;
+
+void check(const std::string& name, bool passed) {
+    std::printf("%-60s %s\n", name.c_str(), passed ? "ok" : "FAILED");
+    if (!passed) ++numFailures;
+}
+
+std::string tempPath(const std::string& name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+// Positions and velocities in storage order, with the original ids so that
+// a difference in sort order also shows up.
+struct State {
+    std::vector<double> x, y, z, vx, vy, vz;
+    std::vector<int> originalId;
+
+    explicit State(const System& system) {
+        const ParticleArrays& particles = system.getParticles();
+        x = particles.x;
+        y = particles.y;
+        z = particles.z;
+        vx = particles.vx;
+        vy = particles.vy;
+        vz = particles.vz;
+        originalId = particles.originalId;
+    }
+
+    bool operator==(const State& other) const {
+        return x == other.x && y == other.y && z == other.z &&
+               vx == other.vx && vy == other.vy && vz == other.vz && originalId == other.originalId;
+    }
+};
+
+// Runs numBefore steps, saves, runs numAfter more; then loads the file and
+// runs the same numAfter steps from it.
+void checkContinuation(const std::string& name, System system, int numBefore, int numAfter, double timestep) {
+    const std::string path = tempPath("checkpoint_checks.chk");
+    system.step(numBefore, timestep);
+    Checkpoint::save(system, path);
+    const double uninterruptedEnergy = system.step(numAfter, timestep).total;
+    const State uninterrupted(system);
+
+    System restored = Checkpoint::load(path);
+    const double restoredEnergy = restored.step(numAfter, timestep).total;
+    std::filesystem::remove(path);
+
+    check(name + ": continued run is bitwise identical",
+          State(restored) == uninterrupted && restoredEnergy == uninterruptedEnergy &&
+          restored.getStepCount() == system.getStepCount());
+}
+
+bool loadThrows(const std::string& path) {
+    try {
+        Checkpoint::load(path);
+    } catch (const std::runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+// Writes bytes to a file of its own and checks that loading it throws.
+bool rejected(const std::string& name, const std::vector<char>& bytes) {
+    const std::string path = tempPath(name);
+    std::ofstream(path, std::ios::binary).write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    const bool threw = loadThrows(path);
+    std::filesystem::remove(path);
+    return threw;
+}
+
+void checkDamagedFiles() {
+    const std::string path = tempPath("checkpoint_checks_good.chk");
+    System system = TestSystems::argon();
+    system.step(10, 1.0);
+    Checkpoint::save(system, path);
+    std::ifstream file(path, std::ios::binary);
+    const std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+    std::filesystem::remove(path);
+
+    check("intact file loads", !rejected("checkpoint_checks_intact.chk", bytes));
+    check("missing file is refused", loadThrows(tempPath("checkpoint_checks_missing.chk")));
+    check("empty file is refused", rejected("checkpoint_checks_empty.chk", {}));
+
+    const std::vector<char> header(bytes.begin(), bytes.begin() + 32);
+    check("truncated header is refused", rejected("checkpoint_checks_header.chk", header));
+    const std::vector<char> half(bytes.begin(), bytes.begin() + bytes.size() / 2);
+    check("file cut in half is refused", rejected("checkpoint_checks_half.chk", half));
+    const std::vector<char> shortByOne(bytes.begin(), bytes.end() - 1);
+    check("file short by one byte is refused", rejected("checkpoint_checks_short.chk", shortByOne));
+
+    // One byte in the header, the section table and a payload near the end.
+    bool allFlipsRefused = true;
+    for (size_t offset : {size_t(8), size_t(70), bytes.size() - 100}) {
+        std::vector<char> corrupted = bytes;
+        corrupted[offset] ^= 0x10;
+        allFlipsRefused = allFlipsRefused && rejected("checkpoint_checks_flipped.chk", corrupted);
+    }
+    check("corrupted bytes are refused", allFlipsRefused);
+}
+
+}  // namespace
+
+int main() {
+    checkContinuation("argon", TestSystems::argon(), 300, 300, 1.0);
+    // The Morton sort every 50 steps happens on both sides of the checkpoint.
+    checkContinuation("sorted bonded chains", TestSystems::solvatedChains(2), 60, 60, 0.5);
+    checkContinuation("implicit solvent lattice", TestSystems::solvatedLattice(2), 20, 30, 1.0);
+    checkDamagedFiles();
+
+    if (numFailures > 0) {
+        std::printf("%d check(s) failed\n", numFailures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,92 @@
+// Runs every ForceVerification check on fixed molecules with fixed seeds
+// and exits non-zero if any of them fails.
+
+#include "force_verification.h"
+#include "test_systems.h"
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+namespace {
+
+int numFailures = 0;
+
+void report(const std::string& system, const VerificationResult& result) {
+    std::printf("%-14s %-24s checks %7d  error %.3e  tolerance %.1e  %s\n",
+                system.c_str(), result.name.c_str(), result.numChecks, result.maxError,
+                result.tolerance, result.passed ? "ok" : "FAILED");
+    if (!result.passed) ++numFailures;
+}
+
+void report(const std::string& system, const EnergyDriftResult& result) {
+    std::printf("%-14s %-24s steps %8d  deviation %.3e  drift %.3e  tolerance %.1e  %s\n",
+                system.c_str(), "energy_drift", result.numSteps, result.maxDeviation,
+                result.driftPerAtomPerPs, result.tolerance, result.passed ? "ok" : "FAILED");
+    if (!result.passed) ++numFailures;
+}
+
+void checkSystem(const std::string& name, const System& system) {
+    report(name, ForceVerification::checkSystemForces(system, PrecisionMode::Double, 1e-5, 0, 1e-6));
+    report(name, ForceVerification::checkSystemForces(system, PrecisionMode::Mixed, 1e-4, 0, 1e-3));
+    for (const auto& result : ForceVerification::checkConservation(system, 1e-9)) {
+        report(name, result);
+    }
+}
+
+// Runs the drift check in double and in mixed precision, and checks that
+// mixed precision adds no more than maxDifference of drift of its own.
+void checkMixedDrift(const std::string& name, const System& system, int numSteps, double timestep,
+                     int sampleInterval, double maxDifference) {
+    System reference = system;
+    reference.setPrecisionMode(PrecisionMode::Double);
+    System mixed = system;
+    mixed.setPrecisionMode(PrecisionMode::Mixed);
+
+    EnergyDriftResult referenceDrift = ForceVerification::checkEnergyDrift(reference, numSteps, timestep, sampleInterval);
+    EnergyDriftResult mixedDrift = ForceVerification::checkEnergyDrift(mixed, numSteps, timestep, sampleInterval);
+    report(name, referenceDrift);
+    report(name + "_mixed", mixedDrift);
+
+    const double difference = std::abs(mixedDrift.driftPerAtomPerPs - referenceDrift.driftPerAtomPerPs);
+    report(name, VerificationResult{"mixed_drift_difference", 1, difference, maxDifference,
+                                    difference <= maxDifference});
+}
+
+}  // namespace
+
+int main() {
+    for (const auto& result : ForceVerification::checkInteractionGradients(200, 1)) {
+        report("kernels", result);
+    }
+
+    report("tables", ForceVerification::checkPairTable(PairTable::lennardJones(3.4, 0.238, 10.0), 1000, 1));
+    report("tables", ForceVerification::checkPairTable(
+        PairTable::lennardJones(3.4, 0.238, 10.0, CutoffModifier::Switch, 8.0), 1000, 2));
+    report("tables", ForceVerification::checkPairTable(
+        PairTable::lennardJones(3.4, 0.238, 10.0, CutoffModifier::ForceShift), 1000, 3));
+    report("tables", ForceVerification::checkPairTable(PairTable::coulomb(10.0, CutoffModifier::ForceShift), 1000, 4));
+
+    System vacuum = TestSystems::chain();
+    checkSystem("vacuum", vacuum);
+    checkMixedDrift("vacuum", vacuum, 20000, 0.25, 50, 1e-5);
+
+    System solvated = TestSystems::chain();
+    solvated.setImplicitSolvent(GeneralizedBornOptions());
+    checkSystem("gb", solvated);
+    report("gb", ForceVerification::checkEnergyDrift(solvated, 20000, 0.25, 50));
+
+    System periodic = TestSystems::argon();
+    periodic.useTabulatedLennardJones(CutoffModifier::Switch, 8.0);
+    report("periodic", ForceVerification::checkSystemForces(periodic, PrecisionMode::Double, 1e-5, 24, 1e-6));
+    for (const auto& result : ForceVerification::checkConservation(periodic, 1e-9)) {
+        report("periodic", result);
+    }
+    checkMixedDrift("periodic", periodic, 2000, 1.0, 10, 1e-5);
+
+    if (numFailures > 0) {
+        std::printf("%d check(s) failed\n", numFailures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
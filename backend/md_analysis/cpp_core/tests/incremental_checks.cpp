@@ -0,0 +1,136 @@
+// Checks IncrementalEnergy against full rebuilds and checks that a
+// proposal the bonded kernels reject leaves the System untouched.
+
+#include "incremental_energy.h"
+#include "bonded_interactions.h"
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+int numFailures = 0;
+
+void check(const std::string& name, bool passed) {
+    std::printf("%-44s %s\n", name.c_str(), passed ? "ok" : "FAILED");
+    if (!passed) ++numFailures;
+}
+
+// A bent four-atom chain with bonds, two angles and a dihedral.
+System chain() {
+    const std::vector<std::array<double, 3>> positions = {
+        {0.0, 0.0, 0.0}, {1.5, 0.0, 0.0}, {2.0, 1.4, 0.0}, {3.5, 1.5, 0.4}};
+
+    System system;
+    for (const auto& position : positions) {
+        system.addAtom("C", position, 12.0, 0.1, 3.4, 0.1);
+    }
+    for (int i = 0; i + 1 < 4; ++i) {
+        system.addBond({i, i + 1, 1, 1.5, 300.0, true});
+    }
+    for (int i = 0; i + 2 < 4; ++i) {
+        system.addAngle({i, i + 1, i + 2,
+                         BondedInteractions::calculateAngle(positions[i], positions[i + 1], positions[i + 2]),
+                         50.0});
+    }
+    system.addDihedral({0, 1, 2, 3, 3, 1.4, 0.0});
+    system.setCutoff(10.0, 1.0);
+    return system;
+}
+
+std::vector<double> coordinates(System& system) {
+    const ParticleArrays& particles = system.getParticles();
+    std::vector<double> values;
+    for (size_t i = 0; i < particles.size(); ++i) {
+        values.insert(values.end(), {particles.x[i], particles.y[i], particles.z[i]});
+    }
+    return values;
+}
+
+double freshTotal(System& system) {
+    IncrementalEnergy reference(system);
+    return reference.getTotalEnergy();
+}
+
+void checkDegenerateMove() {
+    System system = chain();
+    IncrementalEnergy energy(system);
+    const double totalBefore = energy.getTotalEnergy();
+    const std::vector<double> positionsBefore = coordinates(system);
+    const unsigned long long versionBefore = system.getStateVersion();
+
+    // Atom 0 on top of atom 1 makes the 0-1-2 angle undefined.
+    const ParticleArrays& particles = system.getParticles();
+    const int middle = system.getCurrentIndex(1);
+    bool threw = false;
+    try {
+        energy.proposeAtomMove(0, {particles.x[middle], particles.y[middle], particles.z[middle]});
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+
+    check("degenerate move throws", threw);
+    check("degenerate move leaves no pending move", !energy.hasPendingMove());
+    check("degenerate move restores positions", coordinates(system) == positionsBefore);
+    check("degenerate move keeps the state version", system.getStateVersion() == versionBefore);
+    check("degenerate move keeps the cached total", energy.getTotalEnergy() == totalBefore);
+
+    // The caches must still describe the System for the next move.
+    const double delta = energy.proposeAtomMove(3, {3.6, 1.7, 0.1});
+    energy.commit();
+    const double expected = freshTotal(system);
+    check("move after a degenerate move is exact",
+          std::abs(energy.getTotalEnergy() - expected) <= 1e-9 * std::abs(expected) &&
+          std::abs(totalBefore + delta - expected) <= 1e-9 * std::abs(expected));
+}
+
+void checkRejectedMoves() {
+    System system = chain();
+    IncrementalEnergy energy(system);
+    const double totalBefore = energy.getTotalEnergy();
+    const std::vector<double> positionsBefore = coordinates(system);
+
+    energy.proposeAtomMove(2, {2.1, 1.2, 0.3});
+    energy.reject();
+    energy.proposeBondRotation(1, 0.7);
+    energy.reject();
+
+    check("rejected moves restore positions", coordinates(system) == positionsBefore);
+    check("rejected moves keep the cached total", energy.getTotalEnergy() == totalBefore);
+}
+
+void checkCommittedMoves() {
+    System system = chain();
+    IncrementalEnergy energy(system);
+    double total = energy.getTotalEnergy();
+
+    total += energy.proposeAtomMove(0, {-0.2, 0.3, 0.1});
+    energy.commit();
+    total += energy.proposeBondRotation(1, 1.1);
+    energy.commit();
+    total += energy.proposeAtomMove(3, {3.4, 1.9, -0.2});
+    energy.commit();
+
+    const double expected = freshTotal(system);
+    check("committed moves match a rebuild",
+          std::abs(energy.getTotalEnergy() - expected) <= 1e-9 * std::abs(expected) &&
+          std::abs(total - expected) <= 1e-9 * std::abs(expected));
+}
+
+}  // namespace
+
+int main() {
+    checkDegenerateMove();
+    checkRejectedMoves();
+    checkCommittedMoves();
+
+    if (numFailures > 0) {
+        std::printf("%d check(s) failed\n", numFailures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,103 @@
+// Times StructureLoader on a PDB file, by default a generated box of water
+// with CONECT records and hybrid-36 serials past 99999.
+// Usage: loader_benchmark [numAtoms | file.pdb | file.xyz] [numRepeats]
+
+#include "structure_loader.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace {
+
+// Five-column PDB serial: decimal up to 99999, then upper-case base 36
+// starting at A0000.
+std::string hybrid36(int value) {
+    if (value < 100000) {
+        return std::to_string(value);
+    }
+    const char* digits = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    int rest = value - 100000 + 10 * 36 * 36 * 36 * 36;
+    std::string text(5, '0');
+    for (int i = 4; i >= 0; --i) {
+        text[i] = digits[rest % 36];
+        rest /= 36;
+    }
+    return text;
+}
+
+// Water molecules on a cubic lattice, each with its two O-H CONECT records.
+void writeWaterBox(const std::string& path, int numAtoms) {
+    const int numMolecules = (numAtoms + 2) / 3;
+    const int perSide = static_cast<int>(std::ceil(std::cbrt(numMolecules)));
+    const double spacing = 3.1;
+
+    std::ofstream file(path);
+    char line[96];
+    std::snprintf(line, sizeof(line), "CRYST1%9.3f%9.3f%9.3f  90.00  90.00  90.00 P 1           1\n",
+                  perSide * spacing, perSide * spacing, perSide * spacing);
+    file << line;
+
+    const char* names[] = {" OW ", " HW1", " HW2"};
+    const char* elements[] = {" O", " H", " H"};
+    const double offsets[3][3] = {{0.0, 0.0, 0.0}, {0.757, 0.586, 0.0}, {-0.757, 0.586, 0.0}};
+    for (int molecule = 0; molecule < numMolecules; ++molecule) {
+        const int a = molecule % perSide;
+        const int b = molecule / perSide % perSide;
+        const int c = molecule / perSide / perSide;
+        for (int k = 0; k < 3; ++k) {
+            std::snprintf(line, sizeof(line),
+                          "HETATM%5s %4s HOH W%4d    %8.3f%8.3f%8.3f  1.00  0.00          %2s\n",
+                          hybrid36(3 * molecule + k + 1).c_str(), names[k], molecule % 10000,
+                          a * spacing + offsets[k][0], b * spacing + offsets[k][1], c * spacing + offsets[k][2],
+                          elements[k]);
+            file << line;
+        }
+    }
+    for (int molecule = 0; molecule < numMolecules; ++molecule) {
+        const std::string oxygen = hybrid36(3 * molecule + 1);
+        std::snprintf(line, sizeof(line), "CONECT%5s%5s%5s\n", oxygen.c_str(),
+                      hybrid36(3 * molecule + 2).c_str(), hybrid36(3 * molecule + 3).c_str());
+        file << line;
+    }
+    file << "END\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const std::string argument = argc > 1 ? argv[1] : "300000";
+    const int numRepeats = argc > 2 ? std::atoi(argv[2]) : 5;
+    const bool generated = argument.find_first_not_of("0123456789") == std::string::npos;
+    const int numAtoms = generated ? std::atoi(argument.c_str()) : 0;
+    if ((generated && numAtoms < 1) || numRepeats < 1) {
+        std::printf("usage: %s [numAtoms >= 1 | file.pdb | file.xyz] [numRepeats >= 1]\n", argv[0]);
+        return 1;
+    }
+
+    std::string path = argument;
+    if (generated) {
+        path = (std::filesystem::temp_directory_path() / "loader_benchmark.pdb").string();
+        writeWaterBox(path, numAtoms);
+    }
+
+    const LoaderBenchmark result = StructureLoader::benchmark(path, numRepeats);
+    if (generated) {
+        std::filesystem::remove(path);
+    }
+
+    std::printf("%s, best of %d loads\n", generated ? "generated water box" : path.c_str(), numRepeats);
+    std::printf("atoms     %10d\n", result.numAtoms);
+    std::printf("size      %10.2f MB\n", result.fileBytes / 1.0e6);
+    std::printf("time      %10.2f ms\n", result.bestSeconds * 1.0e3);
+    std::printf("rate      %10.2f M atoms/s  %.1f MB/s\n", result.atomsPerSecond / 1.0e6, result.megabytesPerSecond);
+
+    // A generated box has a whole number of molecules, all of which must load.
+    if (generated && result.numAtoms != 3 * ((numAtoms + 2) / 3)) {
+        std::printf("loaded %d atoms\n", result.numAtoms);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,195 @@
+// Checks WorkStealingPool scheduling and error handling, and that
+// ReplicaExchange gives the same results for any number of threads, keeps
+// consistent swap statistics and thermostats each replica to its
+// temperature.
+
+#include "replica_exchange.h"
+#include "test_systems.h"
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+int numFailures = 0;
+
+void check(const std::string& name, bool passed) {
+    std::printf("%-56s %s\n", name.c_str(), passed ? "ok" : "FAILED");
+    if (!passed) ++numFailures;
+}
+
+// Runs count tasks of uneven length and checks each ran exactly once.
+bool eachTaskOnce(WorkStealingPool& pool, int count) {
+    std::vector<std::atomic<int>> calls(count);
+    for (auto& value : calls) value = 0;
+    pool.run(count, [&](int i) {
+        volatile double sink = 0.0;
+        for (int k = 0; k < (i % 7) * 2000; ++k) sink = sink + k;
+        ++calls[i];
+    });
+    for (const auto& value : calls) {
+        if (value != 1) return false;
+    }
+    return true;
+}
+
+void checkPool(int numThreads) {
+    WorkStealingPool pool(numThreads);
+    const std::string name = "pool, " + std::to_string(numThreads) + " threads: ";
+
+    bool allOnce = true;
+    for (int generation = 0; generation < 300; ++generation) {
+        allOnce = allOnce && eachTaskOnce(pool, generation % 5 == 0 ? 0 : 1 + generation % 37);
+    }
+    check(name + "back-to-back runs call each task once", allOnce);
+
+    std::atomic<int> finished{0};
+    std::string message;
+    try {
+        pool.run(64, [&](int i) {
+            if (i == 17 || i == 40) throw std::runtime_error("task " + std::to_string(i));
+            ++finished;
+        });
+    } catch (const std::runtime_error& error) {
+        message = error.what();
+    }
+    check(name + "task exception reaches the caller",
+          (message == "task 17" || message == "task 40") && finished == 62);
+    check(name + "pool runs normally after an exception", eachTaskOnce(pool, 100));
+}
+
+double instantaneousTemperature(const ReplicaExchange& exchange, int replica) {
+    return 2.0 * exchange.getReplica(replica).computeKineticEnergy() /
+           (exchange.getDegreesOfFreedom() * BOLTZMANN_CONSTANT);
+}
+
+bool sameReplicas(const ReplicaExchange& a, const ReplicaExchange& b) {
+    for (int r = 0; r < a.getNumReplicas(); ++r) {
+        const ParticleArrays& pa = a.getReplica(r).getParticles();
+        const ParticleArrays& pb = b.getReplica(r).getParticles();
+        if (pa.x != pb.x || pa.y != pb.y || pa.z != pb.z || pa.vx != pb.vx || pa.vy != pb.vy || pa.vz != pb.vz) {
+            return false;
+        }
+    }
+    return a.getTemperatureIndices() == b.getTemperatureIndices() &&
+           a.getPotentialEnergies() == b.getPotentialEnergies() &&
+           a.getPairAccepts() == b.getPairAccepts() && a.getReplicaAccepts() == b.getReplicaAccepts();
+}
+
+// Attempts and acceptances must add up across pairs and replicas, with
+// alternating even and odd pairs, and the temperature indices must stay a
+// permutation.
+bool consistentCounts(const ReplicaExchange& exchange) {
+    const int numPairs = exchange.getNumReplicas() - 1;
+    long long pairAttempts = 0;
+    long long pairAccepts = 0;
+    for (int k = 0; k < numPairs; ++k) {
+        const long long expected = (exchange.getExchangeCount() + (k % 2 == 0 ? 1 : 0)) / 2;
+        if (exchange.getPairAttempts()[k] != expected) return false;
+        if (exchange.getPairAccepts()[k] > exchange.getPairAttempts()[k]) return false;
+        pairAttempts += exchange.getPairAttempts()[k];
+        pairAccepts += exchange.getPairAccepts()[k];
+    }
+
+    long long replicaAttempts = 0;
+    long long replicaAccepts = 0;
+    std::vector<int> seen(exchange.getNumReplicas(), 0);
+    for (int r = 0; r < exchange.getNumReplicas(); ++r) {
+        replicaAttempts += exchange.getReplicaAttempts()[r];
+        replicaAccepts += exchange.getReplicaAccepts()[r];
+        ++seen[exchange.getTemperatureIndices()[r]];
+    }
+    for (int count : seen) {
+        if (count != 1) return false;
+    }
+    return replicaAttempts == 2 * pairAttempts && replicaAccepts == 2 * pairAccepts;
+}
+
+void checkArgonReplicas() {
+    ReplicaExchangeOptions options;
+    options.timestep = 2.0;
+    options.exchangeInterval = 20;
+    options.thermostatTimeConstant = 50.0;
+    options.seed = 99;
+    const std::vector<double> temperatures = {60.0, 66.0, 72.0, 79.0};
+    const System argon = TestSystems::argon();
+
+    options.numThreads = 1;
+    ReplicaExchange serial(argon, temperatures, options);
+    options.numThreads = 4;
+    ReplicaExchange parallel(argon, temperatures, options);
+
+    // After burn-in, the ratio of instantaneous to target temperature of
+    // every replica after every exchange round.
+    const int numBurnIn = 10;
+    const int numExchanges = 60;
+    double ratioSum = 0.0;
+    int numSamples = 0;
+    for (int e = 0; e < numExchanges; ++e) {
+        serial.run(1);
+        parallel.run(1);
+        if (e < numBurnIn) continue;
+        for (int r = 0; r < parallel.getNumReplicas(); ++r) {
+            ratioSum += instantaneousTemperature(parallel, r) /
+                        temperatures[parallel.getTemperatureIndices()[r]];
+            ++numSamples;
+        }
+    }
+
+    long long accepts = 0;
+    for (long long value : parallel.getPairAccepts()) accepts += value;
+
+    check("argon replicas: 1 and 4 threads are bitwise identical", sameReplicas(serial, parallel));
+    check("argon replicas: swap counts are consistent", consistentCounts(parallel) && accepts > 0);
+    // With 3N - 3 = 645 degrees of freedom one sample scatters by about
+    // 6%; 200 partly correlated samples average to within about 1%.
+    const double meanRatio = ratioSum / numSamples;
+    std::printf("  mean T / target %.4f over %d samples, %lld swaps accepted\n", meanRatio, numSamples, accepts);
+    check("argon replicas: Bussi thermostat holds each temperature", std::abs(meanRatio - 1.0) < 0.04);
+}
+
+// Implicit solvent in the template runs serially inside each replica,
+// whatever thread count its options ask for.
+void checkSolvatedReplicas() {
+    System chain = TestSystems::chain();
+    GeneralizedBornOptions solvent;
+    solvent.numThreads = 4;
+    chain.setImplicitSolvent(solvent);
+
+    ReplicaExchangeOptions options;
+    options.timestep = 0.25;
+    options.exchangeInterval = 40;
+    options.seed = 7;
+    const std::vector<double> temperatures = {280.0, 300.0, 320.0};
+
+    options.numThreads = 1;
+    ReplicaExchange serial(chain, temperatures, options);
+    serial.run(12);
+    options.numThreads = 4;
+    ReplicaExchange parallel(chain, temperatures, options);
+    parallel.run(12);
+
+    check("solvated replicas: 1 and 4 threads are bitwise identical", sameReplicas(serial, parallel));
+    check("solvated replicas: swap counts are consistent", consistentCounts(parallel));
+    check("solvated replicas: solvent runs on one thread",
+          parallel.getReplica(0).getImplicitSolventOptions().numThreads == 1);
+}
+
+}  // namespace
+
+int main() {
+    checkPool(1);
+    checkPool(4);
+    checkArgonReplicas();
+    checkSolvatedReplicas();
+
+    if (numFailures > 0) {
+        std::printf("%d check(s) failed\n", numFailures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
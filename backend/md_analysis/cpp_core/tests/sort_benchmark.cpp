@@ -0,0 +1,101 @@
+// Times one force evaluation of a shuffled periodic LJ/Coulomb fluid before
+// and after System::sortAtoms(), and checks that both orders give the same
+// energy. Usage: sort_benchmark [numAtoms] [numRepeats]
+
+#include "system.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+// Atoms on a jittered cubic lattice at liquid argon density, added in a
+// random order so that neighbors in space are scattered in memory.
+System shuffledFluid(int numAtoms) {
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    const double boxLength = std::cbrt(numAtoms / 0.02);
+    const int perSide = static_cast<int>(std::ceil(std::cbrt(numAtoms)));
+    const double spacing = boxLength / perSide;
+
+    std::vector<std::array<double, 3>> positions;
+    for (int a = 0; a < perSide; ++a) {
+        for (int b = 0; b < perSide; ++b) {
+            for (int c = 0; c < perSide; ++c) {
+                if (static_cast<int>(positions.size()) == numAtoms) break;
+                positions.push_back({(a + 0.5) * spacing + 0.05 * uniform(rng),
+                                     (b + 0.5) * spacing + 0.05 * uniform(rng),
+                                     (c + 0.5) * spacing + 0.05 * uniform(rng)});
+            }
+        }
+    }
+    // order[site] is the atom placed on a lattice site, siteOf its inverse.
+    std::vector<int> order(numAtoms);
+    for (int i = 0; i < numAtoms; ++i) order[i] = i;
+    std::shuffle(order.begin(), order.end(), rng);
+    std::vector<int> siteOf(numAtoms);
+    for (int site = 0; site < numAtoms; ++site) siteOf[order[site]] = site;
+
+    System system;
+    for (int i = 0; i < numAtoms; ++i) {
+        system.addAtom("Ar", positions[siteOf[i]], 39.948, i % 2 ? 0.1 : -0.1, 3.4, 0.238);
+    }
+    // A sprinkling of bonds between neighboring sites so the topology
+    // remap is part of the sort.
+    for (int site = 0; site + 1 < numAtoms; site += 50) {
+        system.addBond({order[site], order[site + 1], 1, spacing, 10.0, true});
+    }
+    system.setBoxLength({boxLength, boxLength, boxLength});
+    system.setCutoff(9.0, 1.0);
+    return system;
+}
+
+// Mean wall time of one computeForces() call in milliseconds, after one
+// untimed call that builds the neighbor list.
+double timeForces(System& system, int numRepeats, double& energy) {
+    energy = system.computeForces().total;
+    const auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < numRepeats; ++r) {
+        system.computeForces();
+    }
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / numRepeats;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const int numAtoms = argc > 1 ? std::atoi(argv[1]) : 200000;
+    const int numRepeats = argc > 2 ? std::atoi(argv[2]) : 5;
+    if (numAtoms < 2 || numRepeats < 1) {
+        std::printf("usage: %s [numAtoms >= 2] [numRepeats >= 1]\n", argv[0]);
+        return 1;
+    }
+
+    System unsorted = shuffledFluid(numAtoms);
+    System sorted = unsorted;
+    sorted.sortAtoms();
+
+    double unsortedEnergy = 0.0;
+    double sortedEnergy = 0.0;
+    const double unsortedTime = timeForces(unsorted, numRepeats, unsortedEnergy);
+    const double sortedTime = timeForces(sorted, numRepeats, sortedEnergy);
+
+    std::printf("%d atoms, mean of %d force evaluations\n", numAtoms, numRepeats);
+    std::printf("unsorted  %10.2f ms  energy %.6f\n", unsortedTime, unsortedEnergy);
+    std::printf("sorted    %10.2f ms  energy %.6f\n", sortedTime, sortedEnergy);
+    std::printf("speedup   %10.2fx\n", unsortedTime / sortedTime);
+
+    // Sorting only reorders the sums, so the energies agree to rounding.
+    const double difference = std::abs(sortedEnergy - unsortedEnergy);
+    if (difference > 1e-8 * std::max(1.0, std::abs(unsortedEnergy))) {
+        std::printf("energy changed by %.3e after sorting\n", difference);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,282 @@
+// Loads the PDB and XYZ fixtures in tests/data and checks atoms, elements,
+// bonds and their rotatability, and that malformed files change nothing. Rotatable CONECT bonds are also compared
+// with brute-force bond removal on random graphs.
+// Usage: structure_checks <data directory>
+
+#include "structure_loader.h"
+#include "radii_lists.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+int numFailures = 0;
+std::string dataDirectory;
+
+void check(const std::string& name, bool passed) {
+    std::printf("%-52s %s\n", name.c_str(), passed ? "ok" : "FAILED");
+    if (!passed) ++numFailures;
+}
+
+std::string dataFile(const std::string& name) {
+    return dataDirectory + "/" + name;
+}
+
+// Rotatability of each bond, keyed by its atoms in increasing order.
+std::map<std::pair<int, int>, bool> bondMap(const System& system) {
+    std::map<std::pair<int, int>, bool> bonds;
+    for (const auto& bond : system.getTopology().bonds) {
+        bonds[{std::min(bond.atom1Id, bond.atom2Id), std::max(bond.atom1Id, bond.atom2Id)}] = bond.isRotatable;
+    }
+    return bonds;
+}
+
+bool near(double a, double b) {
+    return std::abs(a - b) < 1e-9;
+}
+
+void checkAltLoc() {
+    System system;
+    StructureInfo info = StructureLoader::loadPdb(dataFile("altloc.pdb"), system);
+    const ParticleArrays& particles = system.getParticles();
+
+    check("altloc: blank and first location kept", info.numAtoms == 5 && system.getNumAtoms() == 5);
+    check("altloc: CB and OG from location A",
+          system.getNumAtoms() == 5 && near(particles.y[2], 1.420) && near(particles.y[3], 1.450));
+    // Bonds to the skipped B atoms are dropped with them.
+    const auto bonds = bondMap(system);
+    const std::map<std::pair<int, int>, bool> expected = {
+        {{0, 1}, false}, {{1, 2}, true}, {{1, 4}, false}, {{2, 3}, false}};
+    check("altloc: bonds among kept atoms", info.numBonds == 4 && bonds == expected);
+}
+
+void checkElements() {
+    System system;
+    StructureLoader::loadPdb(dataFile("elements.pdb"), system);
+    const ParticleArrays& particles = system.getParticles();
+    const std::vector<std::string> expected = {"C", "H", "H", "H", "H", "Ca", "Cl", "Fe"};
+
+    check("elements: atom count", system.getNumAtoms() == expected.size());
+    if (system.getNumAtoms() != expected.size()) return;
+    check("elements: ' CA ' is carbon, 'CA  ' calcium",
+          particles.element[0] == "C" && particles.element[5] == "Ca");
+    check("elements: ' HG ' and 'HG21' are hydrogen",
+          particles.element[1] == "H" && particles.element[2] == "H");
+    check("elements: '1HB ' and 'HE2 ' are hydrogen",
+          particles.element[3] == "H" && particles.element[4] == "H");
+    check("elements: 'CL1 ' is chlorine", particles.element[6] == "Cl");
+    check("elements: columns 77-80 give Fe 2+", particles.element[7] == "Fe" && near(particles.charge[7], 2.0));
+}
+
+void checkHybrid36() {
+    System system;
+    StructureInfo info = StructureLoader::loadPdb(dataFile("hybrid36.pdb"), system);
+    const auto bonds = bondMap(system);
+
+    check("hybrid-36: atoms past 99999 are read", info.numAtoms == 5);
+    // 99998-99999-A0000-A0001-a0000, each bond listed from both ends.
+    const std::map<std::pair<int, int>, bool> expected = {
+        {{0, 1}, false}, {{1, 2}, true}, {{2, 3}, true}, {{3, 4}, false}};
+    check("hybrid-36: CONECT serials resolve, duplicates merge", info.numBonds == 4 && bonds == expected);
+}
+
+void checkRings() {
+    System system;
+    StructureInfo info = StructureLoader::loadPdb(dataFile("rings.pdb"), system);
+    const auto bonds = bondMap(system);
+
+    const std::map<std::pair<int, int>, bool> expected = {
+        {{0, 1}, false}, {{0, 2}, false}, {{1, 2}, false},
+        {{0, 3}, true},
+        {{3, 4}, false}, {{3, 5}, false}, {{3, 6}, false}};
+    check("rings: ring and terminal bonds are rigid", info.numBonds == 7 && bonds == expected);
+    check("rings: CRYST1 box", info.boxLength == std::array<double, 3>{30.0, 40.0, 50.0});
+
+    double length = 0.0;
+    for (const auto& bond : system.getTopology().bonds) {
+        if (std::min(bond.atom1Id, bond.atom2Id) == 0 && std::max(bond.atom1Id, bond.atom2Id) == 3) {
+            length = bond.equilibriumLength;
+        }
+    }
+    check("rings: equilibrium length from covalent radii", near(length, 2 * RadiiLists::getCovalentRadius("C")));
+}
+
+void checkXyz() {
+    System system;
+    StructureInfo info = StructureLoader::loadXyz(dataFile("water.xyz"), system);
+    const ParticleArrays& particles = system.getParticles();
+
+    check("xyz: first frame only", info.numAtoms == 3 && system.getNumAtoms() == 3);
+    if (system.getNumAtoms() != 3) return;
+    check("xyz: elements, lowercase included",
+          particles.element[0] == "O" && particles.element[1] == "H" && particles.element[2] == "H");
+    check("xyz: coordinates", near(particles.z[0], 0.1173) && near(particles.y[2], -0.7572));
+}
+
+void checkAppend() {
+    System system;
+    StructureLoader::load(dataFile("water.xyz"), system);
+    StructureInfo info = StructureLoader::load(dataFile("rings.pdb"), system);
+
+    bool shifted = true;
+    for (const auto& bond : system.getTopology().bonds) {
+        shifted = shifted && std::min(bond.atom1Id, bond.atom2Id) >= 3;
+    }
+    check("append: second file starts after the first",
+          info.firstAtom == 3 && system.getNumAtoms() == 10 && shifted);
+}
+
+// Loads a file into a System that already holds the ring fixture and
+// checks that the load throws and leaves atoms and bonds as they were.
+bool rejectedWithoutChange(const std::string& name, const std::string& text) {
+    const std::string path = (std::filesystem::temp_directory_path() / name).string();
+    std::ofstream(path) << text;
+
+    System system;
+    StructureLoader::load(dataFile("rings.pdb"), system);
+    const size_t numAtoms = system.getNumAtoms();
+    const size_t numBonds = system.getTopology().bonds.size();
+    const ParticleArrays& particles = system.getParticles();
+
+    bool threw = false;
+    try {
+        StructureLoader::load(path, system);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    std::filesystem::remove(path);
+
+    return threw && system.getNumAtoms() == numAtoms && system.getTopology().bonds.size() == numBonds &&
+           particles.x.size() == numAtoms && particles.element.size() == numAtoms;
+}
+
+void checkMalformed() {
+    check("malformed xyz: bad coordinate",
+          rejectedWithoutChange("structure_checks_bad.xyz", "3\n\nO 0 0 0\nH 1 0 0\nH 0 one 0\n"));
+    check("malformed xyz: too few atoms",
+          rejectedWithoutChange("structure_checks_short.xyz", "3\n\nO 0 0 0\nH 1 0 0\n"));
+    const std::string good =
+        "ATOM      1  N   GLY A   1       0.000   0.000   0.000  1.00  0.00           N\n"
+        "ATOM      2  CA  GLY A   1       1.458   0.000   0.000  1.00  0.00           C\n";
+    check("malformed pdb: bad coordinate",
+          rejectedWithoutChange("structure_checks_bad.pdb",
+                                good + "ATOM      3  C   GLY A   1       2.009  -0.8x0   1.180  1.00  0.00           C\n"));
+    check("malformed pdb: bad CONECT serial",
+          rejectedWithoutChange("structure_checks_conect.pdb", good + "CONECT    1   x2\n"));
+    check("malformed pdb: duplicate serial after all atoms",
+          rejectedWithoutChange("structure_checks_duplicate.pdb",
+                                good + "ATOM      2  C   GLY A   1       2.009  -0.800   1.180  1.00  0.00           C\n"
+                                       "CONECT    1    2\n"));
+}
+
+// Bonds that no cycle passes through and whose atoms both have other bonds,
+// found by removing each bond and searching for another path.
+std::vector<bool> bruteForceRotatable(int numAtoms, const std::vector<std::pair<int, int>>& bonds) {
+    std::vector<std::vector<std::pair<int, int>>> neighbors(numAtoms);
+    for (size_t b = 0; b < bonds.size(); ++b) {
+        neighbors[bonds[b].first].push_back({bonds[b].second, static_cast<int>(b)});
+        neighbors[bonds[b].second].push_back({bonds[b].first, static_cast<int>(b)});
+    }
+
+    std::vector<bool> rotatable(bonds.size());
+    for (size_t b = 0; b < bonds.size(); ++b) {
+        std::vector<bool> seen(numAtoms, false);
+        std::vector<int> queue = {bonds[b].first};
+        seen[bonds[b].first] = true;
+        for (size_t head = 0; head < queue.size(); ++head) {
+            for (const auto& [neighbor, bond] : neighbors[queue[head]]) {
+                if (bond == static_cast<int>(b) || seen[neighbor]) continue;
+                seen[neighbor] = true;
+                queue.push_back(neighbor);
+            }
+        }
+        rotatable[b] = !seen[bonds[b].second] &&
+                       neighbors[bonds[b].first].size() > 1 && neighbors[bonds[b].second].size() > 1;
+    }
+    return rotatable;
+}
+
+void checkRandomGraphs(int numGraphs) {
+    const std::string path = (std::filesystem::temp_directory_path() / "structure_checks_random.pdb").string();
+    std::mt19937 rng(11);
+    int mismatches = 0;
+
+    for (int graph = 0; graph < numGraphs; ++graph) {
+        const int numAtoms = std::uniform_int_distribution<int>(8, 40)(rng);
+        const int numBonds = std::uniform_int_distribution<int>(numAtoms / 2, numAtoms + numAtoms / 3)(rng);
+
+        std::vector<std::pair<int, int>> bonds;
+        std::uniform_int_distribution<int> anyAtom(0, numAtoms - 1);
+        while (static_cast<int>(bonds.size()) < numBonds) {
+            int i = anyAtom(rng);
+            int j = anyAtom(rng);
+            if (i == j) continue;
+            std::pair<int, int> bond = {std::min(i, j), std::max(i, j)};
+            if (std::find(bonds.begin(), bonds.end(), bond) == bonds.end()) bonds.push_back(bond);
+        }
+
+        {
+            std::ofstream file(path);
+            char line[96];
+            for (int i = 0; i < numAtoms; ++i) {
+                std::snprintf(line, sizeof(line),
+                              "HETATM%5d  C   LIG A   1    %8.3f%8.3f%8.3f  1.00  0.00           C\n",
+                              i + 1, 1.5 * i, 0.0, 0.0);
+                file << line;
+            }
+            for (const auto& bond : bonds) {
+                std::snprintf(line, sizeof(line), "CONECT%5d%5d\n", bond.first + 1, bond.second + 1);
+                file << line;
+            }
+        }
+
+        System system;
+        StructureLoader::loadPdb(path, system);
+        const auto loaded = bondMap(system);
+        const std::vector<bool> expected = bruteForceRotatable(numAtoms, bonds);
+        for (size_t b = 0; b < bonds.size(); ++b) {
+            auto it = loaded.find(bonds[b]);
+            if (it == loaded.end() || it->second != expected[b]) ++mismatches;
+        }
+        if (loaded.size() != bonds.size()) ++mismatches;
+    }
+    std::filesystem::remove(path);
+
+    check("random graphs: rotatable bonds match brute force", mismatches == 0);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::printf("usage: %s <data directory>\n", argv[0]);
+        return 1;
+    }
+    dataDirectory = argv[1];
+
+    checkAltLoc();
+    checkElements();
+    checkHybrid36();
+    checkRings();
+    checkXyz();
+    checkAppend();
+    checkMalformed();
+    checkRandomGraphs(300);
+
+    if (numFailures > 0) {
+        std::printf("%d check(s) failed\n", numFailures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <array>
+#include <random>
+#include <vector>
+#include "bonded_interactions.h"
+#include "system.h"
+
+// Fixed-seed systems shared by the C++ checks.
+class TestSystems {
+public:
+
+    // A charged zig-zag chain of mixed elements with a hydrogen on every
+    // heavy atom, in vacuum. Bonds, angles and the improper start at their
+    // equilibrium values, so NVE stays cool enough for a 0.25 fs step to
+    // resolve it.
+    static System chain() {
+        System system;
+        std::mt19937 rng(7);
+        addChain(system, {0.0, 0.0, 0.0}, rng);
+        system.setCutoff(40.0, 2.0);
+        return system;
+    }
+
+    // A slightly disordered periodic argon lattice with small velocities,
+    // warm enough that the neighbor list is rebuilt every few hundred steps.
+    static System argon() {
+        System system;
+        std::mt19937 rng(1);
+        std::normal_distribution<double> noise(0.0, 0.01);
+        const double spacing = 3.8;
+
+        for (int a = 0; a < 6; ++a) {
+            for (int b = 0; b < 6; ++b) {
+                for (int c = 0; c < 6; ++c) {
+                    system.addAtom("Ar", {a * spacing + noise(rng), b * spacing + noise(rng), c * spacing + noise(rng)},
+                                   39.948, 0.0, 3.4, 0.238);
+                }
+            }
+        }
+        system.setBoxLength({6 * spacing, 6 * spacing, 6 * spacing});
+        system.setCutoff(10.0, 1.0);
+
+        ParticleArrays& particles = system.getParticles();
+        for (size_t i = 0; i < particles.size(); ++i) {
+            particles.vx[i] = 0.1 * noise(rng);
+            particles.vy[i] = 0.1 * noise(rng);
+            particles.vz[i] = 0.1 * noise(rng);
+        }
+        return system;
+    }
+
+    // A charged carbon/oxygen lattice of 14^3 atoms in implicit solvent,
+    // large enough that the Generalized Born sweeps run in several chunks,
+    // with velocities that rebuild the neighbor list every few dozen steps.
+    static System solvatedLattice(int numThreads) {
+        System system;
+        std::mt19937 rng(2);
+        std::normal_distribution<double> noise(0.0, 0.01);
+        const int perSide = 14;
+        const double spacing = 3.8;
+
+        for (int a = 0; a < perSide; ++a) {
+            for (int b = 0; b < perSide; ++b) {
+                for (int c = 0; c < perSide; ++c) {
+                    const bool oxygen = (a + b + c) % 2 != 0;
+                    system.addAtom(oxygen ? "O" : "C",
+                                   {a * spacing + noise(rng), b * spacing + noise(rng), c * spacing + noise(rng)},
+                                   oxygen ? 16.0 : 12.0, oxygen ? -0.2 : 0.2, 3.4, 0.1);
+                }
+            }
+        }
+        system.setBoxLength({perSide * spacing, perSide * spacing, perSide * spacing});
+        system.setCutoff(9.0, 1.0);
+
+        ParticleArrays& particles = system.getParticles();
+        std::normal_distribution<double> velocity(0.0, 0.005);
+        for (size_t i = 0; i < particles.size(); ++i) {
+            particles.vx[i] = velocity(rng);
+            particles.vy[i] = velocity(rng);
+            particles.vz[i] = velocity(rng);
+        }
+
+        GeneralizedBornOptions options;
+        options.numThreads = numThreads;
+        system.setImplicitSolvent(options);
+        return system;
+    }
+
+    // 3 x 7 x 7 copies of chain() in a periodic box: 2352 atoms with the
+    // full bonded topology, tabulated LJ switched off from 7 A, a Morton
+    // sort every 50 steps and implicit solvent.
+    static System solvatedChains(int numThreads) {
+        System system;
+        std::mt19937 rng(7);
+        const std::array<int, 3> numCells = {3, 7, 7};
+        const std::array<double, 3> cellSize = {13.0, 6.0, 6.0};
+
+        for (int a = 0; a < numCells[0]; ++a) {
+            for (int b = 0; b < numCells[1]; ++b) {
+                for (int c = 0; c < numCells[2]; ++c) {
+                    addChain(system, {a * cellSize[0], b * cellSize[1], c * cellSize[2]}, rng);
+                }
+            }
+        }
+        system.setBoxLength({numCells[0] * cellSize[0], numCells[1] * cellSize[1], numCells[2] * cellSize[2]});
+        system.setCutoff(9.0, 1.0);
+        system.useTabulatedLennardJones(CutoffModifier::Switch, 7.0);
+        system.setSortInterval(50);
+
+        GeneralizedBornOptions options;
+        options.numThreads = numThreads;
+        system.setImplicitSolvent(options);
+        return system;
+    }
+
+private:
+
+    // Appends the 16 atoms of one chain, shifted by origin.
+    static void addChain(System& system, const std::array<double, 3>& origin, std::mt19937& rng) {
+        std::normal_distribution<double> noise(0.0, 0.05);
+        const char* heavy[] = {"N", "C", "C", "O", "C", "S", "C", "N"};
+        const int first = static_cast<int>(system.getNumAtoms());
+
+        // Heavy atom i is first + 2 i, its hydrogen first + 2 i + 1.
+        std::vector<std::array<double, 3>> positions;
+        for (int i = 0; i < 8; ++i) {
+            const double side = i % 2 ? 1.0 : -1.0;
+            positions.push_back({origin[0] + 1.45 * i + noise(rng),
+                                 origin[1] + (i % 2) * 0.8 + noise(rng),
+                                 origin[2] + noise(rng)});
+            positions.push_back({origin[0] + 1.45 * i + noise(rng),
+                                 origin[1] + (i % 2) * 0.8 + side + noise(rng),
+                                 origin[2] + 0.3 + noise(rng)});
+        }
+
+        for (int i = 0; i < 8; ++i) {
+            const double side = i % 2 ? 1.0 : -1.0;
+            system.addAtom(heavy[i], positions[2 * i], 12.0, 0.4 * side, 3.2, 0.1);
+            system.addAtom("H", positions[2 * i + 1], 1.008, -0.1 * side, 1.0, 0.02);
+        }
+
+        for (int i = 0; i < 8; ++i) {
+            const int local = 2 * i;
+            const int atom = first + local;
+            system.addBond({atom, atom + 1, 1,
+                            BondedInteractions::calculateBondLength(positions[local], positions[local + 1]),
+                            400.0, false});
+            if (i >= 1) {
+                system.addBond({atom - 2, atom, 1,
+                                BondedInteractions::calculateBondLength(positions[local - 2], positions[local]),
+                                300.0, true});
+            }
+            if (i >= 2) {
+                system.addAngle({atom - 4, atom - 2, atom,
+                                 BondedInteractions::calculateAngle(
+                                     positions[local - 4], positions[local - 2], positions[local]),
+                                 50.0});
+            }
+            if (i >= 3) {
+                system.addDihedral({atom - 6, atom - 4, atom - 2, atom, 3, 1.4, 0.0});
+            }
+        }
+        // Center 2 with its chain neighbors first, which keeps both angles of
+        // the improper dihedral well away from 0 and pi.
+        system.addImproper({first + 2, first, first + 4, first + 3,
+                            BondedInteractions::calculateImproper(
+                                positions[2], positions[0], positions[4], positions[3]),
+                            20.0});
+    }
+};
@@ -0,0 +1,150 @@
+// Checks that TopologyBuilder produces the same angles, dihedrals and
+// improper candidates whether bonds are added one at a time or all at once.
+
+#include "topology_builder.h"
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+int numFailures = 0;
+
+void check(const std::string& name, bool passed) {
+    std::printf("%-48s %s\n", name.c_str(), passed ? "ok" : "FAILED");
+    if (!passed) ++numFailures;
+}
+
+// A random tree of atoms with at most four bonds each, plus ring-closing
+// bonds between atoms a few steps apart.
+std::vector<BondData> randomMolecule(int numAtoms, int numRingBonds, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::vector<int> degree(numAtoms, 0);
+    std::vector<BondData> bonds;
+    auto bonded = [&](int a, int b) {
+        for (const auto& bond : bonds) {
+            if ((bond.atom1Id == a && bond.atom2Id == b) || (bond.atom1Id == b && bond.atom2Id == a)) return true;
+        }
+        return false;
+    };
+
+    for (int atom = 1; atom < numAtoms; ++atom) {
+        int parent;
+        do {
+            parent = std::uniform_int_distribution<int>(std::max(0, atom - 6), atom - 1)(rng);
+        } while (degree[parent] >= 4);
+        bonds.push_back({parent, atom, 1, 1.5, 300.0, true});
+        ++degree[parent];
+        ++degree[atom];
+    }
+    for (int added = 0, attempts = 0; added < numRingBonds && attempts < 100 * numRingBonds; ++attempts) {
+        int a = std::uniform_int_distribution<int>(0, numAtoms - 1)(rng);
+        int b = std::min(numAtoms - 1, a + std::uniform_int_distribution<int>(2, 8)(rng));
+        if (a == b || degree[a] >= 4 || degree[b] >= 4 || bonded(a, b)) continue;
+        bonds.push_back({a, b, 1, 1.5, 300.0, true});
+        ++degree[a];
+        ++degree[b];
+        ++added;
+    }
+    std::shuffle(bonds.begin(), bonds.end(), rng);
+    return bonds;
+}
+
+// Terms in a canonical orientation and order, so that two builders agree
+// exactly when they produced the same set.
+std::vector<std::array<int, 4>> canonicalAngles(const TopologyBuilder& builder) {
+    std::vector<std::array<int, 4>> terms;
+    for (const auto& angle : builder.getAngles()) {
+        std::array<int, 4> term = {angle.atom1Id, angle.atom2Id, angle.atom3Id, -1};
+        if (term[0] > term[2]) std::swap(term[0], term[2]);
+        terms.push_back(term);
+    }
+    std::sort(terms.begin(), terms.end());
+    return terms;
+}
+
+std::vector<std::array<int, 4>> canonicalDihedrals(const TopologyBuilder& builder) {
+    std::vector<std::array<int, 4>> terms;
+    for (const auto& dihedral : builder.getDihedrals()) {
+        std::array<int, 4> term = {dihedral.atom1Id, dihedral.atom2Id, dihedral.atom3Id, dihedral.atom4Id};
+        std::array<int, 4> reversed = {term[3], term[2], term[1], term[0]};
+        terms.push_back(std::min(term, reversed));
+    }
+    std::sort(terms.begin(), terms.end());
+    return terms;
+}
+
+std::vector<std::array<int, 4>> canonicalImpropers(const TopologyBuilder& builder) {
+    std::vector<std::array<int, 4>> terms;
+    for (const auto& candidate : builder.getImproperCandidates()) {
+        std::array<int, 4> term = {candidate.centralAtomId, candidate.atom2Id, candidate.atom3Id, candidate.atom4Id};
+        std::sort(term.begin() + 1, term.end());
+        terms.push_back(term);
+    }
+    std::sort(terms.begin(), terms.end());
+    return terms;
+}
+
+bool sameNeighbors(const TopologyBuilder& a, const TopologyBuilder& b) {
+    for (int atom = 0; atom < a.getNumAtoms(); ++atom) {
+        if (a.getDegree(atom) != b.getDegree(atom)) return false;
+        std::vector<int> neighborsA(a.getNeighbors(atom), a.getNeighbors(atom) + a.getDegree(atom));
+        std::vector<int> neighborsB(b.getNeighbors(atom), b.getNeighbors(atom) + b.getDegree(atom));
+        std::sort(neighborsA.begin(), neighborsA.end());
+        std::sort(neighborsB.begin(), neighborsB.end());
+        if (neighborsA != neighborsB) return false;
+    }
+    return true;
+}
+
+void checkIncrementalMatchesBatch(int numAtoms, int numRingBonds, unsigned seed) {
+    const std::vector<BondData> bonds = randomMolecule(numAtoms, numRingBonds, seed);
+    TopologyBuilder batch(numAtoms, bonds);
+    TopologyBuilder incremental(numAtoms, {});
+    for (const auto& bond : bonds) {
+        incremental.addBond(bond);
+    }
+
+    const std::string name = std::to_string(numAtoms) + " atoms, seed " + std::to_string(seed);
+    check(name + ": neighbors", sameNeighbors(batch, incremental));
+    check(name + ": angles", canonicalAngles(batch) == canonicalAngles(incremental));
+    check(name + ": dihedrals", canonicalDihedrals(batch) == canonicalDihedrals(incremental));
+    check(name + ": improper candidates", canonicalImpropers(batch) == canonicalImpropers(incremental));
+}
+
+void checkRejectedBonds() {
+    TopologyBuilder builder(3, {{0, 1, 1, 1.5, 300.0, true}});
+    auto throws = [&](const BondData& bond) {
+        try {
+            builder.addBond(bond);
+        } catch (const std::runtime_error&) {
+            return true;
+        }
+        return false;
+    };
+    check("duplicate bond is rejected", throws({1, 0, 1, 1.5, 300.0, true}));
+    check("self bond is rejected", throws({2, 2, 1, 1.5, 300.0, true}));
+    check("out of range bond is rejected", throws({0, 3, 1, 1.5, 300.0, true}));
+    check("rejected bonds leave the builder unchanged",
+          builder.getBonds().size() == 1 && builder.getAngles().empty() && builder.getDegree(2) == 0);
+}
+
+}  // namespace
+
+int main() {
+    checkIncrementalMatchesBatch(12, 3, 1);
+    checkIncrementalMatchesBatch(200, 20, 2);
+    checkIncrementalMatchesBatch(2000, 150, 3);
+    checkRejectedBonds();
+
+    if (numFailures > 0) {
+        std::printf("%d check(s) failed\n", numFailures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
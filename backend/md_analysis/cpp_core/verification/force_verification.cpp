@@ -0,0 +1,562 @@
+#include "force_verification.h"
+#include "bonded_forces.h"
+#include "bonded_interactions.h"
+#include "nonbond_interactions.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+namespace {
+
+const double PI = 3.14159265358979323846;
+
+class ErrorTracker {
+public:
+
+    ErrorTracker(const std::string& name, double tolerance) : name(name), tolerance(tolerance) {}
+
+    void add(double analytic, double reference) {
+        double error = std::abs(analytic - reference) / std::max(std::abs(reference), 1.0);
+        // NaN compares false, so it is recorded explicitly.
+        if (!(error <= maxError)) {
+            maxError = std::isnan(error) ? error : std::max(maxError, error);
+        }
+        ++numChecks;
+    }
+
+    void addScaled(double error) {
+        if (!(error <= maxError)) {
+            maxError = std::isnan(maxError) ? maxError : error;
+        }
+        ++numChecks;
+    }
+
+    VerificationResult result() const {
+        return {name, numChecks, maxError, tolerance, maxError <= tolerance};
+    }
+
+private:
+    std::string name;
+    double tolerance;
+    int numChecks = 0;
+    double maxError = 0.0;
+};
+
+double centralDifference(double (*energy)(double, const double*), double x, const double* parameters, double h) {
+    return (energy(x + h, parameters) - energy(x - h, parameters)) / (2.0 * h);
+}
+
+double bondEnergy(double r, const double* p) {
+    return BondedInteractions::calculateBondEnergy(r, p[0], p[1]);
+}
+
+double angleEnergy(double theta, const double* p) {
+    return BondedInteractions::calculateAngleEnergy(theta, p[0], p[1]);
+}
+
+double dihedralEnergy(double phi, const double* p) {
+    return BondedInteractions::calculateDihedralEnergy(phi, p[0], p[1], p[2]);
+}
+
+double improperEnergy(double psi, const double* p) {
+    return BondedInteractions::calculateImproperEnergy(psi, p[0], p[1]);
+}
+
+// Four atoms along a chain with 1.5 A bonds and no angle closer than
+// about 18 degrees to 0 or 180, so every bonded term is well defined.
+std::array<std::array<double, 3>, 4> randomChain(std::mt19937_64& rng) {
+    std::normal_distribution<double> normal(0.0, 1.0);
+    std::array<std::array<double, 3>, 4> points;
+    std::array<double, 3> previous = {0.0, 0.0, 0.0};
+
+    while (true) {
+        points[0] = {normal(rng), normal(rng), normal(rng)};
+        bool valid = true;
+        for (int a = 1; a < 4 && valid; ++a) {
+            std::array<double, 3> u = {normal(rng), normal(rng), normal(rng)};
+            double length = std::sqrt(u[0] * u[0] + u[1] * u[1] + u[2] * u[2]);
+            for (int d = 0; d < 3; ++d) {
+                u[d] /= length;
+                points[a][d] = points[a - 1][d] + 1.5 * u[d];
+            }
+            if (a > 1) {
+                double cosine = -(u[0] * previous[0] + u[1] * previous[1] + u[2] * previous[2]);
+                valid = std::abs(cosine) < 0.95;
+            }
+            previous = u;
+        }
+        if (valid) {
+            return points;
+        }
+    }
+}
+
+template <typename Real, typename Accum>
+Accum computeTermForces(const std::vector<BondData>& terms, const PositionArrays<Real>& positions,
+                        ForceArrays<Accum>& forces) {
+    return BasicBondedForces<Real, Accum>::computeBondForces(terms, positions, forces);
+}
+
+template <typename Real, typename Accum>
+Accum computeTermForces(const std::vector<AngleData>& terms, const PositionArrays<Real>& positions,
+                        ForceArrays<Accum>& forces) {
+    return BasicBondedForces<Real, Accum>::computeAngleForces(terms, positions, forces);
+}
+
+template <typename Real, typename Accum>
+Accum computeTermForces(const std::vector<DihedralData>& terms, const PositionArrays<Real>& positions,
+                        ForceArrays<Accum>& forces) {
+    return BasicBondedForces<Real, Accum>::computeDihedralForces(terms, positions, forces);
+}
+
+template <typename Real, typename Accum>
+Accum computeTermForces(const std::vector<ImproperData>& terms, const PositionArrays<Real>& positions,
+                        ForceArrays<Accum>& forces) {
+    return BasicBondedForces<Real, Accum>::computeImproperForces(terms, positions, forces);
+}
+
+int termAtoms(const BondData& term, int* atoms) {
+    atoms[0] = term.atom1Id;
+    atoms[1] = term.atom2Id;
+    return 2;
+}
+
+int termAtoms(const AngleData& term, int* atoms) {
+    atoms[0] = term.atom1Id;
+    atoms[1] = term.atom2Id;
+    atoms[2] = term.atom3Id;
+    return 3;
+}
+
+int termAtoms(const DihedralData& term, int* atoms) {
+    atoms[0] = term.atom1Id;
+    atoms[1] = term.atom2Id;
+    atoms[2] = term.atom3Id;
+    atoms[3] = term.atom4Id;
+    return 4;
+}
+
+int termAtoms(const ImproperData& term, int* atoms) {
+    atoms[0] = term.atom1Id;
+    atoms[1] = term.atom2Id;
+    atoms[2] = term.atom3Id;
+    atoms[3] = term.atom4Id;
+    return 4;
+}
+
+struct ChainTerms {
+    std::vector<BondData> bonds;
+    std::vector<AngleData> angles;
+    std::vector<DihedralData> dihedrals;
+    std::vector<ImproperData> impropers;
+};
+
+// Kernel forces on the four chain atoms for one family of terms against
+// central differences of calculateTotalBondedEnergy with only those terms.
+template <typename Real, typename Accum, typename Term>
+void checkKernelTerm(
+    const std::vector<Term>& terms,
+    const ChainTerms& onlyThese,
+    std::array<std::array<double, 3>, 4> points,
+    ErrorTracker& tracker) {
+
+    // The reference uses the coordinates the kernel actually sees.
+    Real x[4], y[4], z[4];
+    for (int a = 0; a < 4; ++a) {
+        x[a] = static_cast<Real>(points[a][0]);
+        y[a] = static_cast<Real>(points[a][1]);
+        z[a] = static_cast<Real>(points[a][2]);
+        points[a] = {static_cast<double>(x[a]), static_cast<double>(y[a]), static_cast<double>(z[a])};
+    }
+
+    Accum fx[4] = {}, fy[4] = {}, fz[4] = {};
+    PositionArrays<Real> positions = {x, y, z, 4};
+    ForceArrays<Accum> forces = {fx, fy, fz};
+    computeTermForces(terms, positions, forces);
+
+    std::vector<std::array<double, 3>> displaced(points.begin(), points.end());
+    const double h = 1e-6;
+    for (int a = 0; a < 4; ++a) {
+        const Accum analytic[3] = {fx[a], fy[a], fz[a]};
+        for (int d = 0; d < 3; ++d) {
+            const double original = displaced[a][d];
+            displaced[a][d] = original + h;
+            double plus = BondedInteractions::calculateTotalBondedEnergy(
+                onlyThese.bonds, onlyThese.angles, onlyThese.dihedrals, displaced, onlyThese.impropers).total;
+            displaced[a][d] = original - h;
+            double minus = BondedInteractions::calculateTotalBondedEnergy(
+                onlyThese.bonds, onlyThese.angles, onlyThese.dihedrals, displaced, onlyThese.impropers).total;
+            displaced[a][d] = original;
+            tracker.add(analytic[d], -(plus - minus) / (2.0 * h));
+        }
+    }
+}
+
+template <typename Real, typename Accum>
+void checkBondedKernels(
+    std::mt19937_64& rng,
+    int numSamples,
+    std::vector<ErrorTracker>& trackers) {
+
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    for (int s = 0; s < numSamples; ++s) {
+        const std::array<std::array<double, 3>, 4> points = randomChain(rng);
+        const double improper = BondedInteractions::calculateImproper(points[1], points[0], points[2], points[3]);
+
+        ChainTerms bond, angle, dihedral, improperTerm;
+        bond.bonds = {{0, 1, 1, 1.2 + 0.6 * uniform(rng), 100.0 + 500.0 * uniform(rng), true}};
+        angle.angles = {{0, 1, 2, 1.6 + 0.6 * uniform(rng), 20.0 + 100.0 * uniform(rng)}};
+        dihedral.dihedrals = {{0, 1, 2, 3, static_cast<double>(1 + s % 4), 0.1 + 5.0 * uniform(rng),
+                               2.0 * PI * uniform(rng)}};
+        // Equilibrium within a radian of the current angle keeps away from the wrap at +/-pi.
+        improperTerm.impropers = {{1, 0, 2, 3, improper + (2.0 * uniform(rng) - 1.0),
+                                   5.0 + 50.0 * uniform(rng)}};
+
+        checkKernelTerm<Real, Accum>(bond.bonds, bond, points, trackers[0]);
+        checkKernelTerm<Real, Accum>(angle.angles, angle, points, trackers[1]);
+        checkKernelTerm<Real, Accum>(dihedral.dihedrals, dihedral, points, trackers[2]);
+        checkKernelTerm<Real, Accum>(improperTerm.impropers, improperTerm, points, trackers[3]);
+    }
+}
+
+// Net force and torque of each bonded term on its own.
+template <typename Term>
+VerificationResult checkTermConservation(
+    const std::string& name,
+    const std::vector<Term>& terms,
+    const PositionArrays<double>& positions,
+    std::vector<double>& fx,
+    std::vector<double>& fy,
+    std::vector<double>& fz,
+    double tolerance) {
+
+    ErrorTracker tracker(name, tolerance);
+    ForceArrays<double> forces = {fx.data(), fy.data(), fz.data()};
+    std::vector<Term> single(1);
+
+    for (const Term& term : terms) {
+        single[0] = term;
+        computeTermForces(single, positions, forces);
+
+        int atoms[4];
+        const int count = termAtoms(term, atoms);
+        double center[3] = {0.0, 0.0, 0.0};
+        for (int a = 0; a < count; ++a) {
+            center[0] += positions.x[atoms[a]] / count;
+            center[1] += positions.y[atoms[a]] / count;
+            center[2] += positions.z[atoms[a]] / count;
+        }
+
+        double net[3] = {0.0, 0.0, 0.0};
+        double torque[3] = {0.0, 0.0, 0.0};
+        double forceScale = 0.0;
+        double torqueScale = 0.0;
+        for (int a = 0; a < count; ++a) {
+            // An atom may appear twice in a degenerate term; take its force once.
+            if (std::find(atoms, atoms + a, atoms[a]) != atoms + a) continue;
+            const int i = atoms[a];
+            const double f[3] = {fx[i], fy[i], fz[i]};
+            const double r[3] = {positions.x[i] - center[0], positions.y[i] - center[1],
+                                 positions.z[i] - center[2]};
+            const double magnitude = std::sqrt(f[0] * f[0] + f[1] * f[1] + f[2] * f[2]);
+            net[0] += f[0];
+            net[1] += f[1];
+            net[2] += f[2];
+            torque[0] += r[1] * f[2] - r[2] * f[1];
+            torque[1] += r[2] * f[0] - r[0] * f[2];
+            torque[2] += r[0] * f[1] - r[1] * f[0];
+            forceScale += magnitude;
+            torqueScale += std::sqrt(r[0] * r[0] + r[1] * r[1] + r[2] * r[2]) * magnitude;
+        }
+        for (int a = 0; a < count; ++a) {
+            fx[atoms[a]] = fy[atoms[a]] = fz[atoms[a]] = 0.0;
+        }
+
+        double netMagnitude = std::sqrt(net[0] * net[0] + net[1] * net[1] + net[2] * net[2]);
+        double torqueMagnitude = std::sqrt(torque[0] * torque[0] + torque[1] * torque[1] + torque[2] * torque[2]);
+        tracker.addScaled(netMagnitude / std::max(forceScale, 1.0));
+        tracker.addScaled(torqueMagnitude / std::max(torqueScale, 1.0));
+    }
+    return tracker.result();
+}
+
+}  // namespace
+
+std::vector<VerificationResult> ForceVerification::checkInteractionGradients(
+    int numSamples,
+    uint64_t seed,
+    double tolerance) {
+
+    if (numSamples < 1) {
+        throw std::runtime_error("Verification needs at least one sample");
+    }
+
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    const double h = 1e-6;
+
+    ErrorTracker bond("bond_force", tolerance);
+    ErrorTracker angle("angle_torque", tolerance);
+    ErrorTracker dihedral("dihedral_torque", tolerance);
+    ErrorTracker improper("improper_torque", tolerance);
+    ErrorTracker lennardJones("lj_force", tolerance);
+    ErrorTracker coulomb("coulomb_force", tolerance);
+
+    for (int s = 0; s < numSamples; ++s) {
+        double p[3] = {0.9 + 0.7 * uniform(rng), 100.0 + 500.0 * uniform(rng), 0.0};
+        double r = 0.8 + 1.4 * uniform(rng);
+        bond.add(BondedInteractions::calculateBondForce(r, p[0], p[1]),
+                 centralDifference(bondEnergy, r, p, h));
+
+        p[0] = 1.5 + 0.7 * uniform(rng);
+        p[1] = 20.0 + 100.0 * uniform(rng);
+        double theta = 0.3 + (PI - 0.6) * uniform(rng);
+        angle.add(BondedInteractions::calculateAngleTorque(theta, p[0], p[1]),
+                  centralDifference(angleEnergy, theta, p, h));
+
+        p[0] = static_cast<double>(1 + s % 4);
+        p[1] = 0.1 + 5.0 * uniform(rng);
+        p[2] = 2.0 * PI * uniform(rng);
+        double phi = PI * (2.0 * uniform(rng) - 1.0);
+        dihedral.add(BondedInteractions::calculateDihedralTorque(phi, p[0], p[1], p[2]),
+                     centralDifference(dihedralEnergy, phi, p, h));
+
+        p[0] = 0.6 * uniform(rng) - 0.3;
+        p[1] = 5.0 + 50.0 * uniform(rng);
+        double psi = p[0] + (2.0 * uniform(rng) - 1.0);
+        improper.add(BondedInteractions::calculateImproperTorque(psi, p[0], p[1]),
+                     centralDifference(improperEnergy, psi, p, h));
+
+        // Pair terms: displace atom 1 along each axis.
+        std::normal_distribution<double> normal(0.0, 1.0);
+        AtomData atom1 = {0, "C", {0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}, 12.011, 6, 0.0};
+        AtomData atom2 = atom1;
+        std::array<double, 3> direction = {normal(rng), normal(rng), normal(rng)};
+        double length = std::sqrt(direction[0] * direction[0] + direction[1] * direction[1] +
+                                  direction[2] * direction[2]);
+        const double sigma = 2.5 + 1.5 * uniform(rng);
+        const double epsilon = 0.05 + 0.45 * uniform(rng);
+        atom1.charge = 2.0 * uniform(rng) - 1.0;
+        atom2.charge = 2.0 * uniform(rng) - 1.0;
+
+        double separation = sigma * (0.85 + 2.15 * uniform(rng));
+        for (int d = 0; d < 3; ++d) {
+            atom2.position[d] = 10.0 * normal(rng);
+            atom1.position[d] = atom2.position[d] + separation * direction[d] / length;
+        }
+        std::array<double, 3> ljGradient = NonbondedInteractions::calculateLJForce(atom1, atom2, sigma, epsilon);
+        std::array<double, 3> coulombGradient = NonbondedInteractions::calculateCoulombForce(atom1, atom2);
+        for (int d = 0; d < 3; ++d) {
+            const double original = atom1.position[d];
+            atom1.position[d] = original + h;
+            double ljPlus = NonbondedInteractions::calculateLennardJones(atom1, atom2, sigma, epsilon);
+            double coulombPlus = NonbondedInteractions::calculateCoulomb(atom1, atom2);
+            atom1.position[d] = original - h;
+            double ljMinus = NonbondedInteractions::calculateLennardJones(atom1, atom2, sigma, epsilon);
+            double coulombMinus = NonbondedInteractions::calculateCoulomb(atom1, atom2);
+            atom1.position[d] = original;
+
+            lennardJones.add(ljGradient[d], (ljPlus - ljMinus) / (2.0 * h));
+            coulomb.add(coulombGradient[d], (coulombPlus - coulombMinus) / (2.0 * h));
+        }
+    }
+
+    std::vector<ErrorTracker> doubleKernels = {
+        {"bond_kernel", tolerance}, {"angle_kernel", tolerance},
+        {"dihedral_kernel", tolerance}, {"improper_kernel", tolerance}};
+    checkBondedKernels<double, double>(rng, numSamples, doubleKernels);
+
+    // Float arithmetic bounds what the mixed kernels can reach.
+    const double mixedTolerance = std::max(tolerance, 1e-4);
+    std::vector<ErrorTracker> mixedKernels = {
+        {"bond_kernel_mixed", mixedTolerance}, {"angle_kernel_mixed", mixedTolerance},
+        {"dihedral_kernel_mixed", mixedTolerance}, {"improper_kernel_mixed", mixedTolerance}};
+    checkBondedKernels<float, double>(rng, numSamples, mixedKernels);
+
+    std::vector<VerificationResult> results = {
+        bond.result(), angle.result(), dihedral.result(), improper.result(),
+        lennardJones.result(), coulomb.result()};
+    for (const auto& tracker : doubleKernels) results.push_back(tracker.result());
+    for (const auto& tracker : mixedKernels) results.push_back(tracker.result());
+    return results;
+}
+
+VerificationResult ForceVerification::checkPairTable(
+    const PairTable& table,
+    int numSamples,
+    uint64_t seed,
+    double tolerance) {
+
+    if (table.getNumIntervals() == 0) {
+        throw std::runtime_error("Pair table is empty");
+    }
+
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    ErrorTracker tracker("pair_table_force", tolerance);
+    const double h = 1e-6;
+    const double inner = table.getInnerDistance();
+    const double outer = table.getCutoffDistance() - 2.0 * h;
+
+    for (int s = 0; s < numSamples; ++s) {
+        double r = inner + (outer - inner) * uniform(rng);
+        double plus = table.evaluate((r + h) * (r + h))[0];
+        double minus = table.evaluate((r - h) * (r - h))[0];
+        tracker.add(table.evaluate(r * r)[1], -(plus - minus) / (2.0 * h) / r);
+    }
+    return tracker.result();
+}
+
+VerificationResult ForceVerification::checkSystemForces(
+    const System& system,
+    PrecisionMode mode,
+    double step,
+    int maxAtoms,
+    double tolerance) {
+
+    if (step <= 0.0) {
+        throw std::runtime_error("Finite difference step must be positive");
+    }
+
+    System probe = system;
+    probe.computeForces(mode);
+    ParticleArrays& particles = probe.getParticles();
+    const std::vector<double> fx = particles.fx;
+    const std::vector<double> fy = particles.fy;
+    const std::vector<double> fz = particles.fz;
+
+    const int numAtoms = static_cast<int>(particles.size());
+    const int numChecked = maxAtoms > 0 ? std::min(maxAtoms, numAtoms) : numAtoms;
+    ErrorTracker tracker("system_forces", tolerance);
+
+    for (int c = 0; c < numChecked; ++c) {
+        const int i = static_cast<int>(static_cast<long long>(c) * numAtoms / numChecked);
+        std::vector<double>* coordinates[3] = {&particles.x, &particles.y, &particles.z};
+        const double analytic[3] = {fx[i], fy[i], fz[i]};
+
+        for (int d = 0; d < 3; ++d) {
+            double& value = (*coordinates[d])[i];
+            const double original = value;
+
+            value = original + step;
+            probe.markPositionsChanged();
+            double plus = probe.computeForces(PrecisionMode::Double).potential;
+
+            value = original - step;
+            probe.markPositionsChanged();
+            double minus = probe.computeForces(PrecisionMode::Double).potential;
+
+            value = original;
+            probe.markPositionsChanged();
+            tracker.add(analytic[d], -(plus - minus) / (2.0 * step));
+        }
+    }
+    return tracker.result();
+}
+
+std::vector<VerificationResult> ForceVerification::checkConservation(
+    const System& system,
+    double tolerance) {
+
+    System probe = system;
+    probe.computeForces(PrecisionMode::Double);
+    const ParticleArrays& particles = probe.getParticles();
+    const size_t numAtoms = particles.size();
+    const std::array<double, 3>& box = probe.getBoxLength();
+    const bool periodic = box[0] > 0.0 && box[1] > 0.0 && box[2] > 0.0;
+
+    double center[3] = {0.0, 0.0, 0.0};
+    for (size_t i = 0; i < numAtoms; ++i) {
+        center[0] += particles.x[i] / numAtoms;
+        center[1] += particles.y[i] / numAtoms;
+        center[2] += particles.z[i] / numAtoms;
+    }
+
+    double net[3] = {0.0, 0.0, 0.0};
+    double torque[3] = {0.0, 0.0, 0.0};
+    double forceScale = 0.0;
+    double torqueScale = 0.0;
+    for (size_t i = 0; i < numAtoms; ++i) {
+        const double f[3] = {particles.fx[i], particles.fy[i], particles.fz[i]};
+        const double r[3] = {particles.x[i] - center[0], particles.y[i] - center[1], particles.z[i] - center[2]};
+        const double magnitude = std::sqrt(f[0] * f[0] + f[1] * f[1] + f[2] * f[2]);
+        net[0] += f[0];
+        net[1] += f[1];
+        net[2] += f[2];
+        torque[0] += r[1] * f[2] - r[2] * f[1];
+        torque[1] += r[2] * f[0] - r[0] * f[2];
+        torque[2] += r[0] * f[1] - r[1] * f[0];
+        forceScale += magnitude;
+        torqueScale += std::sqrt(r[0] * r[0] + r[1] * r[1] + r[2] * r[2]) * magnitude;
+    }
+
+    std::vector<VerificationResult> results;
+    ErrorTracker netForce("net_force", tolerance);
+    netForce.addScaled(std::sqrt(net[0] * net[0] + net[1] * net[1] + net[2] * net[2]) /
+                       std::max(forceScale, 1.0));
+    results.push_back(netForce.result());
+
+    ErrorTracker netTorque("net_torque", tolerance);
+    if (!periodic) {
+        netTorque.addScaled(std::sqrt(torque[0] * torque[0] + torque[1] * torque[1] + torque[2] * torque[2]) /
+                            std::max(torqueScale, 1.0));
+    }
+    results.push_back(netTorque.result());
+
+    const PositionArrays<double> positions = {
+        particles.x.data(), particles.y.data(), particles.z.data(), numAtoms};
+    std::vector<double> fx(numAtoms, 0.0), fy(numAtoms, 0.0), fz(numAtoms, 0.0);
+    const TopologyData& topology = probe.getTopology();
+    results.push_back(checkTermConservation("bond_conservation", topology.bonds, positions, fx, fy, fz, tolerance));
+    results.push_back(checkTermConservation("angle_conservation", topology.angles, positions, fx, fy, fz, tolerance));
+    results.push_back(checkTermConservation("dihedral_conservation", topology.dihedrals, positions, fx, fy, fz, tolerance));
+    results.push_back(checkTermConservation("improper_conservation", topology.impropers, positions, fx, fy, fz, tolerance));
+    return results;
+}
+
+EnergyDriftResult ForceVerification::checkEnergyDrift(
+    const System& system,
+    int numSteps,
+    double timestep,
+    int sampleInterval,
+    double tolerance) {
+
+    if (numSteps < 1 || timestep <= 0.0 || sampleInterval < 1) {
+        throw std::runtime_error("Energy drift check needs positive steps, timestep and sample interval");
+    }
+    if (system.getNumAtoms() == 0) {
+        throw std::runtime_error("Energy drift check needs a system with atoms");
+    }
+
+    System probe = system;
+    const double initialEnergy = probe.computeForces().total;
+
+    // Least-squares slope of E(t), accumulated around the first sample.
+    double sumT = 0.0, sumE = 0.0, sumTT = 0.0, sumTE = 0.0;
+    int numSamples = 1;
+    double maxDeviation = 0.0;
+
+    for (int done = 0; done < numSteps; done += sampleInterval) {
+        int chunk = std::min(sampleInterval, numSteps - done);
+        double energy = probe.step(chunk, timestep).total - initialEnergy;
+        double time = (done + chunk) * timestep;
+
+        maxDeviation = std::max(maxDeviation, std::abs(energy));
+        sumT += time;
+        sumE += energy;
+        sumTT += time * time;
+        sumTE += time * energy;
+        ++numSamples;
+    }
+
+    const double meanT = sumT / numSamples;
+    const double meanE = sumE / numSamples;
+    const double variance = sumTT / numSamples - meanT * meanT;
+    const double slope = variance > 0.0 ? (sumTE / numSamples - meanT * meanE) / variance : 0.0;
+    const double drift = slope * 1000.0 / static_cast<double>(probe.getNumAtoms());
+
+    return {numSteps, timestep, initialEnergy, maxDeviation, drift, tolerance,
+            std::abs(drift) <= tolerance};
+}
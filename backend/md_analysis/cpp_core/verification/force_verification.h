@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "pair_table.h"
+#include "precision.h"
+#include "system.h"
+
+// Outcome of one family of checks. Errors are |analytic - reference| over
+// max(|reference|, 1), so large forces are compared relatively and forces
+// near zero absolutely.
+struct VerificationResult {
+    std::string name;
+    int numChecks;
+    double maxError;
+    double tolerance;
+    bool passed;
+};
+
+struct EnergyDriftResult {
+    int numSteps;
+    double timestep;
+    double initialEnergy;
+    // Largest |E(t) - E(0)| seen at the sampled steps, in kcal/mol.
+    double maxDeviation;
+    // Slope of a least-squares line through E(t), in kcal/mol per ps per atom.
+    double driftPerAtomPerPs;
+    double tolerance;
+    bool passed;
+};
+
+// Offline checks of energies against their analytic derivatives, meant to
+// validate new or optimized kernels without asserts in the force loops.
+// Every check works on copies and leaves its inputs untouched.
+class ForceVerification {
+public:
+
+    // Central finite differences of the BondedInteractions and
+    // NonbondedInteractions energy functions against their derivative
+    // functions (bond force, angle/dihedral/improper torques, LJ and
+    // Coulomb forces), and of calculateTotalBondedEnergy against the
+    // Cartesian forces of the bonded kernels in double and mixed precision,
+    // at numSamples random geometries each.
+    static std::vector<VerificationResult> checkInteractionGradients(
+        int numSamples = 200,
+        uint64_t seed = 1,
+        double tolerance = 1e-6);
+
+    // -dU/dr / r returned by the table against finite differences of its own energy.
+    static VerificationResult checkPairTable(
+        const PairTable& table,
+        int numSamples = 1000,
+        uint64_t seed = 1,
+        double tolerance = 1e-6);
+
+    // System forces computed in the given precision against central
+    // differences of the double-precision potential energy. maxAtoms > 0
+    // checks an evenly spaced subset of atoms.
+    static VerificationResult checkSystemForces(
+        const System& system,
+        PrecisionMode mode = PrecisionMode::Double,
+        double step = 1e-4,
+        int maxAtoms = 0,
+        double tolerance = 1e-4);
+
+    // Net force and net torque of the whole system, and of every bonded
+    // term evaluated on its own, scaled by the summed force magnitudes.
+    // Torques are skipped for periodic systems, where the minimum image
+    // convention does not conserve angular momentum.
+    static std::vector<VerificationResult> checkConservation(
+        const System& system,
+        double tolerance = 1e-9);
+
+    // Runs a copy of the system for numSteps of velocity Verlet, sampling
+    // the total energy every sampleInterval steps.
+    static EnergyDriftResult checkEnergyDrift(
+        const System& system,
+        int numSteps,
+        double timestep,
+        int sampleInterval = 10,
+        double tolerance = 1e-3);
+};
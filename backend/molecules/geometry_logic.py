@@ -1,5 +1,9 @@
 import numpy as np
 
+# Checks every Dihedral.forces result for zero net force. Off by default,
+# since it runs on every evaluation; turn it on when debugging the forces.
+CHECK_FORCE_CONSERVATION = False
+
 class Angle:
 
     def __init__(self, atom_1, atom_2, atom_3, params):
@@ -120,8 +124,9 @@ class Dihedral:
         force_on_2 = -force_on_1 + alpha * self.b2
         force_on_3 = -force_on_4 - alpha * self.b2
 
-        total_force = force_on_1 + force_on_2 + force_on_3 + force_on_4
-        assert np.allclose(total_force, 0, atol=1e-10), "Conservation Law Violated! Oh No"
+        if CHECK_FORCE_CONSERVATION:
+            total_force = force_on_1 + force_on_2 + force_on_3 + force_on_4
+            assert np.allclose(total_force, 0, atol=1e-10), "Conservation Law Violated! Oh No"
 
         return {
             self.atom_1: force_on_1,
@@ -53,13 +53,10 @@ class Molecule(object):
         self.atoms = atoms
         self.bonds = bonds
 
-        self.adjacency_list = {}
-        for atom in atoms: 
-            adjacent_atoms = []
-            for bond in bonds: 
-                if bond.atom_1 == atom or bond.atom_2 == atom: 
-                    adjacent_atoms.append(bond.atom_2 if bond.atom_1 == atom else bond.atom_1)
-            self.adjacency_list[atom] = adjacent_atoms
+        self.adjacency_list = {atom: [] for atom in atoms}
+        for bond in bonds: 
+            self.adjacency_list[bond.atom_1].append(bond.atom_2)
+            self.adjacency_list[bond.atom_2].append(bond.atom_1)
 
         self.masses = []
         for atom in atoms: 